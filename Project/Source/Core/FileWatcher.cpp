@@ -0,0 +1,171 @@
+/* All content(c) 2017 - 2018 DigiPen(USA) Corporation, all rights reserved. */
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+#include "FileWatcher.h"
+
+FileWatcher::FileWatcher() : _stopping(false)
+{}
+
+FileWatcher::~FileWatcher()
+{
+  Stop();
+}
+
+/*****************************************************************************/
+/*!
+\brief
+  Starts watching a directory. A watcher that is already running is stopped
+  first.
+
+\param directory
+  The directory that will be watched. Subdirectories are not watched.
+*/
+/*****************************************************************************/
+void FileWatcher::Start(const std::string & directory)
+{
+  Stop();
+  _directory = directory;
+  _stopping = false;
+  _thread = std::thread(&FileWatcher::WatchLoop, this);
+}
+
+void FileWatcher::Stop()
+{
+  if (!_thread.joinable())
+    return;
+  _stopping = true;
+  _thread.join();
+}
+
+/*****************************************************************************/
+/*!
+\brief
+  Takes the names of the files that changed and have settled since the last
+  time changes were taken. Files that are still being written are kept until
+  a later call.
+
+\param changes
+  The names of the changed files are added to this. The names are relative
+  to the watched directory.
+*/
+/*****************************************************************************/
+void FileWatcher::TakeChanges(std::vector<std::string> * changes)
+{
+  std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+  std::chrono::milliseconds settle(FILEWATCHER_SETTLE_MS);
+  std::lock_guard<std::mutex> lock(_changesMutex);
+  std::unordered_map<std::string,
+    std::chrono::steady_clock::time_point>::iterator it = _changes.begin();
+  while (it != _changes.end()) {
+    if (now - it->second < settle) {
+      ++it;
+      continue;
+    }
+    changes->push_back(it->first);
+    it = _changes.erase(it);
+  }
+}
+
+void FileWatcher::AddChange(const std::string & filename)
+{
+  std::lock_guard<std::mutex> lock(_changesMutex);
+  _changes[filename] = std::chrono::steady_clock::now();
+}
+
+#ifdef _WIN32
+
+void FileWatcher::WatchLoop()
+{
+  HANDLE directory = CreateFileA(_directory.c_str(), FILE_LIST_DIRECTORY,
+    FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr,
+    OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, nullptr);
+  if (directory == INVALID_HANDLE_VALUE)
+    return;
+  OVERLAPPED overlapped = {};
+  overlapped.hEvent = CreateEvent(nullptr, TRUE, FALSE, nullptr);
+  // ReadDirectoryChangesW needs a dword aligned buffer
+  DWORD buffer[1024];
+  DWORD filter = FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_FILE_NAME;
+  while (!_stopping) {
+    ResetEvent(overlapped.hEvent);
+    if (!ReadDirectoryChangesW(directory, buffer, sizeof(buffer), FALSE,
+      filter, nullptr, &overlapped, nullptr))
+      break;
+    // wait with a timeout so a stop request is noticed
+    DWORD wait = WAIT_TIMEOUT;
+    while (!_stopping && wait == WAIT_TIMEOUT)
+      wait = WaitForSingleObject(overlapped.hEvent, FILEWATCHER_POLL_MS);
+    DWORD bytes = 0;
+    if (_stopping) {
+      // the buffer can't be released until the cancelled read is done
+      CancelIo(directory);
+      GetOverlappedResult(directory, &overlapped, &bytes, TRUE);
+      break;
+    }
+    GetOverlappedResult(directory, &overlapped, &bytes, FALSE);
+    // zero bytes means there were too many changes to fit in the buffer
+    if (bytes == 0)
+      continue;
+    const char * entry = (const char *)buffer;
+    while (true) {
+      const FILE_NOTIFY_INFORMATION * info =
+        (const FILE_NOTIFY_INFORMATION *)entry;
+      int wide_length = (int)(info->FileNameLength / sizeof(WCHAR));
+      int length = WideCharToMultiByte(CP_UTF8, 0, info->FileName,
+        wide_length, nullptr, 0, nullptr, nullptr);
+      std::string filename(length, '\0');
+      WideCharToMultiByte(CP_UTF8, 0, info->FileName, wide_length,
+        &filename[0], length, nullptr, nullptr);
+      if (info->Action != FILE_ACTION_REMOVED &&
+        info->Action != FILE_ACTION_RENAMED_OLD_NAME)
+        AddChange(filename);
+      if (info->NextEntryOffset == 0)
+        break;
+      entry += info->NextEntryOffset;
+    }
+  }
+  CloseHandle(overlapped.hEvent);
+  CloseHandle(directory);
+}
+
+#else
+
+void FileWatcher::WatchLoop()
+{
+  int inotify = inotify_init1(IN_NONBLOCK);
+  if (inotify < 0)
+    return;
+  int watch = inotify_add_watch(inotify, _directory.c_str(),
+    IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE);
+  if (watch < 0) {
+    close(inotify);
+    return;
+  }
+  alignas(inotify_event) char buffer[4096];
+  while (!_stopping) {
+    // wait with a timeout so a stop request is noticed
+    pollfd poll_fd = { inotify, POLLIN, 0 };
+    if (poll(&poll_fd, 1, FILEWATCHER_POLL_MS) <= 0)
+      continue;
+    ssize_t length = read(inotify, buffer, sizeof(buffer));
+    const char * entry = buffer;
+    while (length > 0 && entry < buffer + length) {
+      const inotify_event * event = (const inotify_event *)entry;
+      if (event->len > 0)
+        AddChange(event->name);
+      entry += sizeof(inotify_event) + event->len;
+    }
+  }
+  inotify_rm_watch(inotify, watch);
+  close(inotify);
+}
+
+#endif
@@ -0,0 +1,51 @@
+/* All content(c) 2017 - 2018 DigiPen(USA) Corporation, all rights reserved. */
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// How long the watching thread waits for changes before checking whether it
+// should stop
+#define FILEWATCHER_POLL_MS 100
+// Editors often write a file more than once when saving. A change is only
+// reported once the file has not changed for this long.
+#define FILEWATCHER_SETTLE_MS 100
+
+/*****************************************************************************/
+/*!
+\class FileWatcher
+\brief
+  Watches a directory on a background thread and records the names of the
+  files in it that are written, created, or renamed. The changes are taken
+  on the main thread whenever it is convenient. ReadDirectoryChangesW is used
+  on Windows and inotify is used on Linux.
+*/
+/*****************************************************************************/
+class FileWatcher
+{
+public:
+  FileWatcher();
+  ~FileWatcher();
+  void Start(const std::string & directory);
+  void Stop();
+  void TakeChanges(std::vector<std::string> * changes);
+private:
+  void WatchLoop();
+  void AddChange(const std::string & filename);
+  //! The directory being watched
+  std::string _directory;
+  //! The thread that waits for changes
+  std::thread _thread;
+  //! Set when the watching thread should exit
+  std::atomic<bool> _stopping;
+  //! Guards the changes
+  std::mutex _changesMutex;
+  //! The files that changed and the last time each of them changed
+  std::unordered_map<std::string,
+    std::chrono::steady_clock::time_point> _changes;
+};
@@ -0,0 +1,155 @@
+/* All content(c) 2017 - 2018 DigiPen(USA) Corporation, all rights reserved. */
+#include <atomic>
+#include <memory>
+
+#include "ThreadPool.h"
+
+// static initializations
+std::vector<std::thread> ThreadPool::_workers;
+std::deque<std::function<void()> > ThreadPool::_jobs;
+std::mutex ThreadPool::_jobsMutex;
+std::condition_variable ThreadPool::_jobsCondition;
+bool ThreadPool::_stopping = false;
+
+/*****************************************************************************/
+/*!
+\brief
+  Starts the worker threads.
+
+\param worker_count
+  The number of workers to start. When zero, one less than the number of
+  hardware threads is used so the main thread keeps a core to itself.
+*/
+/*****************************************************************************/
+void ThreadPool::Initialize(unsigned int worker_count)
+{
+  if (worker_count == 0) {
+    unsigned int hardware_threads = std::thread::hardware_concurrency();
+    worker_count = hardware_threads > 1 ? hardware_threads - 1 : 1;
+  }
+  _stopping = false;
+  _workers.reserve(worker_count);
+  for (unsigned int i = 0; i < worker_count; ++i)
+    _workers.push_back(std::thread(WorkerLoop));
+}
+
+/*****************************************************************************/
+/*!
+\brief
+  Finishes every job that is still queued and then joins the workers.
+*/
+/*****************************************************************************/
+void ThreadPool::Purge()
+{
+  {
+    std::lock_guard<std::mutex> lock(_jobsMutex);
+    _stopping = true;
+  }
+  _jobsCondition.notify_all();
+  for (std::thread & worker : _workers)
+    worker.join();
+  _workers.clear();
+}
+
+/*****************************************************************************/
+/*!
+\brief
+  Queues a job that will be run by the next available worker.
+
+\param job
+  The job to run.
+*/
+/*****************************************************************************/
+void ThreadPool::Submit(const std::function<void()> & job)
+{
+  {
+    std::lock_guard<std::mutex> lock(_jobsMutex);
+    _jobs.push_back(job);
+  }
+  _jobsCondition.notify_one();
+}
+
+/*****************************************************************************/
+/*!
+\brief
+  Calls job once for every index in [0, count) and returns when all of the
+  calls are complete. The calling thread takes indices as well, so this
+  never waits on workers that are busy with other jobs.
+
+\param count
+  The number of indices.
+\param job
+  The function called with each index.
+*/
+/*****************************************************************************/
+void ThreadPool::ParallelFor(unsigned int count,
+  const std::function<void(unsigned int)> & job)
+{
+  if (count == 0)
+    return;
+  // Shared with helper jobs that may start after this function returns.
+  // Those find no indices left and exit without touching the job.
+  struct State
+  {
+    std::atomic<unsigned int> _next;
+    std::atomic<unsigned int> _completed;
+    std::mutex _mutex;
+    std::condition_variable _done;
+  };
+  std::shared_ptr<State> state = std::make_shared<State>();
+  state->_next = 0;
+  state->_completed = 0;
+  const std::function<void(unsigned int)> * job_pointer = &job;
+  auto run = [state, count, job_pointer]()
+  {
+    unsigned int index = state->_next++;
+    while (index < count) {
+      (*job_pointer)(index);
+      if (++state->_completed == count) {
+        std::lock_guard<std::mutex> lock(state->_mutex);
+        state->_done.notify_all();
+      }
+      index = state->_next++;
+    }
+  };
+  unsigned int helpers = (unsigned int)_workers.size();
+  if (helpers > count - 1)
+    helpers = count - 1;
+  for (unsigned int i = 0; i < helpers; ++i)
+    Submit(run);
+  run();
+  std::unique_lock<std::mutex> lock(state->_mutex);
+  state->_done.wait(lock, [&state, count]()
+    { return state->_completed == count; });
+}
+
+/*****************************************************************************/
+/*!
+\brief
+  Gets the number of worker threads, not including the main thread.
+
+\return The number of workers.
+*/
+/*****************************************************************************/
+unsigned int ThreadPool::WorkerCount()
+{
+  return (unsigned int)_workers.size();
+}
+
+// Runs jobs until the pool is stopping and the queue is empty.
+void ThreadPool::WorkerLoop()
+{
+  while (true)
+  {
+    std::function<void()> job;
+    {
+      std::unique_lock<std::mutex> lock(_jobsMutex);
+      _jobsCondition.wait(lock, []() { return _stopping || !_jobs.empty(); });
+      if (_jobs.empty())
+        return;
+      job = _jobs.front();
+      _jobs.pop_front();
+    }
+    job();
+  }
+}
@@ -0,0 +1,45 @@
+/* All content(c) 2017 - 2018 DigiPen(USA) Corporation, all rights reserved. */
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/*****************************************************************************/
+/*!
+\class ThreadPool
+\brief
+  Static class that owns a set of worker threads. Jobs can either be submitted
+  to run in the background or a loop can be split across the workers and the
+  calling thread with ParallelFor.
+
+\par Important Notes
+  - Jobs must not touch OpenGL. The context only belongs to the main thread.
+*/
+/*****************************************************************************/
+class ThreadPool
+{
+public:
+  static void Initialize(unsigned int worker_count = 0);
+  static void Purge();
+  static void Submit(const std::function<void()> & job);
+  static void ParallelFor(unsigned int count,
+    const std::function<void(unsigned int)> & job);
+  static unsigned int WorkerCount();
+private:
+  ThreadPool() {}
+  static void WorkerLoop();
+  //! The worker threads
+  static std::vector<std::thread> _workers;
+  //! Jobs that have been submitted but not started
+  static std::deque<std::function<void()> > _jobs;
+  //! Guards the job queue and the stopping flag
+  static std::mutex _jobsMutex;
+  //! Wakes workers when a job is submitted or the pool is stopping
+  static std::condition_variable _jobsCondition;
+  //! Set when the workers should exit
+  static bool _stopping;
+};
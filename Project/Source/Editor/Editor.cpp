@@ -1,7 +1,16 @@
 /* All content(c) 2017 - 2018 DigiPen(USA) Corporation, all rights reserved. */
+#include <cstdlib>
 #include "../External/Imgui/imgui.h"
 #include "../External/Imgui/imgui_impl_sdl_gl3.h"
 #include "../Graphics/SDLContext.h"
+#include "../Graphics/OpenGLContext.h"
+#include "../Graphics/Renderer.h"
+#include "../Graphics/LightCluster.h"
+#include "../Graphics/RenderTargetPool.h"
+#include "../Graphics/Shader/ShaderCache.h"
+#include "../Graphics/Texture/ImageDecoder.h"
+#include "../Graphics/Texture/MipGenerator.h"
+#include "../Graphics/Texture/TextureCompressor.h"
 #include "../Core/Framer.h"
 #include "../Core/Time.h"
 #include "../Core/Input.h"
@@ -20,6 +29,7 @@ std::string Editor::_currentTextureNormal(NORMALPRESET);
 std::string Editor::current_mesh(MESHPRESET);
 char Editor::next_mesh[FILENAME_BUFFERSIZE] = MESHPRESET;
 Light Editor::lights[MAXLIGHTS];
+int Editor::stress_lights = 2048;
 unsigned int Editor::active_lights = 2;
 MeshRenderer::ShaderType Editor::shader_in_use = MeshRenderer::PHONG;
 std::string Editor::error_log;
@@ -87,8 +97,11 @@ void Editor::Update(Mesh * mesh, MeshRenderer::MeshObject * mesh_object,
     ImGui::Separator();
     if (ImGui::TreeNode("Editor Tabs")) {
       ImGui::Separator();
-      ImGui::TextWrapped("The Debug tab only contains the average FPS and "
-        "average frame usage over a single second.");
+      ImGui::TextWrapped("The Debug tab contains the average FPS and "
+        "average frame usage over a single second. It also shows how much "
+        "gpu time each part of the frame takes, how many objects each "
+        "pass culled against its view frustum, and how long it took to bin "
+        "the lights into clusters.");
       ImGui::Separator();
       ImGui::TextWrapped("The Global tab contains parameters for "
         "adjusting global colors (Emissive/Global Ambient/Fog), fog near/far "
@@ -99,11 +112,21 @@ void Editor::Update(Mesh * mesh, MeshRenderer::MeshObject * mesh_object,
         "camera option. When rotating the camera after disabling this "
         "option, the camera might get flipped around");
       ImGui::Separator();
+      ImGui::TextWrapped("The Environment tab controls how often the "
+        "environment used for reflections and refractions is rendered. It "
+        "also allows rough reflections to use an environment that is "
+        "prefiltered over multiple frames.");
+      ImGui::Separator();
       ImGui::TextWrapped("The Mesh tab allows you to edit mesh properites, "
         "display normal lines, and load new meshes.");
       ImGui::Separator();
       ImGui::TextWrapped("The Shader tab contains an option for swapping out "
-        "the shader that is used for rendering.");
+        "the shader that is used for rendering. It also switches between "
+        "phong variants that have the material's features compiled in and "
+        "the phong shader that branches on material uniforms, and can time "
+        "both to compare their cost. Phong, gouraud, and blinn are rebuilt "
+        "when their files are saved and the new shader replaces the old one "
+        "once it has compiled.");
       ImGui::Separator();
       ImGui::TextWrapped("The Material and Light Editor checkboxes will open "
         "new ImGui windows for editing material and light properties when "
@@ -114,9 +137,11 @@ void Editor::Update(Mesh * mesh, MeshRenderer::MeshObject * mesh_object,
     if (ImGui::TreeNode("Light Editor")) {
       ImGui::Separator();
       ImGui::TextWrapped("You can add, remove and adjust light properties in "
-        "the light editor. The Scene tab at the top contains the two presets "
+        "the light editor. The Scene tab at the top contains the presets "
         "for lighting the scene and the option to rotate the lights around "
-        "the model.");
+        "the model. The Stress preset fills the scene with many small lights "
+        "to test the clustered lighting used by the phong and blinn "
+        "shaders.");
       ImGui::TreePop();
     }
 
@@ -127,6 +152,158 @@ void Editor::Update(Mesh * mesh, MeshRenderer::MeshObject * mesh_object,
     ImGui::Text("Average FPS: %f", Framer::AverageFPS());
     ImGui::Text("Average Frame Usage: %f", Framer::AverageFrameUsage() * 100.0f);
     ImGui::Separator();
+    ImGui::Text("Gpu Times");
+    ImGui::Text("Environment: %f ms",
+      Renderer::_environmentTimer.Milliseconds());
+    ImGui::Text("Prefilter: %f ms", Renderer::_prefilterTimer.Milliseconds());
+    float skybox_time = Renderer::_skyboxTimer.Milliseconds();
+    ImGui::Text("Skybox: %f ms", skybox_time);
+    // the skybox covers the whole screen, so its time shows fragment throughput
+    if (skybox_time > 0.0f) {
+      float pixels = (float)(OpenGLContext::Width() * OpenGLContext::Height());
+      ImGui::Text("Skybox Fill Rate: %f MPixels/s",
+        pixels / (skybox_time * 1000.0f));
+    }
+    ImGui::Text("Mesh: %f ms", Renderer::_meshTimer.Milliseconds());
+    ImGui::Separator();
+    ImGui::Text("Frame Graph Passes");
+    for (const FrameGraph::PassStats & stats :
+      Renderer::_frameGraph._passStats) {
+      if (stats._culled)
+        ImGui::Text("%s: culled", stats._name.c_str());
+      else
+        ImGui::Text("%s: %f ms cpu, %f ms gpu", stats._name.c_str(),
+          stats._cpuMilliseconds, stats._gpuMilliseconds);
+    }
+    ImGui::Text("Clears: %d", Renderer::_frameGraph._clears);
+    ImGui::Separator();
+    ImGui::Text("Render Queue");
+    ImGui::Text("Draws: %u", Renderer::_renderQueue.Size());
+    ImGui::Text("Program Changes: %d", Renderer::_renderQueue._programChanges);
+    ImGui::Text("Material Changes: %d",
+      Renderer::_renderQueue._materialChanges);
+    ImGui::Text("Vertex Array Changes: %d",
+      Renderer::_renderQueue._vaoChanges);
+    ImGui::DragInt("Benchmark Draws", &Renderer::_queueBenchmarkDraws, 100.0f,
+      1, 1000000);
+    if (ImGui::Button("Benchmark Render Queue"))
+      Renderer::BenchmarkRenderQueue();
+    ImGui::Text("Sort: %f ms", Renderer::_queueSortMilliseconds);
+    ImGui::Text("Sorted Submit: %f ms (%d state changes)",
+      Renderer::_queueSubmitMilliseconds, Renderer::_queueStateChanges);
+    ImGui::Text("Unsorted Submit: %f ms (%d state changes)",
+      Renderer::_unsortedSubmitMilliseconds, Renderer::_unsortedStateChanges);
+    ImGui::Separator();
+    ImGui::Checkbox("Frustum Culling", &Renderer::_frustumCulling);
+    ImGui::Text("Culled Objects");
+    const char * pass_names[RENDER_PASSES] =
+      { "Right", "Left", "Up", "Down", "Back", "Front", "Main" };
+    for (int i = 0; i < RENDER_PASSES; ++i) {
+      ImGui::Text("%s: %d / %d", pass_names[i], Renderer::_culledObjects[i],
+        Renderer::_testedObjects[i]);
+    }
+    ImGui::Separator();
+    ImGui::Text("Light Clusters");
+    ImGui::Checkbox("Parallel Binning", &LightCluster::_parallel);
+    ImGui::Text("Bin: %f ms", LightCluster::_binMilliseconds);
+    ImGui::Text("Upload: %f ms", LightCluster::_uploadMilliseconds);
+    ImGui::Text("Light Indices: %d", LightCluster::_indexCount);
+    ImGui::Text("Most Lights In A Cluster: %d",
+      LightCluster::_maxClusterLights);
+    ImGui::Text("Dropped Lights: %d", LightCluster::_droppedLights);
+    ImGui::Separator();
+    // all of the shaders are created at startup, so the build time shows the
+    // difference between a cold and a warm start
+    ImGui::Text("Shader Cache");
+    if (!ShaderCache::Supported())
+      ImGui::Text("Program binaries are not supported.");
+    ImGui::Text("Restored Programs: %d", ShaderCache::_hits);
+    ImGui::Text("Compiled Programs: %d", ShaderCache::_misses);
+    ImGui::Text("Build Time: %f ms", ShaderCache::_buildMilliseconds);
+    ImGui::Text("Files Read: %d", Shader::_fileReads);
+    ImGui::Text("Cached File Reads: %d", Shader::_fileCacheHits);
+    if (ImGui::Button("Clear Shader Cache"))
+      ShaderCache::Clear();
+    ImGui::Separator();
+    ImGui::Text("Render Targets");
+    ImGui::DragInt("Unused Frames", &RenderTargetPool::_unusedFrames, 1.0f,
+      0, 6000);
+    ImGui::Text("Resident: %d targets, %f MB",
+      RenderTargetPool::_residentTargets,
+      (float)RenderTargetPool::_residentBytes / (1024.0f * 1024.0f));
+    ImGui::Text("Requested Last Frame: %f MB",
+      (float)RenderTargetPool::_requestedBytes / (1024.0f * 1024.0f));
+    ImGui::Text("Created: %d Deleted: %d", RenderTargetPool::_creations,
+      RenderTargetPool::_deletions);
+    for (const RenderTargetPool::PassUsage & usage :
+      RenderTargetPool::_passUsage) {
+      ImGui::Text("%s: %f MB, %d targets (%d shared)", usage._pass.c_str(),
+        (float)usage._bytes / (1024.0f * 1024.0f), usage._targets,
+        usage._aliased);
+    }
+    ImGui::Separator();
+    ImGui::Text("Textures");
+    int budget_kb = TexturePool::_uploadBudget / 1024;
+    if (ImGui::DragInt("Upload Budget (KB)", &budget_kb, 64.0f, 64, 65536))
+      TexturePool::_uploadBudget = budget_kb * 1024;
+    int memory_mb = TexturePool::_memoryBudget / (1024 * 1024);
+    if (ImGui::DragInt("Memory Budget (MB)", &memory_mb, 1.0f, 0, 2047))
+      TexturePool::_memoryBudget = memory_mb * 1024 * 1024;
+    ImGui::Text("Resident: %d textures, %f MB",
+      TexturePool::_residentTextures,
+      (float)TexturePool::_residentBytes / (1024.0f * 1024.0f));
+    ImGui::Text("Unused Cached: %f MB",
+      (float)TexturePool::_unusedBytes / (1024.0f * 1024.0f));
+    ImGui::Text("Cache Hits: %d", TexturePool::_cacheHits);
+    ImGui::Text("Evictions: %d", TexturePool::_evictions);
+    ImGui::Text("Pending Requests: %d", TexturePool::PendingRequests());
+    ImGui::Text("Binds Per Frame: %d", TexturePool::_frameBinds);
+    // the filter and compression only apply to images made after they are
+    // changed
+    int filter = MipGenerator::_filter;
+    if (ImGui::Combo("Mip Filter", &filter, "Box\0Lanczos\0Kaiser\0\0"))
+      MipGenerator::_filter = (MipGenerator::Filter)filter;
+    ImGui::Text("Mip Generation: %f ms, %lld pixels",
+      MipGenerator::_milliseconds, MipGenerator::_pixels);
+    ImGui::Checkbox("Compress Textures", &TextureCompressor::_enabled);
+    if (!TextureCompressor::Supported() && TextureCompressor::_enabled)
+      ImGui::Text("Block compression is not supported.");
+    ImGui::Text("Compressed Images: %d cached, %d encoded",
+      TextureCompressor::_hits, TextureCompressor::_misses);
+    ImGui::Text("Encode Throughput: %f MPixels/s",
+      TextureCompressor::Throughput());
+    ImGui::Text("Encode PSNR: %f dB", TextureCompressor::PSNR());
+    ImGui::Text("Compressed Uploads: %f MB (%f MB uncompressed)",
+      (float)TextureCompressor::_compressedBytes / (1024.0f * 1024.0f),
+      (float)TextureCompressor::_rawBytes / (1024.0f * 1024.0f));
+    ImGui::Text("Upload Time: %f ms", TexturePool::_uploadMilliseconds);
+    ImGui::Text("Load Time: %f ms", TexturePool::_loadMilliseconds);
+    if (ImGui::Button("Benchmark Skybox Loading"))
+      Renderer::BenchmarkSkyboxLoading();
+    ImGui::Text("Serial: %f ms", Renderer::_serialSkyboxMilliseconds);
+    ImGui::Text("Requested: %f ms", Renderer::_requestSkyboxMilliseconds);
+    if (ImGui::Button("Benchmark Normal Map (8K)"))
+      Renderer::BenchmarkNormalMap();
+    ImGui::Text("Normal Map Throughput: %f MPixels/s",
+      Renderer::_normalMapThroughput);
+    if (ImGui::Button("Benchmark Image Decoding"))
+      Renderer::BenchmarkImageDecoding();
+    ImGui::Text("stb: %f ms", Renderer::_stbDecodeMilliseconds);
+    ImGui::Text("Decoder: %f ms (%d mismatches)",
+      Renderer::_decoderMilliseconds, ImageDecoder::_mismatches);
+    ImGui::Text("Decoded Images: %d (%d left to stb)",
+      ImageDecoder::_decodedImages, ImageDecoder::_fallbacks);
+    ImGui::Text("Image Buffer Reuses: %d of %d",
+      TexturePool::_imageBuffers._reuses,
+      TexturePool::_imageBuffers._reuses +
+      TexturePool::_imageBuffers._allocations);
+    ImGui::Separator();
+    ImGui::Text("Uniforms");
+    ImGui::Text("Phong Uniforms: %u",
+      MeshRenderer::GetPhongShader()->UniformCount());
+    ImGui::Text("Uploaded Values: %llu", Shader::_uniformUploads);
+    ImGui::Text("Skipped Values: %llu", Shader::_uniformSkips);
+    ImGui::Separator();
     ImGui::Checkbox("Show Error Log", &show_error_log);
     ImGui::Separator();
   }
@@ -153,6 +330,26 @@ void Editor::Update(Mesh * mesh, MeshRenderer::MeshObject * mesh_object,
     ImGui::DragFloat("Rotation Speed", &camera_rotate_speed, 0.01f);
     ImGui::Separator();
   }
+  if (ImGui::CollapsingHeader("Environment")) {
+    int update = (int)Renderer::_environmentUpdate;
+    ImGui::Combo("Update", &update, "Always\0On Change\0Time Sliced\0\0");
+    Renderer::_environmentUpdate = (Renderer::EnvironmentUpdate)update;
+    ImGui::SliderFloat("Update Rate", &Renderer::_environmentUpdateRate,
+      0.0f, 60.0f, "%.1f per second");
+    if (ImGui::Button("Invalidate"))
+      Renderer::InvalidateEnvironment();
+    ImGui::Text("Faces Rendered: %d", Renderer::_environmentFacesRendered);
+    ImGui::Separator();
+    ImGui::Checkbox("Prefiltered Reflections", &Renderer::_prefilterEnvironment);
+    if (Renderer::_prefilterEnvironment) {
+      int total_faces = (int)Renderer::_prefilterFramebuffer._levels * 6;
+      ImGui::SliderInt("Faces Per Frame", &Renderer::_prefilterFacesPerFrame,
+        1, total_faces);
+      ImGui::Text("Prefiltered Faces: %d / %d",
+        (int)Renderer::_prefilterFacesComplete, total_faces);
+    }
+    ImGui::Separator();
+  }
   if (ImGui::CollapsingHeader("Mesh")) {
     ImGui::Text("Load Different Mesh");
     ImGui::InputText("", next_mesh, FILENAME_BUFFERSIZE);
@@ -207,6 +404,21 @@ void Editor::Update(Mesh * mesh, MeshRenderer::MeshObject * mesh_object,
     shader_in_use = MeshRenderer::IntToShaderType(shader_int);
     if (ImGui::Button("Reload Selected Shader"))
       MeshRenderer::ReloadShader(shader_in_use);
+    ImGui::Checkbox("Reload Changed Shader Files",
+      &MeshRenderer::_watchShaders);
+    ImGui::Separator();
+    ImGui::Checkbox("Phong Variants", &MeshRenderer::_phongVariants);
+    ImGui::Text("Compiled Variants: %u", MeshRenderer::PhongVariantCount());
+    ImGui::Text("Current Features: 0x%03x",
+      mesh_object->_material.PhongFeatures());
+    ImGui::Checkbox("Benchmark Phong", &Renderer::_benchmarkPhongVariants);
+    if (Renderer::_benchmarkPhongVariants) {
+      ImGui::Text("Gpu time per draw");
+      ImGui::Text("Uniform Branches: %f ms",
+        Renderer::_uberTimer.Milliseconds() / (float)BENCHMARK_DRAWS);
+      ImGui::Text("Variant: %f ms",
+        Renderer::_variantTimer.Milliseconds() / (float)BENCHMARK_DRAWS);
+    }
     ImGui::Separator();
   }
   ImGui::Checkbox("Show Material Editor", &show_material_editor);
@@ -246,6 +458,55 @@ inline void Editor::MaterialEditorUpdate(Material & material)
     // mapping type
     ImGui::Combo("Mapping Type", &material._mappingType,
       "Spherical\0Cylindrical\0Planar\0\0");
+    // the virtual textures stream the same maps through page caches. Their
+    // page files are only opened once they are asked for.
+    if (Renderer::VirtualTexturesReady())
+      ImGui::Checkbox("Virtual Texturing", &material._virtualTexturing);
+    else if (Renderer::VirtualTexturesLoading())
+      ImGui::Text("Opening virtual texture page files");
+    else if (ImGui::Button("Load Virtual Textures"))
+      Renderer::LoadVirtualTextures();
+    // virtual texturing takes priority over the texture array, which is only
+    // built once it is asked for
+    TextureArray & texture_array = Renderer::_materialArray;
+    if (!material._virtualTexturing) {
+      if (texture_array.Ready()) {
+        ImGui::Checkbox("Texture Array", &material._textureArray);
+        if (material._textureArray) {
+          ImGui::Text("Layers: %d of %dx%d, %f coverage",
+            texture_array._layers, texture_array._layerWidth,
+            texture_array._layerHeight, texture_array._coverage);
+        }
+      }
+      else if (texture_array.Loading())
+        ImGui::Text("Building the texture array");
+      else if (ImGui::Button("Load Texture Array"))
+        Renderer::LoadMaterialArray();
+    }
+    if (material._virtualTexturing) {
+      const char * names[] = { "Diffuse", "Specular", "Normal" };
+      VirtualTexture * textures[] = { &Renderer::_virtualDiffuse,
+        &Renderer::_virtualSpecular, &Renderer::_virtualNormal };
+      for (int i = 0; i < 3; ++i) {
+        const VirtualTexture & texture = *textures[i];
+        ImGui::Text("%s: %d / %d pages, %d queued, %d loaded", names[i],
+          texture._residentPages, texture._totalPages, texture._queuedPages,
+          texture._loadedPages);
+        ImGui::Text("  %d uploads, %d evictions, %f MB cache",
+          texture._uploads, texture._evictions,
+          (float)texture.CacheBytes() / (1024.0f * 1024.0f));
+      }
+      ImGui::SliderInt("Page Uploads Per Frame",
+        &Renderer::_virtualDiffuse._uploadsPerFrame, 1, 64);
+      Renderer::_virtualSpecular._uploadsPerFrame =
+        Renderer::_virtualDiffuse._uploadsPerFrame;
+      Renderer::_virtualNormal._uploadsPerFrame =
+        Renderer::_virtualDiffuse._uploadsPerFrame;
+      ImGui::Text("Page Build Time: %f ms",
+        VirtualTexture::_buildMilliseconds);
+      ImGui::Text("Feedback Readback: %f ms",
+        Renderer::_feedbackBuffer._readMilliseconds);
+    }
     ImGui::Separator();
     // texture maps
     if (material._textureMapping) {
@@ -256,9 +517,21 @@ inline void Editor::MaterialEditorUpdate(Material & material)
       ImGui::Text("Current Specular Texture: %s",
         _currentTextureSpecular.c_str());
     }
-    if (material._normalMapping) {
-      ImGui::Text("Current Normal Texture: %s",
-        _currentTextureNormal.c_str());
+    bool map_files = material._virtualTexturing || material._textureArray;
+    if (material._normalMapping && !map_files) {
+      ImGui::Checkbox("Generate From Specular Heights",
+        &Renderer::_generatedNormalMap);
+      if (Renderer::_generatedNormalMap) {
+        if (ImGui::SliderFloat("Normal Strength",
+          &Renderer::_normalMapStrength, 0.0f, 0.05f))
+          Renderer::_normalMapDirty = true;
+        ImGui::Text("Generation Time: %f ms",
+          Renderer::_normalMapTimer.Milliseconds());
+      }
+      else {
+        ImGui::Text("Current Normal Texture: %s",
+          _currentTextureNormal.c_str());
+      }
     }
     ImGui::Separator();
   }
@@ -266,6 +539,8 @@ inline void Editor::MaterialEditorUpdate(Material & material)
   if(material._environmentMapping){
     ImGui::SliderFloat("Environment Factor", &material._environmentFactor,
       0.0f, 1.0f);
+    // the specular exponent decides how blurry rough reflections are
+    ImGui::Checkbox("Rough Reflections", &material._roughReflections);
     ImGui::SliderFloat("Refraction Index", &material._refractionIndex,
       1.0f, 2.0f);
     ImGui::Checkbox("Chromatic Abberation", &material._chromaticAbberation);
@@ -286,6 +561,14 @@ inline void Editor::LightEditorUpdate()
     ImGui::SameLine();
     if (ImGui::Button("Mix"))
       SceneMix();
+    ImGui::SameLine();
+    if (ImGui::Button("Stress"))
+      SceneStress();
+    ImGui::InputInt("Stress Lights", &stress_lights, 256, 1024);
+    if (stress_lights > MAXLIGHTS)
+      stress_lights = MAXLIGHTS;
+    else if (stress_lights < 0)
+      stress_lights = 0;
     ImGui::Separator();
     ImGui::Checkbox("Rotate Lights", &rotating_lights);
     ImGui::DragFloat("Rotation Speed", &rotate_light_speed, 0.01f);
@@ -398,4 +681,41 @@ inline void Editor::SceneMix()
   lights[2]._ambientColor = Color(0.0f, 0.0f, 0.0f);
   lights[2]._diffuseColor = Color(0.6f, 0.3f, 0.3f);
   lights[2]._specularColor = Color(0.6f, 0.4f, 0);
+}
+
+// Returns a random float in the range [min, max]
+static float RandomFloat(float min, float max)
+{
+  return min + (max - min) * ((float)std::rand() / (float)RAND_MAX);
+}
+
+inline void Editor::SceneStress()
+{
+  // the same seed is used so every stress scene is the same
+  std::srand(300);
+  rotating_lights = false;
+  Light::_activeLights = stress_lights;
+  for (int i = 0; i < Light::_activeLights; ++i) {
+    // every eighth light is a spotlight pointing down
+    if (i % 8 == 0) {
+      lights[i]._type = Light::_typeSpot;
+      lights[i]._direction = Math::Vector3(0.0f, -1.0f, 0.0f);
+      lights[i]._innerAngle = 0.2f;
+      lights[i]._outerAngle = 0.5f;
+      lights[i]._spotExponent = 1.0f;
+    }
+    else
+      lights[i]._type = Light::_typePoint;
+    lights[i]._position = Math::Vector3(RandomFloat(-6.0f, 6.0f),
+      RandomFloat(-3.0f, 3.0f), RandomFloat(-6.0f, 6.0f));
+    // a large quadratic term keeps the range of each light small
+    lights[i]._attenuationC0 = 1.0f;
+    lights[i]._attenuationC1 = 0.0f;
+    lights[i]._attenuationC2 = 100.0f;
+    Color color(RandomFloat(0.0f, 1.0f), RandomFloat(0.0f, 1.0f),
+      RandomFloat(0.0f, 1.0f));
+    lights[i]._ambientColor = Color(0.0f, 0.0f, 0.0f);
+    lights[i]._diffuseColor = color;
+    lights[i]._specularColor = color;
+  }
 }
\ No newline at end of file
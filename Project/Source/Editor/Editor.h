@@ -32,6 +32,7 @@ public:
 public:
   static void SceneMix();
   static void SceneSame();
+  static void SceneStress();
 public:
   static bool show_light_editor;
   static bool show_material_editor;
@@ -52,6 +53,7 @@ public:
   static bool rotating_lights;
   static float rotate_light_speed;
   static Light lights[MAXLIGHTS];
+  static int stress_lights;
   static bool rotate_camera;
   static float camera_rotate_speed;
   static float camera_distance;
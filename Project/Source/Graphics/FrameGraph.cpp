@@ -0,0 +1,332 @@
+/* All content(c) 2017 - 2018 DigiPen(USA) Corporation, all rights reserved. */
+#include <chrono>
+
+#include "../Utility/OpenGLError.h"
+#include "RenderTargetPool.h"
+#include "FrameGraph.h"
+
+FrameGraph::FrameGraph() : _clears(0)
+{}
+
+void FrameGraph::Purge()
+{
+  for (std::pair<const std::string, GPUTimer> & timer : _timers)
+    timer.second.Purge();
+  _timers.clear();
+  Reset();
+}
+
+// Removes every pass and resource so the next frame can be declared
+void FrameGraph::Reset()
+{
+  _resources.clear();
+  _passes.clear();
+  _schedule.clear();
+}
+
+/*****************************************************************************/
+/*!
+\brief
+  Adds a render target that lives outside of the graph.
+
+\param name
+  The name of the resource.
+\param framebuffer
+  The framebuffer of the resource, or null for the default framebuffer.
+\param clear
+  When true, the resource is cleared before the first pass that writes it.
+\param clear_color
+  The color the resource is cleared to.
+\param clear_alpha
+  The alpha the resource is cleared to.
+
+\return The resource's handle.
+*/
+/*****************************************************************************/
+int FrameGraph::Import(const std::string & name, Framebuffer * framebuffer,
+  bool clear, const Color & clear_color, float clear_alpha)
+{
+  Resource resource;
+  resource._name = name;
+  resource._framebuffer = framebuffer;
+  resource._transient = false;
+  resource._width = framebuffer ? framebuffer->_width : 0;
+  resource._height = framebuffer ? framebuffer->_height : 0;
+  resource._format = 0;
+  resource._clear = clear;
+  resource._clearColor[0] = clear_color._r;
+  resource._clearColor[1] = clear_color._g;
+  resource._clearColor[2] = clear_color._b;
+  resource._clearColor[3] = clear_alpha;
+  resource._output = false;
+  resource._firstUse = -1;
+  resource._lastUse = -1;
+  _resources.push_back(resource);
+  return (int)_resources.size() - 1;
+}
+
+/*****************************************************************************/
+/*!
+\brief
+  Adds a render target that only exists while the passes that use it run.
+  It always starts cleared.
+
+\param name
+  The name of the resource.
+\param width
+  The width of the render target.
+\param height
+  The height of the render target.
+\param internal_format
+  The format of the render target's color texture.
+\param clear_color
+  The color the resource is cleared to.
+\param clear_alpha
+  The alpha the resource is cleared to.
+
+\return The resource's handle.
+*/
+/*****************************************************************************/
+int FrameGraph::Create(const std::string & name, unsigned int width,
+  unsigned int height, GLint internal_format, const Color & clear_color,
+  float clear_alpha)
+{
+  int handle = Import(name, nullptr, true, clear_color, clear_alpha);
+  Resource & resource = _resources[handle];
+  resource._transient = true;
+  resource._width = width;
+  resource._height = height;
+  resource._format = internal_format;
+  return handle;
+}
+
+// Adds a pass that calls execute when it runs and returns its handle
+int FrameGraph::AddPass(const std::string & name,
+  const std::function<void()> & execute)
+{
+  Pass pass;
+  pass._name = name;
+  pass._execute = execute;
+  pass._kept = false;
+  _passes.push_back(pass);
+  return (int)_passes.size() - 1;
+}
+
+void FrameGraph::Read(int pass, int resource)
+{
+  _passes[pass]._reads.push_back(resource);
+}
+
+void FrameGraph::Write(int pass, int resource)
+{
+  _passes[pass]._writes.push_back(resource);
+}
+
+// Marks a resource as a result of the frame, so its writers are never culled
+void FrameGraph::Output(int resource)
+{
+  _resources[resource]._output = true;
+}
+
+/*****************************************************************************/
+/*!
+\brief
+  Culls the passes that are not needed, orders the rest, and decides where
+  the resources are cleared, acquired, and released.
+*/
+/*****************************************************************************/
+void FrameGraph::Compile()
+{
+  Cull();
+  Schedule();
+  for (Resource & resource : _resources) {
+    resource._firstUse = -1;
+    resource._lastUse = -1;
+  }
+  for (unsigned int position = 0; position < _schedule.size(); ++position) {
+    Pass & pass = _passes[_schedule[position]];
+    pass._clears.clear();
+    for (int handle : pass._writes) {
+      Resource & resource = _resources[handle];
+      // the first writer clears, and a reader never comes before it
+      if (resource._firstUse == -1 && resource._clear)
+        pass._clears.push_back(handle);
+    }
+    for (const std::vector<int> * uses : { &pass._reads, &pass._writes }) {
+      for (int handle : *uses) {
+        Resource & resource = _resources[handle];
+        if (resource._firstUse == -1)
+          resource._firstUse = (int)position;
+        resource._lastUse = (int)position;
+      }
+    }
+  }
+}
+
+/*****************************************************************************/
+/*!
+\brief
+  Runs the scheduled passes. Transient resources are acquired right before
+  their first pass and released right after their last.
+*/
+/*****************************************************************************/
+void FrameGraph::Execute()
+{
+  _passStats.clear();
+  _clears = 0;
+  for (unsigned int position = 0; position < _schedule.size(); ++position) {
+    Pass & pass = _passes[_schedule[position]];
+    for (Resource & resource : _resources) {
+      if (resource._transient && resource._firstUse == (int)position)
+        resource._framebuffer = RenderTargetPool::Acquire(pass._name,
+          resource._width, resource._height, resource._format);
+    }
+    std::chrono::high_resolution_clock::time_point start =
+      std::chrono::high_resolution_clock::now();
+    std::map<std::string, GPUTimer>::iterator timer =
+      _timers.find(pass._name);
+    if (timer == _timers.end()) {
+      timer = _timers.insert(std::make_pair(pass._name, GPUTimer())).first;
+      timer->second.Initialize(true);
+    }
+    timer->second.Start();
+    for (int handle : pass._clears)
+      ClearResource(_resources[handle]);
+    pass._execute();
+    timer->second.End();
+    std::chrono::duration<float, std::milli> time =
+      std::chrono::high_resolution_clock::now() - start;
+    PassStats stats = { pass._name, false, time.count(),
+      timer->second.Milliseconds() };
+    _passStats.push_back(stats);
+    for (Resource & resource : _resources) {
+      if (resource._transient && resource._lastUse == (int)position) {
+        RenderTargetPool::Release(resource._framebuffer);
+        resource._framebuffer = nullptr;
+      }
+    }
+  }
+  Framebuffer::BindDefault();
+  for (const Pass & pass : _passes) {
+    if (!pass._kept) {
+      PassStats stats = { pass._name, true, 0.0f, 0.0f };
+      _passStats.push_back(stats);
+    }
+  }
+  try {
+    GLenum gl_error = glGetError();
+    OPENGLERRORCHECK("FrameGraph.cpp", "Execute", "During frame graph execution", gl_error);
+  }
+  catch (const Error & error) {
+    ErrorLog::Write(error);
+  }
+}
+
+// The framebuffer of a resource while its passes run. Null means the default
+// framebuffer.
+Framebuffer * FrameGraph::Target(int resource) const
+{
+  return _resources[resource]._framebuffer;
+}
+
+// Keeps the passes that write outputs and, working backwards, the passes
+// that write what the kept passes read
+void FrameGraph::Cull()
+{
+  std::vector<bool> needed(_resources.size(), false);
+  for (unsigned int i = 0; i < _resources.size(); ++i)
+    needed[i] = _resources[i]._output;
+  for (Pass & pass : _passes)
+    pass._kept = false;
+  bool changed = true;
+  while (changed) {
+    changed = false;
+    for (Pass & pass : _passes) {
+      if (pass._kept)
+        continue;
+      for (int handle : pass._writes) {
+        if (needed[handle])
+          pass._kept = true;
+      }
+      if (!pass._kept)
+        continue;
+      for (int handle : pass._reads)
+        needed[handle] = true;
+      changed = true;
+    }
+  }
+}
+
+// Orders the kept passes so writers come before readers and writers of the
+// same resource keep their declared order. Among the passes that are ready,
+// the one declared first runs first.
+void FrameGraph::Schedule()
+{
+  unsigned int pass_count = (unsigned int)_passes.size();
+  std::vector<std::vector<int> > successors(pass_count);
+  std::vector<int> dependencies(pass_count, 0);
+  for (unsigned int r = 0; r < _resources.size(); ++r) {
+    int last_writer = -1;
+    for (unsigned int p = 0; p < pass_count; ++p) {
+      const Pass & writer = _passes[p];
+      if (!writer._kept)
+        continue;
+      bool writes = false;
+      for (int handle : writer._writes)
+        writes = writes || handle == (int)r;
+      if (!writes)
+        continue;
+      if (last_writer != -1) {
+        successors[last_writer].push_back(p);
+        ++dependencies[p];
+      }
+      last_writer = p;
+      for (unsigned int q = 0; q < pass_count; ++q) {
+        const Pass & reader = _passes[q];
+        if (q == p || !reader._kept)
+          continue;
+        for (int handle : reader._reads) {
+          if (handle == (int)r) {
+            successors[p].push_back(q);
+            ++dependencies[q];
+            break;
+          }
+        }
+      }
+    }
+  }
+  _schedule.clear();
+  std::vector<bool> scheduled(pass_count, false);
+  unsigned int kept = 0;
+  for (const Pass & pass : _passes)
+    kept += pass._kept ? 1 : 0;
+  while (_schedule.size() < kept) {
+    int next = -1;
+    for (unsigned int p = 0; p < pass_count && next == -1; ++p) {
+      if (_passes[p]._kept && !scheduled[p] && dependencies[p] == 0)
+        next = p;
+    }
+    if (next == -1) {
+      Error error("FrameGraph.cpp", "Schedule");
+      error.Add("The passes depend on each other in a cycle.");
+      throw(error);
+    }
+    scheduled[next] = true;
+    _schedule.push_back(next);
+    for (int successor : successors[next])
+      --dependencies[successor];
+  }
+}
+
+// Binds a resource and clears its color and depth
+void FrameGraph::ClearResource(const Resource & resource)
+{
+  if (resource._framebuffer)
+    resource._framebuffer->Bind();
+  else
+    Framebuffer::BindDefault();
+  glClearColor(resource._clearColor[0], resource._clearColor[1],
+    resource._clearColor[2], resource._clearColor[3]);
+  glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+  ++_clears;
+}
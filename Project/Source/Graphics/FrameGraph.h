@@ -0,0 +1,112 @@
+/* All content(c) 2017 - 2018 DigiPen(USA) Corporation, all rights reserved. */
+#ifndef FRAMEGRAPH_H
+#define FRAMEGRAPH_H
+
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+#include <GL/glew.h>
+#include "Color.h"
+#include "Framebuffer.h"
+#include "GPUTimer.h"
+
+/*****************************************************************************/
+/*!
+\class FrameGraph
+\brief
+  Schedules the passes of a frame from the render targets they read and
+  write. Every frame the passes and resources are declared again, and
+  Compile culls the passes whose results are never used, orders the rest so
+  every resource is written before it is read, and finds the first and last
+  pass that uses each resource. Execute then runs the passes in that order.
+
+\par Important Notes
+  - Passes that write a resource marked with Output, or that write a
+    resource read by a pass that is kept, are kept. Every other pass is
+    culled and its function is not called.
+  - Writers of a resource run in the order they were declared, and every
+    writer runs before every reader. Passes that do not depend on each
+    other also keep their declared order.
+  - Resources created with Create are transient. They are acquired from the
+    RenderTargetPool before their first pass and released after their last,
+    so transient resources whose passes do not overlap share memory.
+  - A resource that needs clearing is cleared right before its first writer,
+    and only when a writer is kept. Imported resources keep their contents
+    unless they are imported with a clear.
+  - Every pass that runs is timed on the cpu and the gpu.
+*/
+/*****************************************************************************/
+class FrameGraph
+{
+public:
+  // The times of a pass during the last Execute
+  struct PassStats
+  {
+    std::string _name;
+    bool _culled;
+    float _cpuMilliseconds;
+    float _gpuMilliseconds;
+  };
+  FrameGraph();
+  void Purge();
+  void Reset();
+  int Import(const std::string & name, Framebuffer * framebuffer,
+    bool clear = false, const Color & clear_color = Color(0.0f, 0.0f, 0.0f),
+    float clear_alpha = 1.0f);
+  int Create(const std::string & name, unsigned int width,
+    unsigned int height, GLint internal_format,
+    const Color & clear_color = Color(0.0f, 0.0f, 0.0f),
+    float clear_alpha = 0.0f);
+  int AddPass(const std::string & name, const std::function<void()> & execute);
+  void Read(int pass, int resource);
+  void Write(int pass, int resource);
+  void Output(int resource);
+  void Compile();
+  void Execute();
+  Framebuffer * Target(int resource) const;
+  // Every declared pass in the order it ran. Culled passes follow.
+  std::vector<PassStats> _passStats;
+  // The clears made during the last Execute
+  int _clears;
+private:
+  struct Resource
+  {
+    std::string _name;
+    //! The framebuffer rendered into. Null for the default framebuffer or
+    //! for a transient resource that has not been acquired.
+    Framebuffer * _framebuffer;
+    bool _transient;
+    unsigned int _width;
+    unsigned int _height;
+    GLint _format;
+    bool _clear;
+    float _clearColor[4];
+    bool _output;
+    //! The positions in the schedule of the first and last pass that use
+    //! the resource, or -1 when no pass that runs uses it
+    int _firstUse;
+    int _lastUse;
+  };
+  struct Pass
+  {
+    std::string _name;
+    std::function<void()> _execute;
+    std::vector<int> _reads;
+    std::vector<int> _writes;
+    //! The resources cleared before the pass runs
+    std::vector<int> _clears;
+    bool _kept;
+  };
+  void Cull();
+  void Schedule();
+  void ClearResource(const Resource & resource);
+  std::vector<Resource> _resources;
+  std::vector<Pass> _passes;
+  //! The indices of the kept passes in the order they run
+  std::vector<int> _schedule;
+  //! The gpu timers of the passes, kept by name between frames
+  std::map<std::string, GPUTimer> _timers;
+};
+
+#endif // !FRAMEGRAPH_H
@@ -3,7 +3,11 @@
 #include "OpenGLContext.h"
 #include "Framebuffer.h"
 
-void Framebuffer::Initialize(unsigned int width, unsigned int height)
+// creates a framebuffer that renders into a texture with the given format
+// when levels is greater than one, the texture gets that many mip levels and
+// is sampled with a trilinear filter
+void Framebuffer::Initialize(unsigned int width, unsigned int height,
+  GLint internal_format, unsigned int levels)
 {
   // create framebuffer
   glGenFramebuffers(1, &_fbo);
@@ -12,10 +16,25 @@ void Framebuffer::Initialize(unsigned int width, unsigned int height)
   GLuint tbo;
   glGenTextures(1, &tbo);
   glBindTexture(GL_TEXTURE_2D, tbo);
-  glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, NULL);
+  for (unsigned int level = 0; level < levels; ++level) {
+    unsigned int level_width = width >> level;
+    unsigned int level_height = height >> level;
+    if (level_width == 0)
+      level_width = 1;
+    if (level_height == 0)
+      level_height = 1;
+    glTexImage2D(GL_TEXTURE_2D, level, internal_format, level_width,
+      level_height, 0, GL_RGB, GL_UNSIGNED_BYTE, NULL);
+  }
   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+  if (levels > 1) {
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, levels - 1);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER,
+      GL_LINEAR_MIPMAP_LINEAR);
+  }
+  else
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
   glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, tbo, 0);
   _texture = TexturePool::Upload(tbo);
@@ -29,6 +48,7 @@ void Framebuffer::Initialize(unsigned int width, unsigned int height)
   // frame buffer done
   _width = width;
   _height = height;
+  _levels = levels;
   try {
     GLenum gl_error = glGetError();
     OPENGLERRORCHECK("main.cpp", "Framebuffer::Initialize", "During Framebuffer creation", gl_error);
@@ -38,12 +58,106 @@ void Framebuffer::Initialize(unsigned int width, unsigned int height)
   }
 }
 
+// creates a framebuffer that renders into the faces of a cubemap
+// when levels is greater than one, the cubemap gets that many mip levels
+void Framebuffer::InitializeCubemap(unsigned int size, unsigned int levels)
+{
+  // create framebuffer
+  glGenFramebuffers(1, &_fbo);
+  glBindFramebuffer(GL_FRAMEBUFFER, _fbo);
+  // create cubemap texture
+  GLuint tbo;
+  glGenTextures(1, &tbo);
+  glBindTexture(GL_TEXTURE_CUBE_MAP, tbo);
+  for (unsigned int level = 0; level < levels; ++level) {
+    unsigned int level_size = size >> level;
+    if (level_size == 0)
+      level_size = 1;
+    for (unsigned int i = 0; i < 6; ++i) {
+      glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, level, GL_RGB,
+        level_size, level_size, 0, GL_RGB, GL_UNSIGNED_BYTE, NULL);
+    }
+  }
+  glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_BASE_LEVEL, 0);
+  glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAX_LEVEL, levels - 1);
+  if (levels > 1)
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+  else
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+  glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+  glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
+  glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+    GL_TEXTURE_CUBE_MAP_POSITIVE_X, tbo, 0);
+  _texture = TexturePool::Upload(tbo, GL_TEXTURE_CUBE_MAP);
+  // create renderbuffer shared by all faces
+  glGenRenderbuffers(1, &_rbo);
+  glBindRenderbuffer(GL_RENDERBUFFER, _rbo);
+  glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, size, size);
+  glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, _rbo);
+  // unbind framebuffer
+  glBindFramebuffer(GL_FRAMEBUFFER, 0);
+  _width = size;
+  _height = size;
+  _levels = levels;
+  try {
+    GLenum gl_error = glGetError();
+    OPENGLERRORCHECK("Framebuffer.cpp", "Framebuffer::InitializeCubemap", "During Framebuffer creation", gl_error);
+  }
+  catch (const Error & error) {
+    ErrorLog::Write(error);
+  }
+}
+
+// deletes the framebuffer, its renderbuffer, and its texture
+void Framebuffer::Purge()
+{
+  glDeleteRenderbuffers(1, &_rbo);
+  glDeleteFramebuffers(1, &_fbo);
+  if (_texture)
+    TexturePool::Unload(_texture);
+  _rbo = 0;
+  _fbo = 0;
+  _texture = nullptr;
+}
+
+// the video memory used by the texture and the depth stencil renderbuffer
+long long Framebuffer::Bytes() const
+{
+  if (!_texture)
+    return 0;
+  return (long long)_texture->_bytes + (long long)_width * _height * 4;
+}
+
 void Framebuffer::Bind()
 {
   glBindFramebuffer(GL_FRAMEBUFFER, _fbo);
   glViewport(0, 0, _width, _height);
 }
 
+// binds a cubemap framebuffer so rendering goes to the given face and level
+// faces are ordered +x, -x, +y, -y, +z, -z
+void Framebuffer::BindFace(unsigned int face, unsigned int level)
+{
+  glBindFramebuffer(GL_FRAMEBUFFER, _fbo);
+  glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+    GL_TEXTURE_CUBE_MAP_POSITIVE_X + face, _texture->_glID, level);
+  unsigned int level_size = _width >> level;
+  if (level_size == 0)
+    level_size = 1;
+  glViewport(0, 0, level_size, level_size);
+}
+
+// fills every level after the first with a downsampled copy of the first
+void Framebuffer::GenerateMipmaps()
+{
+  glBindTexture(_texture->_target, _texture->_glID);
+  glGenerateMipmap(_texture->_target);
+  glBindTexture(_texture->_target, 0);
+}
+
 void Framebuffer::BindDefault() {
   glBindFramebuffer(GL_FRAMEBUFFER, 0);
   OpenGLContext::AdjustViewport();
@@ -9,15 +9,23 @@
 class Framebuffer
 {
 public:
-  Framebuffer() {}
-  void Initialize(unsigned int width, unsigned int height);
+  Framebuffer() : _fbo(0), _texture(nullptr), _rbo(0), _width(0),
+    _height(0), _levels(0) {}
+  void Initialize(unsigned int width, unsigned int height,
+    GLint internal_format = GL_RGB, unsigned int levels = 1);
+  void InitializeCubemap(unsigned int size, unsigned int levels = 1);
+  void Purge();
+  long long Bytes() const;
   void Bind();
+  void BindFace(unsigned int face, unsigned int level = 0);
+  void GenerateMipmaps();
   static void BindDefault();
   GLuint _fbo;
   TextureObject * _texture;
   GLuint _rbo;
   unsigned int _width;
   unsigned int _height;
+  unsigned int _levels;
 };
 
 #endif // !FRAMEBUFFER_H
\ No newline at end of file
@@ -0,0 +1,95 @@
+/* All content(c) 2017 - 2018 DigiPen(USA) Corporation, all rights reserved. */
+#include "GPUTimer.h"
+
+GPUTimer::GPUTimer() : _timestamps(false), _current(0), _skipped(false),
+  _milliseconds(0.0f)
+{
+  for (int i = 0; i < GPUTIMER_QUERIES; ++i) {
+    _queries[i] = 0;
+    _endQueries[i] = 0;
+    _pending[i] = false;
+  }
+}
+
+void GPUTimer::Initialize(bool timestamps)
+{
+  _timestamps = timestamps;
+  glGenQueries(GPUTIMER_QUERIES, _queries);
+  if (_timestamps)
+    glGenQueries(GPUTIMER_QUERIES, _endQueries);
+}
+
+void GPUTimer::Purge()
+{
+  glDeleteQueries(GPUTIMER_QUERIES, _queries);
+  if (_timestamps)
+    glDeleteQueries(GPUTIMER_QUERIES, _endQueries);
+}
+
+void GPUTimer::Start()
+{
+  // read the result of the oldest measurement before the query is reused
+  if (_pending[_current] && !Read(_current)) {
+    // the gpu is still behind, so skip this measurement
+    _skipped = true;
+    return;
+  }
+  _skipped = false;
+  GLuint query = _queries[_current];
+  if (_timestamps)
+    glQueryCounter(query, GL_TIMESTAMP);
+  else
+    glBeginQuery(GL_TIME_ELAPSED, query);
+}
+
+void GPUTimer::End()
+{
+  if (_skipped)
+    return;
+  if (_timestamps)
+    glQueryCounter(_endQueries[_current], GL_TIMESTAMP);
+  else
+    glEndQuery(GL_TIME_ELAPSED);
+  _pending[_current] = true;
+  _current = (_current + 1) % GPUTIMER_QUERIES;
+}
+
+// reads every measurement that has finished, oldest first, without waiting
+// for the rest. Timers that are not started every frame call this so their
+// time does not wait for their queries to be reused.
+void GPUTimer::Update()
+{
+  for (int i = 0; i < GPUTIMER_QUERIES; ++i) {
+    int index = (_current + i) % GPUTIMER_QUERIES;
+    if (_pending[index] && !Read(index))
+      return;
+  }
+}
+
+float GPUTimer::Milliseconds() const
+{
+  return _milliseconds;
+}
+
+// reads the measurement made with the queries at index if the gpu has
+// finished it. The End timestamp is the last to finish when timestamps are
+// used.
+bool GPUTimer::Read(int index)
+{
+  GLuint query = _queries[index];
+  GLuint last_query = _timestamps ? _endQueries[index] : query;
+  GLint available = 0;
+  glGetQueryObjectiv(last_query, GL_QUERY_RESULT_AVAILABLE, &available);
+  if (!available)
+    return false;
+  GLuint64 nanoseconds = 0;
+  glGetQueryObjectui64v(query, GL_QUERY_RESULT, &nanoseconds);
+  if (_timestamps) {
+    GLuint64 end = 0;
+    glGetQueryObjectui64v(last_query, GL_QUERY_RESULT, &end);
+    nanoseconds = end - nanoseconds;
+  }
+  _milliseconds = (float)((double)nanoseconds / 1000000.0);
+  _pending[index] = false;
+  return true;
+}
@@ -0,0 +1,51 @@
+/* All content(c) 2017 - 2018 DigiPen(USA) Corporation, all rights reserved. */
+#ifndef GPUTIMER_H
+#define GPUTIMER_H
+
+#include <GL/glew.h>
+
+// The number of queries a timer cycles through. Results are read this many
+// frames late so reading them never stalls the cpu.
+#define GPUTIMER_QUERIES 3
+
+/*****************************************************************************/
+/*!
+\class GPUTimer
+\brief
+  Measures the time the gpu spends executing the commands that are issued
+  between Start and End. Only one timer can be running at a time, unless
+  it is initialized to use timestamps. Timers that use timestamps record
+  the gpu time at Start and End instead, so they can run around other
+  timers.
+*/
+/*****************************************************************************/
+class GPUTimer
+{
+public:
+  GPUTimer();
+  void Initialize(bool timestamps = false);
+  void Purge();
+  void Start();
+  void End();
+  void Update();
+  float Milliseconds() const;
+private:
+  bool Read(int index);
+  //! The time elapsed queries that are cycled through, or the Start
+  //! timestamps when timestamps are used
+  GLuint _queries[GPUTIMER_QUERIES];
+  //! The End timestamps. These are only made when timestamps are used.
+  GLuint _endQueries[GPUTIMER_QUERIES];
+  //! Identifies whether the timer records timestamps
+  bool _timestamps;
+  //! Identifies which queries have results that have not been read
+  bool _pending[GPUTIMER_QUERIES];
+  //! The query that will be used for the next measurement
+  int _current;
+  //! Identifies whether the current measurement was skipped
+  bool _skipped;
+  //! The most recent measured time
+  float _milliseconds;
+};
+
+#endif // !GPUTIMER_H
@@ -1,4 +1,8 @@
 /* All content(c) 2017 - 2018 DigiPen(USA) Corporation, all rights reserved. */
+#include <cfloat>
+#include <cmath>
+#include <string>
+
 #include "Light.h"
 
 // static initializations
@@ -23,81 +27,92 @@ Light::Light(unsigned int type, const Math::Vector3 & position,
   _specularColor(specular_color)
 {}
 
-void Light::SetUniforms(unsigned int light_index, PhongShader * phong_shader)
+// The distance at which the light's attenuation reaches LIGHT_CUTOFF.
+// Directional lights and lights that never fall off have an infinite range.
+float Light::Range() const
 {
-  glUniform1i(phong_shader->ULights[light_index].UType, _type);
-  glUniform3f(phong_shader->ULights[light_index].UPosition,
-    _position.x, _position.y, _position.z);
-  glUniform3f(phong_shader->ULights[light_index].UDirection,
-    _direction.x, _direction.y, _direction.z);
-  glUniform1f(phong_shader->ULights[light_index].UInnerAngle,
-    _innerAngle);
-  glUniform1f(phong_shader->ULights[light_index].UOuterAngle,
-    _outerAngle);
-  glUniform1f(phong_shader->ULights[light_index].USpotExponent,
-    _spotExponent);
-  glUniform3f(phong_shader->ULights[light_index].UAmbientColor,
-    _ambientColor._x, _ambientColor._y, _ambientColor._z);
-  glUniform3f(phong_shader->ULights[light_index].UDiffuseColor,
-    _diffuseColor._x, _diffuseColor._y, _diffuseColor._z);
-  glUniform3f(phong_shader->ULights[light_index].USpecularColor,
-    _specularColor._x, _specularColor._y, _specularColor._z);
-  glUniform1f(phong_shader->ULights[light_index].UAttenuationC0,
-    _attenuationC0);
-  glUniform1f(phong_shader->ULights[light_index].UAttenuationC1,
-    _attenuationC1);
-  glUniform1f(phong_shader->ULights[light_index].UAttenuationC2,
-    _attenuationC2);
+  if (_type == _typeDirectional)
+    return FLT_MAX;
+  // solve c2 * d^2 + c1 * d + c0 = 1 / cutoff for d
+  float c = _attenuationC0 - 1.0f / LIGHT_CUTOFF;
+  if (c >= 0.0f)
+    return 0.0f;
+  if (_attenuationC2 > 0.0f) {
+    float discriminant = _attenuationC1 * _attenuationC1 -
+      4.0f * _attenuationC2 * c;
+    return (-_attenuationC1 + sqrt(discriminant)) / (2.0f * _attenuationC2);
+  }
+  if (_attenuationC1 > 0.0f)
+    return -c / _attenuationC1;
+  return FLT_MAX;
 }
-void Light::SetUniforms(unsigned int light_index, GouraudShader * gouraud_shader)
+
+// the members of a light in the shaders, in the order they are set
+enum LightUniform
 {
-  glUniform1i(gouraud_shader->ULights[light_index].UType, _type);
-  glUniform3f(gouraud_shader->ULights[light_index].UPosition,
-    _position.x, _position.y, _position.z);
-  glUniform3f(gouraud_shader->ULights[light_index].UDirection,
-    _direction.x, _direction.y, _direction.z);
-  glUniform1f(gouraud_shader->ULights[light_index].UInnerAngle,
-    _innerAngle);
-  glUniform1f(gouraud_shader->ULights[light_index].UOuterAngle,
-    _outerAngle);
-  glUniform1f(gouraud_shader->ULights[light_index].USpotExponent,
-    _spotExponent);
-  glUniform3f(gouraud_shader->ULights[light_index].UAmbientColor,
-    _ambientColor._x, _ambientColor._y, _ambientColor._z);
-  glUniform3f(gouraud_shader->ULights[light_index].UDiffuseColor,
-    _diffuseColor._x, _diffuseColor._y, _diffuseColor._z);
-  glUniform3f(gouraud_shader->ULights[light_index].USpecularColor,
-    _specularColor._x, _specularColor._y, _specularColor._z);
-  glUniform1f(gouraud_shader->ULights[light_index].UAttenuationC0,
-    _attenuationC0);
-  glUniform1f(gouraud_shader->ULights[light_index].UAttenuationC1,
-    _attenuationC1);
-  glUniform1f(gouraud_shader->ULights[light_index].UAttenuationC2,
-    _attenuationC2);
+  UNIFORM_TYPE,
+  UNIFORM_POSITION,
+  UNIFORM_DIRECTION,
+  UNIFORM_INNER_ANGLE,
+  UNIFORM_OUTER_ANGLE,
+  UNIFORM_SPOT_EXPONENT,
+  UNIFORM_AMBIENT_COLOR,
+  UNIFORM_DIFFUSE_COLOR,
+  UNIFORM_SPECULAR_COLOR,
+  UNIFORM_ATTENUATION_C0,
+  UNIFORM_ATTENUATION_C1,
+  UNIFORM_ATTENUATION_C2,
+  LIGHT_UNIFORMS
+};
+
+static const char * light_uniform_fields[LIGHT_UNIFORMS] = {
+  "UType", "UPosition", "UDirection", "UInnerAngle", "UOuterAngle",
+  "USpotExponent", "UAmbientColor", "UDiffuseColor", "USpecularColor",
+  "UAttenuationC0", "UAttenuationC1", "UAttenuationC2" };
+
+// The full uniform name of every member of every light that the shaders can
+// hold, like "ULights[2].UType". They are built the first time lights are
+// set rather than for every light every frame.
+static std::string light_uniform_names[MAXUNIFORMLIGHTS][LIGHT_UNIFORMS];
+
+static void BuildLightUniformNames()
+{
+  for (int i = 0; i < MAXUNIFORMLIGHTS; ++i) {
+    std::string light("ULights[" + std::to_string(i) + "].");
+    for (int field = 0; field < LIGHT_UNIFORMS; ++field)
+      light_uniform_names[i][field] = light + light_uniform_fields[field];
+  }
 }
-void Light::SetUniforms(unsigned int light_index, BlinnShader * blinn_shader)
+
+void Light::SetUniforms(unsigned int light_index, Shader * shader)
 {
-  glUniform1i(blinn_shader->ULights[light_index].UType, _type);
-  glUniform3f(blinn_shader->ULights[light_index].UPosition,
+  // the shaders only hold MAXUNIFORMLIGHTS lights
+  if (light_index >= MAXUNIFORMLIGHTS)
+    return;
+  if (light_uniform_names[0][0].empty())
+    BuildLightUniformNames();
+  const std::string * names = light_uniform_names[light_index];
+  shader->SetUniform1i(names[UNIFORM_TYPE].c_str(), _type);
+  shader->SetUniform3f(names[UNIFORM_POSITION].c_str(),
     _position.x, _position.y, _position.z);
-  glUniform3f(blinn_shader->ULights[light_index].UDirection,
+  shader->SetUniform3f(names[UNIFORM_DIRECTION].c_str(),
     _direction.x, _direction.y, _direction.z);
-  glUniform1f(blinn_shader->ULights[light_index].UInnerAngle,
+  shader->SetUniform1f(names[UNIFORM_INNER_ANGLE].c_str(),
     _innerAngle);
-  glUniform1f(blinn_shader->ULights[light_index].UOuterAngle,
+  shader->SetUniform1f(names[UNIFORM_OUTER_ANGLE].c_str(),
     _outerAngle);
-  glUniform1f(blinn_shader->ULights[light_index].USpotExponent,
+  shader->SetUniform1f(names[UNIFORM_SPOT_EXPONENT].c_str(),
     _spotExponent);
-  glUniform3f(blinn_shader->ULights[light_index].UAmbientColor,
+  shader->SetUniform3f(names[UNIFORM_AMBIENT_COLOR].c_str(),
     _ambientColor._x, _ambientColor._y, _ambientColor._z);
-  glUniform3f(blinn_shader->ULights[light_index].UDiffuseColor,
+  shader->SetUniform3f(names[UNIFORM_DIFFUSE_COLOR].c_str(),
     _diffuseColor._x, _diffuseColor._y, _diffuseColor._z);
-  glUniform3f(blinn_shader->ULights[light_index].USpecularColor,
+  shader->SetUniform3f(names[UNIFORM_SPECULAR_COLOR].c_str(),
     _specularColor._x, _specularColor._y, _specularColor._z);
-  glUniform1f(blinn_shader->ULights[light_index].UAttenuationC0,
+  shader->SetUniform1f(names[UNIFORM_ATTENUATION_C0].c_str(),
     _attenuationC0);
-  glUniform1f(blinn_shader->ULights[light_index].UAttenuationC1,
+  shader->SetUniform1f(names[UNIFORM_ATTENUATION_C1].c_str(),
     _attenuationC1);
-  glUniform1f(blinn_shader->ULights[light_index].UAttenuationC2,
+  shader->SetUniform1f(names[UNIFORM_ATTENUATION_C2].c_str(),
     _attenuationC2);
 }
\ No newline at end of file
@@ -9,6 +9,10 @@
 #define PI 3.141592653589f
 #define PI2 6.28318530718f
 
+// Lights are treated as having no effect once their attenuation drops below
+// this value. This gives point and spot lights a finite range.
+#define LIGHT_CUTOFF (1.0f / 256.0f)
+
 struct Light
 {
   Light();
@@ -33,7 +37,6 @@ struct Light
   static const int _typeSpot;
 
   static int _activeLights;
-  void SetUniforms(unsigned int light_index, PhongShader * phong_shader);
-  void SetUniforms(unsigned int light_index, GouraudShader * gouraud_shader);
-  void SetUniforms(unsigned int light_index, BlinnShader * blinn_shader);
+  float Range() const;
+  void SetUniforms(unsigned int light_index, Shader * shader);
 };
\ No newline at end of file
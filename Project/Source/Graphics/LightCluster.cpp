@@ -0,0 +1,323 @@
+/* All content(c) 2017 - 2018 DigiPen(USA) Corporation, all rights reserved. */
+#include <cfloat>
+#include <chrono>
+#include <cmath>
+
+#include "../Core/ThreadPool.h"
+#include "../Utility/OpenGLError.h"
+#include "OpenGLContext.h"
+#include "LightCluster.h"
+
+// static initializations
+bool LightCluster::_parallel = true;
+float LightCluster::_binMilliseconds = 0.0f;
+float LightCluster::_uploadMilliseconds = 0.0f;
+int LightCluster::_indexCount = 0;
+int LightCluster::_maxClusterLights = 0;
+int LightCluster::_droppedLights = 0;
+GLuint LightCluster::_lightBuffer = 0;
+GLuint LightCluster::_clusterBuffer = 0;
+GLuint LightCluster::_indexBuffer = 0;
+GLsizeiptr LightCluster::_lightBufferCapacity = 0;
+GLsizeiptr LightCluster::_clusterBufferCapacity = 0;
+GLsizeiptr LightCluster::_indexBufferCapacity = 0;
+GLuint LightCluster::_lightTextureID = 0;
+GLuint LightCluster::_clusterTextureID = 0;
+GLuint LightCluster::_indexTextureID = 0;
+TextureObject * LightCluster::_lightTexture = nullptr;
+TextureObject * LightCluster::_clusterTexture = nullptr;
+TextureObject * LightCluster::_indexTexture = nullptr;
+int LightCluster::_maxIndices = 0;
+std::vector<float> LightCluster::_lightData;
+std::vector<GLuint> LightCluster::_clusterData;
+std::vector<GLuint> LightCluster::_indexData;
+std::vector<LightCluster::Bounds> LightCluster::_lightBounds;
+std::vector<GLuint> LightCluster::_clusterLights;
+std::vector<int> LightCluster::_clusterCounts;
+float LightCluster::_nearPlane = 0.1f;
+float LightCluster::_farPlane = 20.0f;
+float LightCluster::_depthScale = 0.0f;
+float LightCluster::_depthBias = 0.0f;
+float LightCluster::_tileWidth = 1.0f;
+float LightCluster::_tileHeight = 1.0f;
+
+void LightCluster::Initialize()
+{
+  glGenBuffers(1, &_lightBuffer);
+  glGenBuffers(1, &_clusterBuffer);
+  glGenBuffers(1, &_indexBuffer);
+  // Texture buffers need storage before they are attached, so each buffer
+  // starts with enough space for the cluster grid.
+  _clusterData.resize(CLUSTER_COUNT * 2, 0);
+  UploadBuffer(_clusterBuffer, _clusterData.data(),
+    _clusterData.size() * sizeof(GLuint), &_clusterBufferCapacity);
+  UploadBuffer(_lightBuffer, nullptr, 4 * sizeof(float), &_lightBufferCapacity);
+  UploadBuffer(_indexBuffer, nullptr, sizeof(GLuint), &_indexBufferCapacity);
+  // attach the buffers to textures
+  glGenTextures(1, &_lightTextureID);
+  glBindTexture(GL_TEXTURE_BUFFER, _lightTextureID);
+  glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, _lightBuffer);
+  glGenTextures(1, &_clusterTextureID);
+  glBindTexture(GL_TEXTURE_BUFFER, _clusterTextureID);
+  glTexBuffer(GL_TEXTURE_BUFFER, GL_RG32UI, _clusterBuffer);
+  glGenTextures(1, &_indexTextureID);
+  glBindTexture(GL_TEXTURE_BUFFER, _indexTextureID);
+  glTexBuffer(GL_TEXTURE_BUFFER, GL_R32UI, _indexBuffer);
+  glBindTexture(GL_TEXTURE_BUFFER, 0);
+  _lightTexture = TexturePool::Upload(_lightTextureID, GL_TEXTURE_BUFFER);
+  _clusterTexture = TexturePool::Upload(_clusterTextureID, GL_TEXTURE_BUFFER);
+  _indexTexture = TexturePool::Upload(_indexTextureID, GL_TEXTURE_BUFFER);
+  // The index list can't grow past what the texture buffer can address
+  GLint max_texels;
+  glGetIntegerv(GL_MAX_TEXTURE_BUFFER_SIZE, &max_texels);
+  _maxIndices = max_texels;
+  // scratch space
+  _clusterLights.resize(CLUSTER_COUNT * CLUSTER_MAX_LIGHTS);
+  _clusterCounts.resize(CLUSTER_COUNT);
+  _lightData.reserve(MAXLIGHTS * CLUSTER_LIGHT_TEXELS * 4);
+  _lightBounds.reserve(MAXLIGHTS);
+  try {
+    GLenum gl_error = glGetError();
+    OPENGLERRORCHECK("LightCluster.cpp", "Initialize", "During light cluster creation", gl_error);
+  }
+  catch (const Error & error) {
+    ErrorLog::Write(error);
+  }
+}
+
+void LightCluster::Purge()
+{
+  // the pool deletes the buffer textures
+  TexturePool::Unload(_lightTexture);
+  TexturePool::Unload(_clusterTexture);
+  TexturePool::Unload(_indexTexture);
+  glDeleteBuffers(1, &_lightBuffer);
+  glDeleteBuffers(1, &_clusterBuffer);
+  glDeleteBuffers(1, &_indexBuffer);
+}
+
+// Bins the lights into the clusters of the given view and uploads the light
+// data, the cluster grid, and the light index list.
+void LightCluster::Build(const Math::Matrix4 & projection,
+  const Math::Matrix4 & view, float near_plane, float far_plane,
+  const Light * lights, int light_count)
+{
+  auto bin_start = std::chrono::high_resolution_clock::now();
+  // depth slice = log(depth) * scale - bias
+  _nearPlane = near_plane;
+  _farPlane = far_plane;
+  float log_ratio = std::log(far_plane / near_plane);
+  _depthScale = (float)CLUSTER_Z / log_ratio;
+  _depthBias = (float)CLUSTER_Z * std::log(near_plane) / log_ratio;
+  _tileWidth = (float)OpenGLContext::Width() / (float)CLUSTER_X;
+  _tileHeight = (float)OpenGLContext::Height() / (float)CLUSTER_Y;
+
+  // pack the light data and find the clusters each light touches
+  _lightData.resize(light_count * CLUSTER_LIGHT_TEXELS * 4);
+  _lightBounds.resize(light_count);
+  auto prepare_light = [&](unsigned int i)
+  {
+    const Light & light = lights[i];
+    float * data = &_lightData[i * CLUSTER_LIGHT_TEXELS * 4];
+    data[0] = light._position.x; data[1] = light._position.y;
+    data[2] = light._position.z; data[3] = (float)light._type;
+    data[4] = light._direction.x; data[5] = light._direction.y;
+    data[6] = light._direction.z; data[7] = light._spotExponent;
+    data[8] = light._ambientColor._r; data[9] = light._ambientColor._g;
+    data[10] = light._ambientColor._b; data[11] = light._innerAngle;
+    data[12] = light._diffuseColor._r; data[13] = light._diffuseColor._g;
+    data[14] = light._diffuseColor._b; data[15] = light._outerAngle;
+    data[16] = light._specularColor._r; data[17] = light._specularColor._g;
+    data[18] = light._specularColor._b; data[19] = light._attenuationC0;
+    data[20] = light._attenuationC1; data[21] = light._attenuationC2;
+    data[22] = 0.0f; data[23] = 0.0f;
+    FindBounds(projection, view, light, &_lightBounds[i]);
+  };
+  // Each depth slice is binned independently, so slices can be split
+  // between threads without any locking.
+  if (_parallel) {
+    ThreadPool::ParallelFor(light_count, prepare_light);
+    ThreadPool::ParallelFor(CLUSTER_Z, BinSlice);
+  }
+  else {
+    for (int i = 0; i < light_count; ++i)
+      prepare_light(i);
+    for (unsigned int slice = 0; slice < CLUSTER_Z; ++slice)
+      BinSlice(slice);
+  }
+
+  // compact the per cluster lists into a single index list
+  _indexData.clear();
+  _maxClusterLights = 0;
+  _droppedLights = 0;
+  for (int cluster = 0; cluster < CLUSTER_COUNT; ++cluster) {
+    int count = _clusterCounts[cluster];
+    if (count > CLUSTER_MAX_LIGHTS) {
+      _droppedLights += count - CLUSTER_MAX_LIGHTS;
+      count = CLUSTER_MAX_LIGHTS;
+    }
+    if ((int)_indexData.size() + count > _maxIndices) {
+      _droppedLights += (int)_indexData.size() + count - _maxIndices;
+      count = _maxIndices - (int)_indexData.size();
+    }
+    if (count > _maxClusterLights)
+      _maxClusterLights = count;
+    _clusterData[cluster * 2] = (GLuint)_indexData.size();
+    _clusterData[cluster * 2 + 1] = (GLuint)count;
+    const GLuint * cluster_lights = &_clusterLights[cluster * CLUSTER_MAX_LIGHTS];
+    _indexData.insert(_indexData.end(), cluster_lights, cluster_lights + count);
+  }
+  _indexCount = (int)_indexData.size();
+  auto upload_start = std::chrono::high_resolution_clock::now();
+
+  // upload everything
+  UploadBuffer(_lightBuffer, _lightData.data(),
+    _lightData.size() * sizeof(float), &_lightBufferCapacity);
+  UploadBuffer(_clusterBuffer, _clusterData.data(),
+    _clusterData.size() * sizeof(GLuint), &_clusterBufferCapacity);
+  UploadBuffer(_indexBuffer, _indexData.data(),
+    _indexData.size() * sizeof(GLuint), &_indexBufferCapacity);
+  auto upload_end = std::chrono::high_resolution_clock::now();
+  std::chrono::duration<float, std::milli> bin_time = upload_start - bin_start;
+  std::chrono::duration<float, std::milli> upload_time = upload_end - upload_start;
+  _binMilliseconds = bin_time.count();
+  _uploadMilliseconds = upload_time.count();
+}
+
+// Binds the light data, cluster grid, and index list to three consecutive
+// texture locations.
+void LightCluster::Bind(int first_location)
+{
+  TexturePool::Bind(_lightTexture, first_location);
+  TexturePool::Bind(_clusterTexture, first_location + 1);
+  TexturePool::Bind(_indexTexture, first_location + 2);
+}
+
+void LightCluster::Unbind()
+{
+  TexturePool::Unbind(_lightTexture);
+  TexturePool::Unbind(_clusterTexture);
+  TexturePool::Unbind(_indexTexture);
+}
+
+void LightCluster::SetUniforms(Shader * shader, int first_location)
+{
+  shader->SetUniform1i("ULightData", first_location);
+  shader->SetUniform1i("UClusterGrid", first_location + 1);
+  shader->SetUniform1i("ULightIndices", first_location + 2);
+  shader->SetUniform2f("UClusterTileSize", _tileWidth, _tileHeight);
+  shader->SetUniform1f("UClusterDepthScale", _depthScale);
+  shader->SetUniform1f("UClusterDepthBias", _depthBias);
+}
+
+void LightCluster::FindBounds(const Math::Matrix4 & projection,
+  const Math::Matrix4 & view, const Light & light, Bounds * bounds)
+{
+  // lights without a range reach every cluster
+  float range = light.Range();
+  if (range == FLT_MAX) {
+    bounds->_minX = 0; bounds->_maxX = CLUSTER_X - 1;
+    bounds->_minY = 0; bounds->_maxY = CLUSTER_Y - 1;
+    bounds->_minZ = 0; bounds->_maxZ = CLUSTER_Z - 1;
+    return;
+  }
+  // start with an empty range
+  bounds->_minX = 0; bounds->_maxX = -1;
+  bounds->_minY = 0; bounds->_maxY = -1;
+  bounds->_minZ = 0; bounds->_maxZ = -1;
+  if (range <= 0.0f)
+    return;
+  // view space center of the light's sphere
+  const Math::Vector3 & p = light._position;
+  float cx = view(0, 0) * p.x + view(0, 1) * p.y + view(0, 2) * p.z + view(0, 3);
+  float cy = view(1, 0) * p.x + view(1, 1) * p.y + view(1, 2) * p.z + view(1, 3);
+  float cz = view(2, 0) * p.x + view(2, 1) * p.y + view(2, 2) * p.z + view(2, 3);
+  // depth is positive in front of the camera
+  float near_depth = -cz - range;
+  float far_depth = -cz + range;
+  if (far_depth < _nearPlane || near_depth > _farPlane)
+    return;
+  int min_z = near_depth <= _nearPlane ? 0 : DepthSlice(near_depth);
+  int max_z = far_depth >= _farPlane ? CLUSTER_Z - 1 : DepthSlice(far_depth);
+  // The tiles are found from the screen space extents of the sphere's box.
+  // A sphere that crosses the near plane could cover any tile.
+  int min_x = 0, max_x = CLUSTER_X - 1;
+  int min_y = 0, max_y = CLUSTER_Y - 1;
+  if (near_depth > _nearPlane) {
+    float x_scale = projection(0, 0);
+    float y_scale = projection(1, 1);
+    float left = cx - range, right = cx + range;
+    float bottom = cy - range, top = cy + range;
+    // an extent is largest at the depth closest to the camera when it is
+    // away from the center of the screen, and at the farthest otherwise
+    float ndc_left = x_scale * left / (left < 0.0f ? near_depth : far_depth);
+    float ndc_right = x_scale * right / (right > 0.0f ? near_depth : far_depth);
+    float ndc_bottom = y_scale * bottom / (bottom < 0.0f ? near_depth : far_depth);
+    float ndc_top = y_scale * top / (top > 0.0f ? near_depth : far_depth);
+    if (ndc_right < -1.0f || ndc_left > 1.0f ||
+      ndc_top < -1.0f || ndc_bottom > 1.0f)
+      return;
+    min_x = (int)((ndc_left * 0.5f + 0.5f) * CLUSTER_X);
+    max_x = (int)((ndc_right * 0.5f + 0.5f) * CLUSTER_X);
+    min_y = (int)((ndc_bottom * 0.5f + 0.5f) * CLUSTER_Y);
+    max_y = (int)((ndc_top * 0.5f + 0.5f) * CLUSTER_Y);
+    min_x = min_x < 0 ? 0 : min_x;
+    min_y = min_y < 0 ? 0 : min_y;
+    max_x = max_x > CLUSTER_X - 1 ? CLUSTER_X - 1 : max_x;
+    max_y = max_y > CLUSTER_Y - 1 ? CLUSTER_Y - 1 : max_y;
+  }
+  bounds->_minX = min_x; bounds->_maxX = max_x;
+  bounds->_minY = min_y; bounds->_maxY = max_y;
+  bounds->_minZ = min_z; bounds->_maxZ = max_z;
+}
+
+int LightCluster::DepthSlice(float depth)
+{
+  int slice = (int)(std::log(depth) * _depthScale - _depthBias);
+  if (slice < 0)
+    return 0;
+  if (slice > CLUSTER_Z - 1)
+    return CLUSTER_Z - 1;
+  return slice;
+}
+
+// Writes the index of every light that touches a cluster in the given slice
+// to that cluster's list. Counts keep growing past the list size so dropped
+// lights can be reported.
+void LightCluster::BinSlice(unsigned int slice)
+{
+  int first_cluster = slice * CLUSTER_X * CLUSTER_Y;
+  for (int i = 0; i < CLUSTER_X * CLUSTER_Y; ++i)
+    _clusterCounts[first_cluster + i] = 0;
+  int slice_z = (int)slice;
+  int light_count = (int)_lightBounds.size();
+  for (int light = 0; light < light_count; ++light) {
+    const Bounds & bounds = _lightBounds[light];
+    if (slice_z < bounds._minZ || slice_z > bounds._maxZ)
+      continue;
+    for (int y = bounds._minY; y <= bounds._maxY; ++y) {
+      for (int x = bounds._minX; x <= bounds._maxX; ++x) {
+        int cluster = first_cluster + y * CLUSTER_X + x;
+        int & count = _clusterCounts[cluster];
+        if (count < CLUSTER_MAX_LIGHTS)
+          _clusterLights[cluster * CLUSTER_MAX_LIGHTS + count] = (GLuint)light;
+        ++count;
+      }
+    }
+  }
+}
+
+// Replaces the contents of a buffer. The storage is only reallocated when
+// the data no longer fits.
+void LightCluster::UploadBuffer(GLuint buffer, const void * data,
+  GLsizeiptr size, GLsizeiptr * capacity)
+{
+  glBindBuffer(GL_TEXTURE_BUFFER, buffer);
+  if (size > *capacity) {
+    glBufferData(GL_TEXTURE_BUFFER, size, data, GL_STREAM_DRAW);
+    *capacity = size;
+  }
+  else if (size > 0)
+    glBufferSubData(GL_TEXTURE_BUFFER, 0, size, data);
+  glBindBuffer(GL_TEXTURE_BUFFER, 0);
+}
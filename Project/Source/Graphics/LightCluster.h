@@ -0,0 +1,104 @@
+/* All content(c) 2017 - 2018 DigiPen(USA) Corporation, all rights reserved. */
+#ifndef LIGHTCLUSTER_H
+#define LIGHTCLUSTER_H
+
+#include <vector>
+#include <GL/glew.h>
+
+#include "../Math/Matrix4.h"
+#include "Shader/ShaderLibrary.h"
+#include "Texture/TexturePool.h"
+#include "Light.h"
+
+// The view frustum is split into a grid of clusters. X and Y are screen
+// tiles and Z is exponential depth slices between the near and far planes.
+// These must match the values in the phong and blinn fragment shaders.
+#define CLUSTER_X 16
+#define CLUSTER_Y 9
+#define CLUSTER_Z 24
+#define CLUSTER_COUNT (CLUSTER_X * CLUSTER_Y * CLUSTER_Z)
+// The most lights that can be binned to a single cluster
+#define CLUSTER_MAX_LIGHTS 256
+// The number of rgba texels used to store a single light
+#define CLUSTER_LIGHT_TEXELS 6
+
+/*****************************************************************************/
+/*!
+\class LightCluster
+\brief
+  Bins the active lights into the clusters of a view each frame. The light
+  data, the light index list of every cluster, and the lights themselves are
+  stored in texture buffers so fragment shaders only evaluate the lights that
+  reach their cluster.
+*/
+/*****************************************************************************/
+class LightCluster
+{
+public:
+  static void Initialize();
+  static void Purge();
+  static void Build(const Math::Matrix4 & projection,
+    const Math::Matrix4 & view, float near_plane, float far_plane,
+    const Light * lights, int light_count);
+  static void Bind(int first_location);
+  static void Unbind();
+  static void SetUniforms(Shader * shader, int first_location);
+  // Bins lights on the ThreadPool when true, otherwise on the main thread
+  static bool _parallel;
+  // Cpu time spent binning and uploading during the last build
+  static float _binMilliseconds;
+  static float _uploadMilliseconds;
+  // The number of light indices written during the last build
+  static int _indexCount;
+  // The most lights that were binned to a single cluster
+  static int _maxClusterLights;
+  // The number of light indices dropped because a cluster was full
+  static int _droppedLights;
+private:
+  LightCluster() {}
+  // The range of clusters a light touches. Empty when min > max.
+  struct Bounds
+  {
+    int _minX, _maxX;
+    int _minY, _maxY;
+    int _minZ, _maxZ;
+  };
+  static void FindBounds(const Math::Matrix4 & projection,
+    const Math::Matrix4 & view, const Light & light, Bounds * bounds);
+  static int DepthSlice(float depth);
+  static void BinSlice(unsigned int slice);
+  static void UploadBuffer(GLuint buffer, const void * data,
+    GLsizeiptr size, GLsizeiptr * capacity);
+  // Gpu buffers and the texture objects that read from them
+  static GLuint _lightBuffer;
+  static GLuint _clusterBuffer;
+  static GLuint _indexBuffer;
+  static GLsizeiptr _lightBufferCapacity;
+  static GLsizeiptr _clusterBufferCapacity;
+  static GLsizeiptr _indexBufferCapacity;
+  static GLuint _lightTextureID;
+  static GLuint _clusterTextureID;
+  static GLuint _indexTextureID;
+  static TextureObject * _lightTexture;
+  static TextureObject * _clusterTexture;
+  static TextureObject * _indexTexture;
+  // The most indices the index buffer texture can address
+  static int _maxIndices;
+  // Cpu side copies of the data that is uploaded
+  static std::vector<float> _lightData;
+  static std::vector<GLuint> _clusterData;
+  static std::vector<GLuint> _indexData;
+  // Scratch space used while binning
+  static std::vector<Bounds> _lightBounds;
+  static std::vector<GLuint> _clusterLights;
+  static std::vector<int> _clusterCounts;
+  // Depth slicing values for the current build
+  static float _nearPlane;
+  static float _farPlane;
+  static float _depthScale;
+  static float _depthBias;
+  static float _tileWidth;
+  static float _tileHeight;
+};
+
+#endif // !LIGHTCLUSTER_H
@@ -6,57 +6,74 @@ _diffuseFactor(1.0f), _specularFactor(1.0f), _specularExponent(3.0f),
 _environmentFactor(1.0f), _refractionIndex(1.66f), _chromaticAbberation(false),
 _chromaticOffset(0.0f), _fresnelReflection(false), _fresnelRatio(0.5),
 _textureMapping(false), _specularMapping(false), 
-_normalMapping(false), _environmentMapping(true), _mappingType(MAPSPHERICAL), 
+_normalMapping(false), _environmentMapping(true), _roughReflections(false),
+_virtualTexturing(false), _textureArray(false),
+_mappingType(MAPSPHERICAL), 
 _diffuseMap(0), _specularMap(1), 
-_normalMap(2), _up(3), _down(4), _left(5), _right(6), _front(7), _back(8)
+_normalMap(2), _environmentMap(3), _mapArray(13)
 {}
-void Material::SetUniforms(PhongShader * phong_shader)
+// Uniforms the shader does not use are skipped, so this works with any of
+// the lighting shaders and phong variants
+void Material::SetUniforms(Shader * shader)
 {
-  glUniform3f(phong_shader->UMaterial.UColor,
+  shader->BeginOptionalUniforms();
+  shader->SetUniform3f("UMaterial.UColor",
     _color._r, _color._g, _color._b);
-  // Material Factor s
-  glUniform1f(phong_shader->UMaterial.UAmbientFactor, _ambientFactor);
-  glUniform1f(phong_shader->UMaterial.UDiffuseFactor, _diffuseFactor);
-  glUniform1f(phong_shader->UMaterial.USpecularFactor, _specularFactor);
-  glUniform1f(phong_shader->UMaterial.USpecularExponent, _specularExponent);
-  glUniform1f(phong_shader->UMaterial.UEnvironmentFactor, _environmentFactor);
-  glUniform1f(phong_shader->UMaterial.URefractionIndex, _refractionIndex);
-  glUniform1i(phong_shader->UMaterial.UChromaticAbberation, _chromaticAbberation);
-  glUniform1f(phong_shader->UMaterial.UChromaticOffset, _chromaticOffset);
-  glUniform1i(phong_shader->UMaterial.UFresnelReflection, _fresnelReflection);
-  glUniform1f(phong_shader->UMaterial.UFresnelRatio, _fresnelRatio);
+  // Material Factors
+  shader->SetUniform1f("UMaterial.UAmbientFactor", _ambientFactor);
+  shader->SetUniform1f("UMaterial.UDiffuseFactor", _diffuseFactor);
+  shader->SetUniform1f("UMaterial.USpecularFactor", _specularFactor);
+  shader->SetUniform1f("UMaterial.USpecularExponent", _specularExponent);
+  shader->SetUniform1f("UMaterial.UEnvironmentFactor", _environmentFactor);
+  shader->SetUniform1f("UMaterial.URefractionIndex", _refractionIndex);
+  shader->SetUniform1i("UMaterial.UChromaticAbberation", _chromaticAbberation);
+  shader->SetUniform1f("UMaterial.UChromaticOffset", _chromaticOffset);
+  shader->SetUniform1i("UMaterial.UFresnelReflection", _fresnelReflection);
+  shader->SetUniform1f("UMaterial.UFresnelRatio", _fresnelRatio);
   // Mapping Types
-  glUniform1i(phong_shader->UMaterial.UTextureMapping, _textureMapping);
-  glUniform1i(phong_shader->UMaterial.USpecularMapping, _specularMapping);
-  glUniform1i(phong_shader->UMaterial.UNormalMapping, _normalMapping);
-  glUniform1i(phong_shader->UMaterial.UEnvironmentMapping, _environmentMapping);
-  glUniform1i(phong_shader->UMaterial.UMappingType, _mappingType);
+  shader->SetUniform1i("UMaterial.UTextureMapping", _textureMapping);
+  shader->SetUniform1i("UMaterial.USpecularMapping", _specularMapping);
+  shader->SetUniform1i("UMaterial.UNormalMapping", _normalMapping);
+  shader->SetUniform1i("UMaterial.UEnvironmentMapping", _environmentMapping);
+  shader->SetUniform1i("UMaterial.URoughReflections", _roughReflections);
+  shader->SetUniform1i("UMaterial.UVirtualTexturing", _virtualTexturing);
+  shader->SetUniform1i("UMaterial.UTextureArray", _textureArray);
+  shader->SetUniform1i("UMaterial.UMappingType", _mappingType);
   // Samplers
-  glUniform1i(phong_shader->UMaterial.UDiffuseMap, _diffuseMap);
-  glUniform1i(phong_shader->UMaterial.USpecularMap, _specularMap);
-  glUniform1i(phong_shader->UMaterial.UNormalMap, _normalMap);
-  glUniform1i(phong_shader->UMaterial.UUp, _up);
-  glUniform1i(phong_shader->UMaterial.UDown, _down);
-  glUniform1i(phong_shader->UMaterial.ULeft, _left);
-  glUniform1i(phong_shader->UMaterial.URight, _right);
-  glUniform1i(phong_shader->UMaterial.UFront, _front);
-  glUniform1i(phong_shader->UMaterial.UBack, _back);
+  shader->SetUniform1i("UMaterial.UDiffuseMap", _diffuseMap);
+  shader->SetUniform1i("UMaterial.USpecularMap", _specularMap);
+  shader->SetUniform1i("UMaterial.UNormalMap", _normalMap);
+  shader->SetUniform1i("UMaterial.UEnvironmentMap", _environmentMap);
+  shader->SetUniform1i("UMaterial.UMapArray", _mapArray);
+  shader->EndOptionalUniforms();
 }
-void Material::SetUniforms(GouraudShader * gouraud_shader)
+// Finds the phong variant features this material uses. Options that only
+// matter when another feature is enabled are left out so materials that look
+// the same share a variant.
+unsigned int Material::PhongFeatures() const
 {
-  glUniform3f(gouraud_shader->UMaterial.UColor,
-    _color._r, _color._g, _color._b);
-  glUniform1f(gouraud_shader->UMaterial.UAmbientFactor, _ambientFactor);
-  glUniform1f(gouraud_shader->UMaterial.UDiffuseFactor, _diffuseFactor);
-  glUniform1f(gouraud_shader->UMaterial.USpecularFactor, _specularFactor);
-  glUniform1f(gouraud_shader->UMaterial.USpecularExponent, _specularExponent);
-}
-void Material::SetUniforms(BlinnShader * blinn_shader)
-{
-  glUniform3f(blinn_shader->UMaterial.UColor,
-    _color._r, _color._g, _color._b);
-  glUniform1f(blinn_shader->UMaterial.UAmbientFactor, _ambientFactor);
-  glUniform1f(blinn_shader->UMaterial.UDiffuseFactor, _diffuseFactor);
-  glUniform1f(blinn_shader->UMaterial.USpecularFactor, _specularFactor);
-  glUniform1f(blinn_shader->UMaterial.USpecularExponent, _specularExponent);
+  unsigned int features = 0;
+  if (_textureMapping)
+    features |= PHONG_TEXTURE_MAPPING;
+  if (_specularMapping)
+    features |= PHONG_SPECULAR_MAPPING;
+  if (_normalMapping)
+    features |= PHONG_NORMAL_MAPPING;
+  if (_textureMapping || _specularMapping || _normalMapping) {
+    features |= (_mappingType << PHONG_MAPPING_SHIFT) & PHONG_MAPPING_MASK;
+    if (_virtualTexturing)
+      features |= PHONG_VIRTUAL_TEXTURING;
+    else if (_textureArray)
+      features |= PHONG_TEXTURE_ARRAY;
+  }
+  if (_environmentMapping) {
+    features |= PHONG_ENVIRONMENT_MAPPING;
+    if (_roughReflections)
+      features |= PHONG_ROUGH_REFLECTIONS;
+    if (_chromaticAbberation)
+      features |= PHONG_CHROMATIC_ABBERATION;
+    if (_fresnelReflection)
+      features |= PHONG_FRESNEL_REFLECTION;
+  }
+  return features;
 }
\ No newline at end of file
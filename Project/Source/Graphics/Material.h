@@ -14,9 +14,8 @@
 struct Material
 {
   Material();
-  void SetUniforms(PhongShader * phong_shader);
-  void SetUniforms(GouraudShader * gouraud_shader);
-  void SetUniforms(BlinnShader * blinn_shader);
+  void SetUniforms(Shader * shader);
+  unsigned int PhongFeatures() const;
   Color _color;
   // Material factors
   float _ambientFactor;
@@ -34,15 +33,16 @@ struct Material
   bool _specularMapping;
   bool _normalMapping;
   bool _environmentMapping;
+  bool _roughReflections;
+  // The maps are sampled through the renderer's virtual textures
+  bool _virtualTexturing;
+  // The maps are sampled from the renderer's texture array with one bind
+  bool _textureArray;
   int _mappingType;
   // samplers
   int _diffuseMap;
   int _specularMap;
   int _normalMap;
-  int _up;
-  int _down; 
-  int _left; 
-  int _right;
-  int _front;
-  int _back;
+  int _environmentMap;
+  int _mapArray;
 };
\ No newline at end of file
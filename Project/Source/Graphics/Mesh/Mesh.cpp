@@ -56,6 +56,7 @@ Mesh::Mesh(const std::string & file_name, FileType type, int mapping_type)
   default:
     break;
   }
+  CalculateBoundingVolumes();
 
   // calculating normals
   CalculateFaceNormals();
@@ -160,6 +161,26 @@ void Mesh::SetNormalLineLengthMeshRelative(float new_length)
   _normalLineMagnitude = new_length;
 }
 
+const Math::Vector3 & Mesh::BoundingBoxMin() const
+{
+  return _boundingBoxMin;
+}
+
+const Math::Vector3 & Mesh::BoundingBoxMax() const
+{
+  return _boundingBoxMax;
+}
+
+const Math::Vector3 & Mesh::BoundingSphereCenter() const
+{
+  return _boundingSphereCenter;
+}
+
+float Mesh::BoundingSphereRadius() const
+{
+  return _boundingSphereRadius;
+}
+
 unsigned Mesh::VertexCount()
 {
   return _vertices.size();
@@ -297,6 +318,36 @@ inline void Mesh::PerformPlanarMapping()
   }
 }
 
+void Mesh::CalculateBoundingVolumes()
+{
+  if (_vertices.empty()) {
+    _boundingBoxMin.Splat(0.0f);
+    _boundingBoxMax.Splat(0.0f);
+    _boundingSphereCenter.Splat(0.0f);
+    _boundingSphereRadius = 0.0f;
+    return;
+  }
+  const Vertex & first = _vertices[0];
+  _boundingBoxMin.Set(first.px, first.py, first.pz);
+  _boundingBoxMax = _boundingBoxMin;
+  for (const Vertex & vert : _vertices) {
+    Math::Vector3 position(vert.px, vert.py, vert.pz);
+    _boundingBoxMin = Math::Min(_boundingBoxMin, position);
+    _boundingBoxMax = Math::Max(_boundingBoxMax, position);
+  }
+  // the sphere is centered on the box, but the radius only reaches the
+  // farthest vertex rather than the corners of the box
+  _boundingSphereCenter = (_boundingBoxMin + _boundingBoxMax) * 0.5f;
+  float radius_sq = 0.0f;
+  for (const Vertex & vert : _vertices) {
+    Math::Vector3 position(vert.px, vert.py, vert.pz);
+    float distance_sq = Math::LengthSq(position - _boundingSphereCenter);
+    if (distance_sq > radius_sq)
+      radius_sq = distance_sq;
+  }
+  _boundingSphereRadius = sqrt(radius_sq);
+}
+
 inline void Mesh::CalculateFaceNormals()
 {
   unsigned num_faces = _faces.size();
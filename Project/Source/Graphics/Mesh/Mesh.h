@@ -109,11 +109,17 @@ public:
   void * FaceBitangentLineData();
   unsigned FaceBitangentLineSizeBytes();
   unsigned FaceBitangentLineSizeVertices();
+  // bounding volume getters (model space)
+  const Math::Vector3 & BoundingBoxMin() const;
+  const Math::Vector3 & BoundingBoxMax() const;
+  const Math::Vector3 & BoundingSphereCenter() const;
+  float BoundingSphereRadius() const;
 private:
   void CalculateFaceNormals();
   void CalculateVertexNormals();
   void CalculateFaceTangentsBitangents();
   void CalculateVertexTangentsBitangents();
+  void CalculateBoundingVolumes();
   void CreateVertexAdjacencies();
   void RemoveParallelAdjacencies(std::vector<unsigned> * adjacencies);
   void LoadObj(const std::string & file_name);
@@ -138,6 +144,11 @@ private:
   std::vector<Line> _faceNormalLines;
   std::vector<Line> _faceTangentLines;
   std::vector<Line> _faceBitangentLines;
+  //! The axis aligned box and sphere that contain every vertex.
+  Math::Vector3 _boundingBoxMin;
+  Math::Vector3 _boundingBoxMax;
+  Math::Vector3 _boundingSphereCenter;
+  float _boundingSphereRadius;
   
 
 
@@ -1,9 +1,13 @@
 /* All content(c) 2017 DigiPen(USA) Corporation, all rights reserved. */
 #include "../../Math/Matrix4.h"
 #include "../../Utility/Error.h"
+#include "../VertexFormat.h"
 
 #include "MeshRenderer.h"
 
+// The directory the shader files are read from and watched in
+#define SHADER_PATH "Resource/Shader/"
+
 // static initializations
 Color MeshRenderer::_emissiveColor(0.0f, 0.0f, 0.0f);
 Color MeshRenderer::_globalAmbientColor(0.2f, 0.2f, 0.2f);
@@ -12,22 +16,31 @@ float MeshRenderer::_fogNear = 10.0f;
 float MeshRenderer::_fogFar = 20.0f;
 float MeshRenderer::_nearPlane = 0.1f;
 float MeshRenderer::_farPlane = 20.0f;
+bool MeshRenderer::_phongVariants = true;
+bool MeshRenderer::_watchShaders = true;
 unsigned int MeshRenderer::_meshObjectsAdded = 0;
 std::unordered_set<MeshRenderer::MeshObject *> MeshRenderer::_meshObjects;
 LineShader * MeshRenderer::_lineShader = nullptr;
 SolidShader * MeshRenderer::_solidShader = nullptr;
+InstancedSolidShader * MeshRenderer::_instancedSolidShader = nullptr;
 PhongShader * MeshRenderer::_phongShader = nullptr;
+std::unordered_map<unsigned int, PhongShader *>
+  MeshRenderer::_phongVariantCache;
 GouraudShader * MeshRenderer::_gouraudShader = nullptr;
 BlinnShader * MeshRenderer::_blinnShader = nullptr;
+Shader * MeshRenderer::_reloads[NUMSHADERTYPES] = { nullptr };
+FileWatcher MeshRenderer::_shaderWatcher;
 
 
 void MeshRenderer::Initialize()
 { 
   _lineShader = new LineShader();
   _solidShader = new SolidShader();
+  _instancedSolidShader = new InstancedSolidShader();
   _phongShader = new PhongShader();
   _gouraudShader = new GouraudShader();
   _blinnShader = new BlinnShader();
+  _shaderWatcher.Start(SHADER_PATH);
 }
 
 /*****************************************************************************/
@@ -43,6 +56,8 @@ void MeshRenderer::Purge()
     glDeleteBuffers(1, &mesh_object->_vbo);
     glDeleteBuffers(1, &mesh_object->_ebo);
     glDeleteVertexArrays(1, &mesh_object->_vao);
+    glDeleteBuffers(1, &mesh_object->_vboInstance);
+    glDeleteVertexArrays(1, &mesh_object->_vaoInstanced);
     // freeing normal line buffers
     glDeleteBuffers(1, &mesh_object->_vboVertexNormal);
     glDeleteVertexArrays(1, &mesh_object->_vaoVertexNormal);
@@ -54,11 +69,22 @@ void MeshRenderer::Purge()
   // deallocating all shaders
   _lineShader->Purge();
   _solidShader->Purge();
+  _instancedSolidShader->Purge();
   _phongShader->Purge();
   _gouraudShader->Purge();
   _blinnShader->Purge();
+  PurgePhongVariants();
+  _shaderWatcher.Stop();
+  for (int i = 0; i < NUMSHADERTYPES; ++i) {
+    if (_reloads[i]) {
+      _reloads[i]->Purge();
+      delete _reloads[i];
+      _reloads[i] = nullptr;
+    }
+  }
   delete _lineShader;
   delete _solidShader;
+  delete _instancedSolidShader;
   delete _phongShader;
   delete _gouraudShader;
   delete _blinnShader;
@@ -89,20 +115,8 @@ MeshRenderer::MeshObject * MeshRenderer::Upload(Mesh * mesh)
   glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
   glBufferData(GL_ELEMENT_ARRAY_BUFFER, mesh->IndexDataSizeBytes(), 
     mesh->IndexData(), GL_STATIC_DRAW);
-  // enable all vertex attributes
-  //_solidShader->EnableAttributes();
-  //_gouraudShader->EnableAttributes();
-  //_blinnShader->EnableAttributes();
-  // These can't all happen at the same time. The reason it was working
-  // earlier is due to the fact that the last EnableAttributes set up the
-  // attributes in such a way that they were correct for each shader.
-  // AKA, they overwrote the EnableAttribute calls made prior.
-  // If shaders are meant to use the same vertex buffer of data and process 
-  // it to do whatever, those shaders NEED to use the same attribute layouts
-  // within the buffer or they won't work. Might be wise to have a set of 
-  // attributes that ALL shaders will have regardless of their type. All
-  // shaders that share a common buffer type that is.
-  _phongShader->EnableAttributes();
+  // every shader reads the mesh through the same vertex format
+  VertexFormat::_mesh.Enable();
   glBindVertexArray(0);
   glBindBuffer(GL_ARRAY_BUFFER, 0);
   glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
@@ -139,6 +153,10 @@ MeshRenderer::MeshObject * MeshRenderer::Upload(Mesh * mesh)
     vbo_fn, vao_fn, mesh->FaceNormalLineSizeVertices(),
     vbo_ft, vao_ft, mesh->FaceTangentLineSizeVertices(),
     vbo_fb, vao_fb, mesh->FaceBitangentLineSizeVertices());
+  new_mesh_object->_boundingBoxMin = mesh->BoundingBoxMin();
+  new_mesh_object->_boundingBoxMax = mesh->BoundingBoxMax();
+  new_mesh_object->_boundingSphereCenter = mesh->BoundingSphereCenter();
+  new_mesh_object->_boundingSphereRadius = mesh->BoundingSphereRadius();
 
   _meshObjects.insert(new_mesh_object);
   _meshObjectsAdded++;
@@ -151,6 +169,8 @@ void MeshRenderer::Unload(MeshObject * mesh_object)
   glDeleteBuffers(1, &mesh_object->_vbo);
   glDeleteBuffers(1, &mesh_object->_ebo);
   glDeleteVertexArrays(1, &mesh_object->_vao);
+  glDeleteBuffers(1, &mesh_object->_vboInstance);
+  glDeleteVertexArrays(1, &mesh_object->_vaoInstanced);
   // freeing normal line buffers
   glDeleteBuffers(1, &mesh_object->_vboVertexNormal);
   glDeleteVertexArrays(1, &mesh_object->_vaoVertexNormal);
@@ -169,57 +189,67 @@ void MeshRenderer::Render(MeshObject * mesh_object, ShaderType shader_type,
   switch (shader_type)
   {
   // PHONG SHADING 
-  case ShaderType::PHONG:
-    _phongShader->Use();
-    mesh_object->_material.SetUniforms(_phongShader);
-    glUniformMatrix4fv(_phongShader->UProjection, 1, GL_TRUE, projection.array);
-    glUniformMatrix4fv(_phongShader->UView, 1, GL_TRUE, view.array);
-    glUniformMatrix4fv(_phongShader->UModel, 1, GL_TRUE, model.array);
-    glUniform3f(_phongShader->UEmissiveColor,
+  case ShaderType::PHONG: {
+    PhongShader * phong_shader = GetPhongShader(mesh_object->_material);
+    if (!phong_shader->Ready())
+      return;
+    phong_shader->Use();
+    mesh_object->_material.SetUniforms(phong_shader);
+    phong_shader->SetUniformMatrix4("UProjection", projection);
+    phong_shader->SetUniformMatrix4("UView", view);
+    phong_shader->SetUniformMatrix4("UModel", model);
+    phong_shader->SetUniform3f("UEmissiveColor",
       _emissiveColor._r, _emissiveColor._g, _emissiveColor._b);
-    glUniform3f(_phongShader->UGlobalAmbientColor,
+    phong_shader->SetUniform3f("UGlobalAmbientColor",
       _globalAmbientColor._r, _globalAmbientColor._g, _globalAmbientColor._b);
-    glUniform3f(_phongShader->UFogColor, 
+    phong_shader->SetUniform3f("UFogColor", 
       _fogColor._r, _fogColor._g, _fogColor._b);
-    glUniform1f(_phongShader->UNearPlane, _fogNear);
-    glUniform1f(_phongShader->UFarPlane, _fogFar);
+    phong_shader->SetUniform1f("UNearPlane", _fogNear);
+    phong_shader->SetUniform1f("UFarPlane", _fogFar);
     break;
+  }
   // GOURAUD SHADING
   case ShaderType::GOURAUD:
+    if (!_gouraudShader->Ready())
+      return;
     _gouraudShader->Use();
-    glUniformMatrix4fv(_gouraudShader->UProjection, 1, GL_TRUE, projection.array);
-    glUniformMatrix4fv(_gouraudShader->UView, 1, GL_TRUE, view.array);
-    glUniformMatrix4fv(_gouraudShader->UModel, 1, GL_TRUE, model.array);
-    glUniform3f(_gouraudShader->UEmissiveColor,
+    _gouraudShader->SetUniformMatrix4("UProjection", projection);
+    _gouraudShader->SetUniformMatrix4("UView", view);
+    _gouraudShader->SetUniformMatrix4("UModel", model);
+    _gouraudShader->SetUniform3f("UEmissiveColor",
       _emissiveColor._r, _emissiveColor._g, _emissiveColor._b);
-    glUniform3f(_gouraudShader->UGlobalAmbientColor,
+    _gouraudShader->SetUniform3f("UGlobalAmbientColor",
       _globalAmbientColor._r, _globalAmbientColor._g, _globalAmbientColor._b);
-    glUniform3f(_gouraudShader->UFogColor,
+    _gouraudShader->SetUniform3f("UFogColor",
       _fogColor._r, _fogColor._g, _fogColor._b);
-    glUniform1f(_gouraudShader->UNearPlane, _fogNear);
-    glUniform1f(_gouraudShader->UFarPlane, _fogFar);
+    _gouraudShader->SetUniform1f("UNearPlane", _fogNear);
+    _gouraudShader->SetUniform1f("UFarPlane", _fogFar);
     break;
   // BLINN SHADING
   case ShaderType::BLINN:
+    if (!_blinnShader->Ready())
+      return;
     _blinnShader->Use();
-    glUniformMatrix4fv(_blinnShader->UProjection, 1, GL_TRUE, projection.array);
-    glUniformMatrix4fv(_blinnShader->UView, 1, GL_TRUE, view.array);
-    glUniformMatrix4fv(_blinnShader->UModel, 1, GL_TRUE, model.array);
-    glUniform3f(_blinnShader->UEmissiveColor,
+    _blinnShader->SetUniformMatrix4("UProjection", projection);
+    _blinnShader->SetUniformMatrix4("UView", view);
+    _blinnShader->SetUniformMatrix4("UModel", model);
+    _blinnShader->SetUniform3f("UEmissiveColor",
       _emissiveColor._r, _emissiveColor._g, _emissiveColor._b);
-    glUniform3f(_blinnShader->UGlobalAmbientColor,
+    _blinnShader->SetUniform3f("UGlobalAmbientColor",
       _globalAmbientColor._r, _globalAmbientColor._g, _globalAmbientColor._b);
-    glUniform3f(_blinnShader->UFogColor,
+    _blinnShader->SetUniform3f("UFogColor",
       _fogColor._r, _fogColor._g, _fogColor._b);
-    glUniform1f(_blinnShader->UNearPlane, _fogNear);
-    glUniform1f(_blinnShader->UFarPlane, _fogFar);
+    _blinnShader->SetUniform1f("UNearPlane", _fogNear);
+    _blinnShader->SetUniform1f("UFarPlane", _fogFar);
     break;
   // SOLID SHADING
   case ShaderType::SOLID:
+    if (!_solidShader->Ready())
+      return;
     _solidShader->Use();
-    glUniformMatrix4fv(_solidShader->UProjection, 1, GL_TRUE, projection.array);
-    glUniformMatrix4fv(_solidShader->UView, 1, GL_TRUE, view.array);
-    glUniformMatrix4fv(_solidShader->UModel, 1, GL_TRUE, model.array);
+    _solidShader->SetUniformMatrix4("UProjection", projection);
+    _solidShader->SetUniformMatrix4("UView", view);
+    _solidShader->SetUniformMatrix4("UModel", model);
     break;
   default:
     break;
@@ -235,13 +265,15 @@ void MeshRenderer::Render(MeshObject * mesh_object, ShaderType shader_type,
   glBindVertexArray(0);
 
   // drawing normal lines
+  if (!_lineShader->Ready())
+    return;
   if(mesh_object->_showVertexNormals || mesh_object->_showVertexTangents || 
     mesh_object->_showVertexBitangents || mesh_object->_showFaceNormals ||
     mesh_object->_showFaceTangents || mesh_object->_showFaceBitangents){
     _lineShader->Use();
-    glUniformMatrix4fv(_lineShader->UProjection, 1, GL_TRUE, projection.array);
-    glUniformMatrix4fv(_lineShader->UView, 1, GL_TRUE, view.array);
-    glUniformMatrix4fv(_lineShader->UModel, 1, GL_TRUE, model.array);
+    _lineShader->SetUniformMatrix4("UProjection", projection);
+    _lineShader->SetUniformMatrix4("UView", view);
+    _lineShader->SetUniformMatrix4("UModel", model);
   }
   if (mesh_object->_showVertexNormals) {
     // vertex normals
@@ -276,58 +308,187 @@ void MeshRenderer::Render(MeshObject * mesh_object, ShaderType shader_type,
 
 }
 
+/*****************************************************************************/
+/*!
+\brief
+  Draws many copies of a mesh with a single draw call. Each instance has its
+  own model matrix and color. The instance data is streamed into a buffer
+  owned by the mesh object, which only grows when more instances are drawn
+  than it has space for.
+
+\param mesh_object
+  The mesh that is drawn for every instance.
+\param instances
+  The per instance model matrices and colors.
+\param instance_count
+  The number of instances to draw.
+\param projection
+  The projection matrix.
+\param view
+  The view matrix.
+*/
+/*****************************************************************************/
+void MeshRenderer::RenderInstanced(MeshObject * mesh_object,
+  const Instance * instances, unsigned int instance_count,
+  const Math::Matrix4 & projection, const Math::Matrix4 & view)
+{
+  // the instance attribute layout expects a tightly packed matrix and color
+  static_assert(sizeof(Instance) == 19 * sizeof(GLfloat),
+    "Instance must match the InstancedSolidShader attribute layout");
+  if (instance_count == 0 || !_instancedSolidShader->Ready())
+    return;
+  // the instanced vao shares the vertex and index buffers of the mesh
+  if (mesh_object->_vaoInstanced == 0) {
+    glGenVertexArrays(1, &mesh_object->_vaoInstanced);
+    glGenBuffers(1, &mesh_object->_vboInstance);
+    glBindVertexArray(mesh_object->_vaoInstanced);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh_object->_ebo);
+    glBindBuffer(GL_ARRAY_BUFFER, mesh_object->_vbo);
+    VertexFormat::_mesh.Enable();
+    glBindBuffer(GL_ARRAY_BUFFER, mesh_object->_vboInstance);
+    VertexFormat::_instance.Enable();
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+  }
+  // upload instance data
+  glBindBuffer(GL_ARRAY_BUFFER, mesh_object->_vboInstance);
+  GLsizeiptr data_size = instance_count * sizeof(Instance);
+  if (instance_count > mesh_object->_instanceCapacity) {
+    glBufferData(GL_ARRAY_BUFFER, data_size, instances, GL_STREAM_DRAW);
+    mesh_object->_instanceCapacity = instance_count;
+  }
+  else
+    glBufferSubData(GL_ARRAY_BUFFER, 0, data_size, instances);
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+  // draw all instances
+  _instancedSolidShader->Use();
+  _instancedSolidShader->SetUniformMatrix4("UProjection",
+    projection);
+  _instancedSolidShader->SetUniformMatrix4("UView", view);
+  glBindVertexArray(mesh_object->_vaoInstanced);
+  if (mesh_object->_showWireframe)
+    glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
+  glDrawElementsInstanced(GL_TRIANGLES, mesh_object->_elements,
+    GL_UNSIGNED_INT, nullptr, instance_count);
+  glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+  glBindVertexArray(0);
+}
+
+/*****************************************************************************/
+/*!
+\brief
+  Starts rebuilding a shader from its files. The shader in use is not
+  replaced until the rebuilt shader is ready, which is checked by
+  UpdateReloads. If the rebuild fails, the shader in use is kept.
+
+\param shader_type
+  The type of shader to rebuild.
+*/
+/*****************************************************************************/
 void MeshRenderer::ReloadShader(ShaderType shader_type)
 {
-  // getting base shader type
-  Shader * shader_to_reload;
+  // the files are read from disk again in case they changed
+  switch (shader_type)
+  {
+  case PHONG: _phongShader->InvalidateFiles(); break;
+  case GOURAUD: _gouraudShader->InvalidateFiles(); break;
+  case BLINN: _blinnShader->InvalidateFiles(); break;
+  default: break;
+  }
+  StartReload(shader_type);
+}
+
+// Creates the shader that will replace the shader in use once it is ready
+void MeshRenderer::StartReload(ShaderType shader_type)
+{
+  Shader * reload;
   switch (shader_type)
   {
   case PHONG:
-    shader_to_reload = _phongShader;
+    reload = new PhongShader();
     break;
   case GOURAUD:
-    shader_to_reload = _gouraudShader;
+    reload = new GouraudShader();
     break;
   case BLINN:
-    shader_to_reload = _blinnShader;
+    reload = new BlinnShader();
     break;
   default:
-    Error error("MeshRenderer.cpp", "ReloadShader");
+    Error error("MeshRenderer.cpp", "StartReload");
     error.Add("ShaderType cannot be reloaded.");
     throw(error);
   }
-  // disabling vertex attributes
-  for (MeshObject * mesh_object : _meshObjects) {
-    glBindVertexArray(mesh_object->_vao);
-    shader_to_reload->DisableAttributes();
-    glBindVertexArray(0);
+  // a newer rebuild replaces one that has not finished
+  if (_reloads[shader_type]) {
+    _reloads[shader_type]->Purge();
+    delete _reloads[shader_type];
   }
-  // creating new shader
-  switch (shader_type)
-  {
-  case PHONG:
-    delete _phongShader;
-    _phongShader = new PhongShader();
-    shader_to_reload = _phongShader;
-    break;
-  case GOURAUD:
-    delete _gouraudShader;
-    _gouraudShader = new GouraudShader();
-    shader_to_reload = _gouraudShader;
-    break;
-  case BLINN:
-    delete _blinnShader;
-    _blinnShader = new BlinnShader();
-    shader_to_reload = _blinnShader;
-    break;
+  _reloads[shader_type] = reload;
+}
+
+/*****************************************************************************/
+/*!
+\brief
+  Starts rebuilding the shaders whose files changed and swaps in the rebuilt
+  shaders that are ready. Call this at the start of a frame so a shader is
+  never replaced in the middle of one. Vertex arrays do not depend on the
+  shader, so nothing else changes when a shader is replaced. A changed
+  include file only rebuilds the shaders that include it.
+*/
+/*****************************************************************************/
+void MeshRenderer::UpdateReloads()
+{
+  std::vector<std::string> changes;
+  _shaderWatcher.TakeChanges(&changes);
+  for (const std::string & change : changes)
+    Shader::InvalidateFile(SHADER_PATH + change);
+  if (_watchShaders) {
+    Shader * shaders[3] = { _phongShader, _gouraudShader, _blinnShader };
+    ShaderType types[3] = { PHONG, GOURAUD, BLINN };
+    for (int i = 0; i < 3; ++i) {
+      for (const std::string & change : changes) {
+        if (shaders[i]->UsesFile(change)) {
+          StartReload(types[i]);
+          break;
+        }
+      }
+    }
   }
-  // re-enabling vertex attributes
-  for (MeshObject * mesh_object : _meshObjects) {
-    glBindBuffer(GL_ARRAY_BUFFER, mesh_object->_vbo);
-    glBindVertexArray(mesh_object->_vao);
-    _phongShader->EnableAttributes();
-    glBindVertexArray(0);
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
+  for (int i = 0; i < NUMSHADERTYPES; ++i) {
+    Shader * reload = _reloads[i];
+    if (!reload)
+      continue;
+    if (!reload->Ready()) {
+      // the error was written to the ErrorLog, so the old shader is kept
+      if (!reload->Pending()) {
+        reload->Purge();
+        delete reload;
+        _reloads[i] = nullptr;
+      }
+      continue;
+    }
+    Shader * old_shader;
+    switch (i)
+    {
+    case PHONG:
+      old_shader = _phongShader;
+      _phongShader = (PhongShader *)reload;
+      // the variants are compiled from the new files when they are next used
+      PurgePhongVariants();
+      break;
+    case GOURAUD:
+      old_shader = _gouraudShader;
+      _gouraudShader = (GouraudShader *)reload;
+      break;
+    default:
+      old_shader = _blinnShader;
+      _blinnShader = (BlinnShader *)reload;
+      break;
+    }
+    old_shader->Purge();
+    delete old_shader;
+    _reloads[i] = nullptr;
   }
 }
 
@@ -336,11 +497,68 @@ SolidShader * MeshRenderer::GetSolidShader()
   return _solidShader;
 }
 
+InstancedSolidShader * MeshRenderer::GetInstancedSolidShader()
+{
+  return _instancedSolidShader;
+}
+
 PhongShader * MeshRenderer::GetPhongShader()
 {
   return _phongShader;
 }
 
+/*****************************************************************************/
+/*!
+\brief
+  Finds the phong shader that should be used for drawing with a material.
+  Variants are compiled the first time their features are used and are
+  cached after that.
+
+\param material
+  The material that will be drawn with the shader.
+
+\return The material's phong variant, or the phong shader that branches on
+  material uniforms when variants are disabled or the variant is not ready.
+*/
+/*****************************************************************************/
+PhongShader * MeshRenderer::GetPhongShader(const Material & material)
+{
+  if (!_phongVariants)
+    return _phongShader;
+  unsigned int features = material.PhongFeatures();
+  std::unordered_map<unsigned int, PhongShader *>::iterator it =
+    _phongVariantCache.find(features);
+  PhongShader * variant;
+  if (it == _phongVariantCache.end()) {
+    variant = new PhongShader(features);
+    _phongVariantCache[features] = variant;
+  }
+  else
+    variant = it->second;
+  if (!variant->Ready())
+    return _phongShader;
+  return variant;
+}
+
+// Checks whether every shader used by the MeshRenderer is ready without
+// waiting for any of them
+bool MeshRenderer::ShadersReady()
+{
+  bool ready = true;
+  ready = _lineShader->Ready() && ready;
+  ready = _solidShader->Ready() && ready;
+  ready = _instancedSolidShader->Ready() && ready;
+  ready = _phongShader->Ready() && ready;
+  ready = _gouraudShader->Ready() && ready;
+  ready = _blinnShader->Ready() && ready;
+  return ready;
+}
+
+unsigned int MeshRenderer::PhongVariantCount()
+{
+  return (unsigned int)_phongVariantCache.size();
+}
+
 GouraudShader * MeshRenderer::GetGouraudShader()
 {
   return _gouraudShader;
@@ -398,7 +616,7 @@ inline void MeshRenderer::UploadLineBuffer(GLuint * vbo, GLuint * vao,
   glBindVertexArray(*vao);
   glBindBuffer(GL_ARRAY_BUFFER, *vbo);
   glBufferData(GL_ARRAY_BUFFER, data_size, data, GL_STATIC_DRAW);
-  _lineShader->EnableAttributes();
+  VertexFormat::_line.Enable();
   glBindVertexArray(0);
   glBindBuffer(GL_ARRAY_BUFFER, 0);
 }
@@ -406,8 +624,18 @@ inline void MeshRenderer::UploadLineBuffer(GLuint * vbo, GLuint * vao,
 inline void MeshRenderer::DisplayLineBuffer(const Color & color, GLuint vao,
   unsigned int num_vertices)
 {
-  glUniform3f(_lineShader->ULineColor, color._r, color._g, color._b);
+  _lineShader->SetUniform3f("ULineColor", color._r, color._g, color._b);
   glBindVertexArray(vao);
   glDrawArrays(GL_LINES, 0, num_vertices);
   glBindVertexArray(0);
 }
+
+void MeshRenderer::PurgePhongVariants()
+{
+  for (const std::pair<const unsigned int, PhongShader *> & variant :
+    _phongVariantCache) {
+    variant.second->Purge();
+    delete variant.second;
+  }
+  _phongVariantCache.clear();
+}
\ No newline at end of file
@@ -2,9 +2,11 @@
 #pragma once
 //FLEEB
 //mesh objects should have the material
+#include <unordered_map>
 #include <unordered_set>
 #include <GL\glew.h>
  
+#include "../../Core/FileWatcher.h"
 #include "../../Math/Matrix4.h"
 #include "../Shader/ShaderLibrary.h"
 #include "../Color.h"
@@ -41,6 +43,7 @@ public:
       GLuint vbo_ft, GLuint vao_ft, unsigned int vertices_ft,
       GLuint vbo_fb, GLuint vao_fb, unsigned int vertices_fb):
       _vbo(vbo), _ebo(ebo), _vao(vao), _elements(elements),
+      _vaoInstanced(0), _vboInstance(0), _instanceCapacity(0),
       _vboVertexNormal(vbo_vn), _vaoVertexNormal(vao_vn),
       _vertexNormalVertexCount(vertices_vn),
       _vboVertexTangent(vbo_vt), _vaoVertexTangent(vao_vt),
@@ -73,6 +76,17 @@ public:
     GLuint _vao;
     //! The number of elements in the EBO
     unsigned int _elements;
+    //! Model space bounding volumes used for culling
+    Math::Vector3 _boundingBoxMin;
+    Math::Vector3 _boundingBoxMax;
+    Math::Vector3 _boundingSphereCenter;
+    float _boundingSphereRadius;
+    //! VAO and per instance VBO used for instanced draws. These are only
+    // created once the mesh is drawn with instancing.
+    GLuint _vaoInstanced;
+    GLuint _vboInstance;
+    //! The number of instances the instance VBO has space for
+    unsigned int _instanceCapacity;
     //! Vertex Normal line buffer info
     GLuint _vboVertexNormal;
     GLuint _vaoVertexNormal;
@@ -123,6 +137,19 @@ public:
     Color _faceBitangentColor;
 
   };
+  /***************************************************************************/
+  /*!
+  \class Instance
+  \brief
+    The per instance data used when drawing many copies of a mesh with a
+    single draw call.
+  */
+  /***************************************************************************/
+  struct Instance
+  {
+    Math::Matrix4 _model;
+    Color _color;
+  };
 public:
   enum ShaderType
   {
@@ -140,6 +167,11 @@ public:
   static float _fogFar;
   static float _nearPlane;
   static float _farPlane;
+  // When true, phong shading uses a variant with the material's features
+  // compiled in rather than the shader that branches on material uniforms
+  static bool _phongVariants;
+  // When true, shaders are rebuilt when their files change
+  static bool _watchShaders;
 public:
   static void Initialize();
   static void Purge();
@@ -148,19 +180,29 @@ public:
   static void Render(MeshObject * mesh_object, ShaderType shader_type,
     const Math::Matrix4 & projection, const Math::Matrix4 & view, 
     const Math::Matrix4 & model);
+  static void RenderInstanced(MeshObject * mesh_object,
+    const Instance * instances, unsigned int instance_count,
+    const Math::Matrix4 & projection, const Math::Matrix4 & view);
   static void ReloadShader(ShaderType shader_type);
+  static void UpdateReloads();
   static SolidShader * GetSolidShader();
+  static InstancedSolidShader * GetInstancedSolidShader();
   static PhongShader * GetPhongShader();
+  static PhongShader * GetPhongShader(const Material & material);
+  static unsigned int PhongVariantCount();
+  static bool ShadersReady();
   static GouraudShader * GetGouraudShader();
   static BlinnShader * GetBlinnShader();
   static LineShader * GetLineShader();
   static int ShaderTypeToInt(ShaderType shader_type);
   static ShaderType IntToShaderType(int shader_int);
 private:
+  static void StartReload(ShaderType shader_type);
   static void UploadLineBuffer(GLuint * vbo, GLuint * vao, void * data, 
     unsigned int data_size);
   static void DisplayLineBuffer(const Color & color, GLuint vao, 
     unsigned int num_vertices);
+  static void PurgePhongVariants();
   //! The vector of currently loaded Mesh objects
   static std::unordered_set<MeshObject *> _meshObjects;
   //! The number of mesh objects that have been added to the MeshRenderer
@@ -169,8 +211,16 @@ private:
   static LineShader * _lineShader;
   //! The shader used for drawing single color meshes
   static SolidShader * _solidShader;
+  //! The shader used for drawing instances of single color meshes
+  static InstancedSolidShader * _instancedSolidShader;
   //! The shader used for Phong
   static PhongShader * _phongShader;
+  //! Phong variants that have been compiled, keyed by their features
+  static std::unordered_map<unsigned int, PhongShader *> _phongVariantCache;
+  //! Shaders that are being rebuilt to replace the shader of their type
+  static Shader * _reloads[NUMSHADERTYPES];
+  //! Watches the shader directory for changed files
+  static FileWatcher _shaderWatcher;
   //! The shader used for Gouraud
   static GouraudShader * _gouraudShader;
   //! The shader used for Blinn
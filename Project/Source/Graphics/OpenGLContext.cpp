@@ -56,6 +56,9 @@ void OpenGLContext::Initialize()
   SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 3);
   // Clearing error log due to false positive
   glGetError();
+  // let the driver build shaders on as many threads as it wants
+  if (GLEW_ARB_parallel_shader_compile)
+    glMaxShaderCompilerThreadsARB(0xFFFFFFFF);
   AdjustViewport();
 
 }
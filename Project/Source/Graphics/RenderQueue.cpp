@@ -0,0 +1,190 @@
+/* All content(c) 2017 - 2018 DigiPen(USA) Corporation, all rights reserved. */
+#include "RenderQueue.h"
+
+#define SORTKEY_DEPTH_SHIFT 0
+#define SORTKEY_VAO_SHIFT (SORTKEY_DEPTH_SHIFT + SORTKEY_DEPTH_BITS)
+#define SORTKEY_MATERIAL_SHIFT (SORTKEY_VAO_SHIFT + SORTKEY_VAO_BITS)
+#define SORTKEY_PROGRAM_SHIFT (SORTKEY_MATERIAL_SHIFT + SORTKEY_MATERIAL_BITS)
+#define SORTKEY_PASS_SHIFT (SORTKEY_PROGRAM_SHIFT + SORTKEY_PROGRAM_BITS)
+// The radix sort looks at a byte of the keys on each pass
+#define RADIX_BITS 8
+#define RADIX_BUCKETS (1 << RADIX_BITS)
+#define RADIX_PASSES (64 / RADIX_BITS)
+
+// The value of a field of a key
+static unsigned int Field(unsigned long long key, int shift, int bits)
+{
+  return (unsigned int)((key >> shift) & ((1ull << bits) - 1));
+}
+
+RenderQueue::RenderQueue() : _passChanges(0), _programChanges(0),
+  _materialChanges(0), _vaoChanges(0)
+{}
+
+/*****************************************************************************/
+/*!
+\brief
+  Packs the state of a draw into a sort key.
+
+\param pass
+  The pass the draw belongs to. Lower passes are drawn first.
+\param program
+  The gl program the draw uses.
+\param material
+  An id for the textures and material uniforms the draw uses.
+\param vao
+  The gl vertex array the draw uses.
+\param depth
+  The distance to the draw from 0 at the near plane to 1 at the far plane.
+\param back_to_front
+  When true, farther draws come first.
+
+\return The sort key.
+*/
+/*****************************************************************************/
+unsigned long long RenderQueue::Key(unsigned int pass, unsigned int program,
+  unsigned int material, unsigned int vao, float depth, bool back_to_front)
+{
+  const unsigned int max_depth = (1u << SORTKEY_DEPTH_BITS) - 1;
+  if (depth < 0.0f)
+    depth = 0.0f;
+  if (depth > 1.0f)
+    depth = 1.0f;
+  unsigned int quantized = (unsigned int)(depth * (float)max_depth);
+  if (back_to_front)
+    quantized = max_depth - quantized;
+  unsigned long long key = 0;
+  key |= (unsigned long long)(pass & ((1u << SORTKEY_PASS_BITS) - 1)) <<
+    SORTKEY_PASS_SHIFT;
+  key |= (unsigned long long)(program & ((1u << SORTKEY_PROGRAM_BITS) - 1)) <<
+    SORTKEY_PROGRAM_SHIFT;
+  key |= (unsigned long long)(material &
+    ((1u << SORTKEY_MATERIAL_BITS) - 1)) << SORTKEY_MATERIAL_SHIFT;
+  key |= (unsigned long long)(vao & ((1u << SORTKEY_VAO_BITS) - 1)) <<
+    SORTKEY_VAO_SHIFT;
+  key |= (unsigned long long)quantized << SORTKEY_DEPTH_SHIFT;
+  return key;
+}
+
+unsigned int RenderQueue::Pass(unsigned long long key)
+{
+  return Field(key, SORTKEY_PASS_SHIFT, SORTKEY_PASS_BITS);
+}
+
+unsigned int RenderQueue::Program(unsigned long long key)
+{
+  return Field(key, SORTKEY_PROGRAM_SHIFT, SORTKEY_PROGRAM_BITS);
+}
+
+unsigned int RenderQueue::Material(unsigned long long key)
+{
+  return Field(key, SORTKEY_MATERIAL_SHIFT, SORTKEY_MATERIAL_BITS);
+}
+
+unsigned int RenderQueue::Vao(unsigned long long key)
+{
+  return Field(key, SORTKEY_VAO_SHIFT, SORTKEY_VAO_BITS);
+}
+
+// Removes every draw. The memory is kept for the next frame.
+void RenderQueue::Clear()
+{
+  _items.clear();
+}
+
+void RenderQueue::Push(unsigned long long key, unsigned int payload)
+{
+  Item item = { key, payload };
+  _items.push_back(item);
+}
+
+/*****************************************************************************/
+/*!
+\brief
+  Sorts the draws by their keys with a least significant digit radix sort.
+  The counts of every byte are found in one pass over the draws, and bytes
+  that are the same in every key are skipped, so keys that only differ in a
+  few fields take few passes.
+*/
+/*****************************************************************************/
+void RenderQueue::Sort()
+{
+  unsigned int count = (unsigned int)_items.size();
+  if (count < 2)
+    return;
+  unsigned int counts[RADIX_PASSES][RADIX_BUCKETS] = { { 0 } };
+  for (const Item & item : _items) {
+    for (int pass = 0; pass < RADIX_PASSES; ++pass)
+      ++counts[pass][(item._key >> (pass * RADIX_BITS)) & (RADIX_BUCKETS - 1)];
+  }
+  _scratch.resize(count);
+  Item * source = _items.data();
+  Item * destination = _scratch.data();
+  for (int pass = 0; pass < RADIX_PASSES; ++pass) {
+    unsigned int * pass_counts = counts[pass];
+    int shift = pass * RADIX_BITS;
+    // every key has the same byte, so the order would not change
+    unsigned int first_byte = (source[0]._key >> shift) & (RADIX_BUCKETS - 1);
+    if (pass_counts[first_byte] == count)
+      continue;
+    unsigned int offsets[RADIX_BUCKETS];
+    unsigned int offset = 0;
+    for (int bucket = 0; bucket < RADIX_BUCKETS; ++bucket) {
+      offsets[bucket] = offset;
+      offset += pass_counts[bucket];
+    }
+    for (unsigned int i = 0; i < count; ++i) {
+      unsigned int byte = (source[i]._key >> shift) & (RADIX_BUCKETS - 1);
+      destination[offsets[byte]++] = source[i];
+    }
+    Item * swap = source;
+    source = destination;
+    destination = swap;
+  }
+  if (source != _items.data())
+    _items.swap(_scratch);
+}
+
+/*****************************************************************************/
+/*!
+\brief
+  Gives every draw to a function in the order of the queue, along with the
+  state that differs from the previous draw. The first draw changes all of
+  it.
+
+\param submit
+  Called with each draw and the RENDERQUEUE_*_CHANGED flags of the draw.
+*/
+/*****************************************************************************/
+void RenderQueue::Submit(
+  const std::function<void(const Item &, unsigned int)> & submit)
+{
+  _passChanges = 0;
+  _programChanges = 0;
+  _materialChanges = 0;
+  _vaoChanges = 0;
+  unsigned long long previous = 0;
+  for (unsigned int i = 0; i < _items.size(); ++i) {
+    const Item & item = _items[i];
+    unsigned int changes = 0;
+    if (i == 0 || Pass(item._key) != Pass(previous))
+      changes |= RENDERQUEUE_PASS_CHANGED;
+    if (i == 0 || Program(item._key) != Program(previous))
+      changes |= RENDERQUEUE_PROGRAM_CHANGED;
+    if (i == 0 || Material(item._key) != Material(previous))
+      changes |= RENDERQUEUE_MATERIAL_CHANGED;
+    if (i == 0 || Vao(item._key) != Vao(previous))
+      changes |= RENDERQUEUE_VAO_CHANGED;
+    _passChanges += (changes & RENDERQUEUE_PASS_CHANGED) ? 1 : 0;
+    _programChanges += (changes & RENDERQUEUE_PROGRAM_CHANGED) ? 1 : 0;
+    _materialChanges += (changes & RENDERQUEUE_MATERIAL_CHANGED) ? 1 : 0;
+    _vaoChanges += (changes & RENDERQUEUE_VAO_CHANGED) ? 1 : 0;
+    submit(item, changes);
+    previous = item._key;
+  }
+}
+
+unsigned int RenderQueue::Size() const
+{
+  return (unsigned int)_items.size();
+}
@@ -0,0 +1,72 @@
+/* All content(c) 2017 - 2018 DigiPen(USA) Corporation, all rights reserved. */
+#ifndef RENDERQUEUE_H
+#define RENDERQUEUE_H
+
+#include <functional>
+#include <vector>
+
+// The bits of each field of a sort key. From the most significant bits to
+// the least, a key holds the pass, program, material, vertex array, and
+// depth, so draws are grouped by the state that is the most expensive to
+// change and are front to back within a group.
+#define SORTKEY_PASS_BITS 4
+#define SORTKEY_PROGRAM_BITS 12
+#define SORTKEY_MATERIAL_BITS 16
+#define SORTKEY_VAO_BITS 12
+#define SORTKEY_DEPTH_BITS 20
+// The flags given to the submit function for the state that differs from
+// the previous draw
+#define RENDERQUEUE_PASS_CHANGED 1
+#define RENDERQUEUE_PROGRAM_CHANGED 2
+#define RENDERQUEUE_MATERIAL_CHANGED 4
+#define RENDERQUEUE_VAO_CHANGED 8
+
+/*****************************************************************************/
+/*!
+\class RenderQueue
+\brief
+  Collects the draws of a frame as 64 bit sort keys with a payload, sorts
+  them with a radix sort, and hands them back in order so that state is
+  only changed when it differs from the previous draw.
+
+\par Important Notes
+  - Ids that do not fit in their field are wrapped. Two ids that wrap to the
+    same value are grouped together, which only costs state changes.
+  - Depth is quantized from 0 to 1. Keys made with back_to_front invert it
+    for draws that have to be blended.
+  - The sort is stable, so draws with equal keys keep their push order.
+*/
+/*****************************************************************************/
+class RenderQueue
+{
+public:
+  struct Item
+  {
+    unsigned long long _key;
+    unsigned int _payload;
+  };
+  RenderQueue();
+  static unsigned long long Key(unsigned int pass, unsigned int program,
+    unsigned int material, unsigned int vao, float depth,
+    bool back_to_front = false);
+  static unsigned int Pass(unsigned long long key);
+  static unsigned int Program(unsigned long long key);
+  static unsigned int Material(unsigned long long key);
+  static unsigned int Vao(unsigned long long key);
+  void Clear();
+  void Push(unsigned long long key, unsigned int payload);
+  void Sort();
+  void Submit(const std::function<void(const Item &, unsigned int)> & submit);
+  unsigned int Size() const;
+  // The state changes made by the last Submit
+  int _passChanges;
+  int _programChanges;
+  int _materialChanges;
+  int _vaoChanges;
+private:
+  std::vector<Item> _items;
+  //! Where each radix pass writes. Kept so its memory is reused.
+  std::vector<Item> _scratch;
+};
+
+#endif // !RENDERQUEUE_H
@@ -0,0 +1,138 @@
+/* All content(c) 2017 - 2018 DigiPen(USA) Corporation, all rights reserved. */
+#include "../Utility/Error.h"
+#include "RenderTargetPool.h"
+
+// static initializations
+int RenderTargetPool::_unusedFrames = RENDERTARGET_UNUSED_FRAMES;
+std::vector<RenderTargetPool::PassUsage> RenderTargetPool::_passUsage;
+long long RenderTargetPool::_residentBytes = 0;
+long long RenderTargetPool::_requestedBytes = 0;
+int RenderTargetPool::_residentTargets = 0;
+int RenderTargetPool::_creations = 0;
+int RenderTargetPool::_deletions = 0;
+std::vector<RenderTargetPool::Target *> RenderTargetPool::_targets;
+std::vector<RenderTargetPool::PassUsage> RenderTargetPool::_currentUsage;
+unsigned int RenderTargetPool::_frame = 0;
+
+/*****************************************************************************/
+/*!
+\brief
+  Gives a pass a render target until it is released. A released target with
+  the same size and format is reused before a new one is created.
+
+\param pass
+  The name of the pass the memory is reported under.
+\param width
+  The width of the target.
+\param height
+  The height of the target.
+\param internal_format
+  The format of the target's color texture.
+
+\return The framebuffer of the target.
+*/
+/*****************************************************************************/
+Framebuffer * RenderTargetPool::Acquire(const std::string & pass,
+  unsigned int width, unsigned int height, GLint internal_format)
+{
+  Target * target = nullptr;
+  for (Target * candidate : _targets) {
+    if (!candidate->_acquired && candidate->_format == internal_format &&
+      candidate->_framebuffer._width == width &&
+      candidate->_framebuffer._height == height) {
+      target = candidate;
+      break;
+    }
+  }
+  bool aliased = target && target->_lastUsed == _frame;
+  if (!target) {
+    target = new Target();
+    target->_framebuffer.Initialize(width, height, internal_format);
+    target->_format = internal_format;
+    _targets.push_back(target);
+    _residentBytes += target->_framebuffer.Bytes();
+    ++_residentTargets;
+    ++_creations;
+  }
+  target->_acquired = true;
+  target->_lastUsed = _frame;
+  // the memory is reported under the pass that acquired it
+  PassUsage * usage = nullptr;
+  for (PassUsage & current : _currentUsage) {
+    if (current._pass == pass)
+      usage = &current;
+  }
+  if (!usage) {
+    PassUsage new_usage = { pass, 0, 0, 0 };
+    _currentUsage.push_back(new_usage);
+    usage = &_currentUsage.back();
+  }
+  usage->_bytes += target->_framebuffer.Bytes();
+  ++usage->_targets;
+  if (aliased)
+    ++usage->_aliased;
+  return &target->_framebuffer;
+}
+
+// Lets passes that come later acquire the target
+void RenderTargetPool::Release(Framebuffer * framebuffer)
+{
+  for (Target * target : _targets) {
+    if (&target->_framebuffer == framebuffer) {
+      target->_acquired = false;
+      return;
+    }
+  }
+  Error error("RenderTargetPool.cpp", "Release");
+  error.Add("The framebuffer was not acquired from the pool.");
+  throw(error);
+}
+
+/*****************************************************************************/
+/*!
+\brief
+  Finishes the frame. What the passes acquired becomes the usage of the last
+  full frame and targets that have not been acquired for _unusedFrames
+  frames are deleted.
+*/
+/*****************************************************************************/
+void RenderTargetPool::Update()
+{
+  _passUsage.swap(_currentUsage);
+  _currentUsage.clear();
+  _requestedBytes = 0;
+  for (const PassUsage & usage : _passUsage)
+    _requestedBytes += usage._bytes;
+  ++_frame;
+  unsigned int i = 0;
+  while (i < _targets.size()) {
+    Target * target = _targets[i];
+    if (!target->_acquired &&
+      _frame - target->_lastUsed > (unsigned int)_unusedFrames)
+      Destroy(i);
+    else
+      ++i;
+  }
+}
+
+void RenderTargetPool::Purge()
+{
+  while (!_targets.empty())
+    Destroy((unsigned int)_targets.size() - 1);
+  _passUsage.clear();
+  _currentUsage.clear();
+  _requestedBytes = 0;
+}
+
+// Deletes a target and its gl objects
+void RenderTargetPool::Destroy(unsigned int index)
+{
+  Target * target = _targets[index];
+  _residentBytes -= target->_framebuffer.Bytes();
+  --_residentTargets;
+  ++_deletions;
+  target->_framebuffer.Purge();
+  delete target;
+  _targets[index] = _targets.back();
+  _targets.pop_back();
+}
@@ -0,0 +1,82 @@
+/* All content(c) 2017 - 2018 DigiPen(USA) Corporation, all rights reserved. */
+#ifndef RENDERTARGETPOOL_H
+#define RENDERTARGETPOOL_H
+
+#include <string>
+#include <vector>
+#include <GL/glew.h>
+#include "Framebuffer.h"
+
+// The default number of frames a render target can go without being
+// acquired before it is deleted
+#define RENDERTARGET_UNUSED_FRAMES 60
+
+/*****************************************************************************/
+/*!
+\class RenderTargetPool
+\brief
+  Hands out framebuffers that passes only need for part of a frame. A pass
+  acquires a target by its size and format, renders into it, and releases
+  it once nothing later in the frame reads it. A later pass asking for the
+  same size and format gets the released target, so passes whose lifetimes
+  do not overlap share the same video memory.
+
+\par Important Notes
+  - Update must be called once a frame. Targets that were not acquired for
+    _unusedFrames frames are deleted then.
+  - The contents of an acquired target are whatever the last pass that used
+    it left there, so a pass that needs a cleared target clears it.
+  - The memory every pass acquired is kept for the last full frame in
+    _passUsage.
+*/
+/*****************************************************************************/
+class RenderTargetPool
+{
+public:
+  // The memory a pass acquired during a frame
+  struct PassUsage
+  {
+    std::string _pass;
+    long long _bytes;
+    // The targets the pass acquired and how many of them were released by
+    // an earlier pass in the same frame
+    int _targets;
+    int _aliased;
+  };
+  static Framebuffer * Acquire(const std::string & pass, unsigned int width,
+    unsigned int height, GLint internal_format = GL_RGB);
+  static void Release(Framebuffer * framebuffer);
+  static void Update();
+  static void Purge();
+  // The frames a target can go unused before it is deleted
+  static int _unusedFrames;
+  // What every pass acquired during the last full frame
+  static std::vector<PassUsage> _passUsage;
+  // The memory used by every target in the pool and the memory the passes of
+  // the last frame would have used if no targets were shared
+  static long long _residentBytes;
+  static long long _requestedBytes;
+  static int _residentTargets;
+  // The targets created and deleted since the pool was started
+  static int _creations;
+  static int _deletions;
+private:
+  struct Target
+  {
+    Framebuffer _framebuffer;
+    GLint _format;
+    bool _acquired;
+    //! The frame the target was last acquired in
+    unsigned int _lastUsed;
+  };
+  static void Destroy(unsigned int index);
+  //! Every target, acquired or not
+  static std::vector<Target *> _targets;
+  //! What the passes have acquired so far this frame
+  static std::vector<PassUsage> _currentUsage;
+  //! Counts the calls to Update
+  static unsigned int _frame;
+  RenderTargetPool();
+};
+
+#endif // !RENDERTARGETPOOL_H
@@ -1,20 +1,40 @@
 /* All content(c) 2017 - 2018 DigiPen(USA) Corporation, all rights reserved. */
 #include "Renderer.h"
 
+#include <chrono>
+#include <random>
+#include "../Core/Time.h"
 #include "../Editor/Editor.h"
 #include "../Math/MathFunctions.h"
 #include "../Utility/OpenGLError.h"
+#include "Shader/ShaderManager.h"
+#include "LightCluster.h"
+#include "OpenGLContext.h"
+#include "RenderTargetPool.h"
 
+#define SKYBOX_PATH "Resource/Texture/Skybox/"
 #define PI 3.141592653589f
 #define PI2 6.28318530718f
 
-// framebuffer locations in environment render vector
-#define FB_UP 0 // up
-#define FB_DN 1 // down
-#define FB_LT 2 // left
-#define FB_RT 3 // right
-#define FB_FT 4 // front
-#define FB_BK 5 // back
+// The size of each face of the environment cubemap
+#define ENVIRONMENT_SIZE 512
+// The number of mip levels in the environment cubemap (512 down to 1)
+#define ENVIRONMENT_LEVELS 10
+// The size and number of mip levels of the prefiltered environment cubemap.
+// The last level is 4x4 and holds the roughest reflections.
+#define PREFILTER_SIZE 128
+#define PREFILTER_LEVELS 6
+// The first texture unit used by the virtual textures. Each one uses two
+// units, so they follow the light cluster textures in units 7 to 12.
+#define VIRTUAL_TEXTURE_LOCATION 7
+// The layers of the render queue and the draws its payloads stand for
+#define BACKGROUND_LAYER 0
+#define OPAQUE_LAYER 1
+#define SKYBOX_DRAW 0
+#define LIGHTS_DRAW 1
+#define MESH_DRAW 2
+// The render queue's id for the material of the mesh
+#define MESH_MATERIAL 1
 
 // static initializations
 Mesh * Renderer::_mesh = nullptr;
@@ -24,11 +44,61 @@ MeshRenderer::MeshObject * Renderer::_sphereMeshObject = nullptr;
 TextureObject * Renderer::_diffuseTextureObject = nullptr;
 TextureObject * Renderer::_specularTextureObject = nullptr;
 TextureObject * Renderer::_normalTextureObject = nullptr;
+bool Renderer::_generatedNormalMap = false;
+float Renderer::_normalMapStrength = 2.0f / 255.0f;
+bool Renderer::_normalMapDirty = true;
+GPUTimer Renderer::_normalMapTimer;
+TextureObject * Renderer::_heightTextureObject = nullptr;
+Framebuffer Renderer::_normalMapFramebuffer;
+VirtualTexture Renderer::_virtualDiffuse;
+VirtualTexture Renderer::_virtualSpecular;
+VirtualTexture Renderer::_virtualNormal;
+FeedbackBuffer Renderer::_feedbackBuffer;
+TextureArray Renderer::_materialArray;
+std::vector<unsigned short> Renderer::_feedback;
 
 bool Renderer::_renderSkybox = true;
 Skybox * Renderer::_skybox = nullptr;
 
 std::vector<Renderer::EnvironmentRender> Renderer::_environmentRenders;
+Framebuffer Renderer::_environmentFramebuffer;
+Renderer::EnvironmentUpdate Renderer::_environmentUpdate = Renderer::ON_CHANGE;
+float Renderer::_environmentUpdateRate = 0.0f;
+int Renderer::_environmentFacesRendered = 0;
+std::vector<float> Renderer::_environmentState;
+Skybox * Renderer::_environmentSkybox = nullptr;
+float Renderer::_environmentInvalidationTime = 0.0f;
+unsigned int Renderer::_nextEnvironmentFace = 0;
+bool Renderer::_prefilterEnvironment = false;
+Framebuffer Renderer::_prefilterFramebuffer;
+int Renderer::_prefilterFacesPerFrame = 6;
+unsigned int Renderer::_prefilterFacesComplete = 0;
+GLuint Renderer::_emptyVAO = 0;
+unsigned int Renderer::_nextPrefilterFace = 0;
+bool Renderer::_frustumCulling = true;
+int Renderer::_testedObjects[RENDER_PASSES] = { 0 };
+int Renderer::_culledObjects[RENDER_PASSES] = { 0 };
+std::vector<MeshRenderer::Instance> Renderer::_lightInstances;
+GPUTimer Renderer::_environmentTimer;
+GPUTimer Renderer::_prefilterTimer;
+GPUTimer Renderer::_skyboxTimer;
+GPUTimer Renderer::_meshTimer;
+FrameGraph Renderer::_frameGraph;
+RenderQueue Renderer::_renderQueue;
+bool Renderer::_benchmarkPhongVariants = false;
+GPUTimer Renderer::_uberTimer;
+GPUTimer Renderer::_variantTimer;
+float Renderer::_serialSkyboxMilliseconds = 0.0f;
+float Renderer::_requestSkyboxMilliseconds = 0.0f;
+float Renderer::_normalMapThroughput = 0.0f;
+float Renderer::_stbDecodeMilliseconds = 0.0f;
+float Renderer::_decoderMilliseconds = 0.0f;
+int Renderer::_queueBenchmarkDraws = RENDERQUEUE_BENCHMARK_DRAWS;
+float Renderer::_queueSortMilliseconds = 0.0f;
+float Renderer::_queueSubmitMilliseconds = 0.0f;
+float Renderer::_unsortedSubmitMilliseconds = 0.0f;
+int Renderer::_queueStateChanges = 0;
+int Renderer::_unsortedStateChanges = 0;
 
 #include <iostream>
 
@@ -40,18 +110,32 @@ void Renderer::Initialize(Mesh & mesh)
   _sphereMeshObject = MeshRenderer::Upload(&sphere_mesh);
 
   // texture stuff
-  _diffuseTextureObject = TexturePool::Upload("Resource/Texture/diffuse.tga");
-  _specularTextureObject = TexturePool::Upload("Resource/Texture/specular.tga");
-  _normalTextureObject = TexturePool::Upload("Resource/Texture/normal.png");
+  _diffuseTextureObject = TexturePool::Request("Resource/Texture/diffuse.tga");
+  _specularTextureObject =
+    TexturePool::Request("Resource/Texture/specular.tga");
+  // the placeholder is a flat normal
+  _normalTextureObject = TexturePool::Request("Resource/Texture/normal.png",
+    Color(0.5f, 0.5f, 1.0f), TexturePool::NORMAL_MAP);
+  // the generated normal map is made from the heights of the specular map.
+  // The heights are uploaded without compression so they keep every bit, and
+  // the normal map framebuffer is made once their size is known.
+  _heightTextureObject = TexturePool::Request("Resource/Texture/specular.tga",
+    Color(0.0f, 0.0f, 0.0f), TexturePool::HEIGHT_MAP);
+  _feedbackBuffer.Initialize(OpenGLContext::Width() / FEEDBACK_DIVISOR,
+    OpenGLContext::Height() / FEEDBACK_DIVISOR);
 
   // skybox
-  _skybox = new Skybox("Resource/Texture/Skybox/Crater/",
+  _skybox = new Skybox(SKYBOX_PATH "Crater/",
     "up.tga", "dn.tga", "lf.tga", "rt.tga", "ft.tga", "bk.tga");
   _skybox->Upload();
 
-  // initializing environment framebuffers
+  // initializing environment framebuffer
+  _environmentFramebuffer.InitializeCubemap(ENVIRONMENT_SIZE, ENVIRONMENT_LEVELS);
+  _prefilterFramebuffer.InitializeCubemap(PREFILTER_SIZE, PREFILTER_LEVELS);
+  glGenVertexArrays(1, &_emptyVAO);
   // Creating the linear parts of the view matrices used for
-  // environment rendering
+  // environment rendering. These follow the orientation OpenGL expects for
+  // each cubemap face.
   Math::Vector4 pos_x(1.0f, 0.0f, 0.0f, 0.0f);
   Math::Vector4 pos_y(0.0f, 1.0f, 0.0f, 0.0f);
   Math::Vector4 pos_z(0.0f, 0.0f, 1.0f, 0.0f);
@@ -59,26 +143,37 @@ void Renderer::Initialize(Mesh & mesh)
   Math::Vector4 neg_y(0.0f, -1.0f, 0.0f, 0.0f);
   Math::Vector4 neg_z(0.0f, 0.0f, -1.0f, 0.0f);
   Math::Vector4 basis_w(0.0f, 0.0f, 0.0f, 1.0f);
+  Math::Matrix4 right(neg_z, neg_y, neg_x, basis_w);
+  right.Transpose();
+  Math::Matrix4 left(pos_z, neg_y, pos_x, basis_w);
+  left.Transpose();
   Math::Matrix4 up(pos_x, pos_z, neg_y, basis_w);
   up.Transpose();
   Math::Matrix4 down(pos_x, neg_z, pos_y, basis_w);
   down.Transpose();
-  Math::Matrix4 left(neg_z, pos_y, pos_x, basis_w);
-  left.Transpose();
-  Math::Matrix4 right(pos_z, pos_y, neg_x, basis_w);
-  right.Transpose();
-  Math::Matrix4 front(pos_x, pos_y, pos_z, basis_w);
-  front.Transpose();
-  Math::Matrix4 back(neg_x, pos_y, neg_z, basis_w);
+  Math::Matrix4 back(pos_x, neg_y, neg_z, basis_w);
   back.Transpose();
+  Math::Matrix4 front(neg_x, neg_y, pos_z, basis_w);
+  front.Transpose();
   // creating environment render instances
   _environmentRenders.reserve(6);
-  _environmentRenders.push_back(EnvironmentRender(512, 512, up));
-  _environmentRenders.push_back(EnvironmentRender(512, 512, down));
-  _environmentRenders.push_back(EnvironmentRender(512, 512, left));
-  _environmentRenders.push_back(EnvironmentRender(512, 512, right));
-  _environmentRenders.push_back(EnvironmentRender(512, 512, front));
-  _environmentRenders.push_back(EnvironmentRender(512, 512, back));
+  _environmentRenders.push_back(EnvironmentRender(right));
+  _environmentRenders.push_back(EnvironmentRender(left));
+  _environmentRenders.push_back(EnvironmentRender(up));
+  _environmentRenders.push_back(EnvironmentRender(down));
+  _environmentRenders.push_back(EnvironmentRender(back));
+  _environmentRenders.push_back(EnvironmentRender(front));
+
+  // timers
+  _environmentTimer.Initialize();
+  _prefilterTimer.Initialize();
+  _skyboxTimer.Initialize();
+  _meshTimer.Initialize();
+  _uberTimer.Initialize();
+  _variantTimer.Initialize();
+  // the normal map is made inside the frame graph's pass timers
+  _normalMapTimer.Initialize(true);
+  LightCluster::Initialize();
 }
 
 void Renderer::Purge()
@@ -87,8 +182,27 @@ void Renderer::Purge()
   TexturePool::Unload(_diffuseTextureObject);
   TexturePool::Unload(_specularTextureObject);
   TexturePool::Unload(_normalTextureObject);
+  TexturePool::Unload(_heightTextureObject);
+  _normalMapFramebuffer.Purge();
+  _environmentFramebuffer.Purge();
+  _prefilterFramebuffer.Purge();
+  _virtualDiffuse.Purge();
+  _virtualSpecular.Purge();
+  _virtualNormal.Purge();
+  _feedbackBuffer.Purge();
+  _materialArray.Purge();
   _skybox->Unload();
   delete _skybox;
+  _environmentTimer.Purge();
+  _prefilterTimer.Purge();
+  _skyboxTimer.Purge();
+  glDeleteVertexArrays(1, &_emptyVAO);
+  _meshTimer.Purge();
+  _uberTimer.Purge();
+  _variantTimer.Purge();
+  _normalMapTimer.Purge();
+  _frameGraph.Purge();
+  LightCluster::Purge();
 }
 
 void Renderer::Clear()
@@ -98,8 +212,30 @@ void Renderer::Clear()
   glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 }
 
+void Renderer::InvalidateEnvironment()
+{
+  for (EnvironmentRender & er : _environmentRenders)
+    er._valid = false;
+}
+
 void Renderer::RenderEnvironment()
 {
+  // Faces are only rendered again once they are invalid, so nothing is
+  // rendered until every shader that can appear in them is ready.
+  if (!ShaderManager::_skybox->Ready() || !MeshRenderer::ShadersReady())
+    return;
+  // find the faces that no longer match the environment
+  if (_environmentUpdate == ALWAYS)
+    InvalidateEnvironment();
+  else
+    UpdateEnvironmentValidity();
+  // time slicing only renders a single face per frame
+  unsigned int max_faces = (unsigned int)_environmentRenders.size();
+  if (_environmentUpdate == TIME_SLICED)
+    max_faces = 1;
+  _environmentFacesRendered = 0;
+  _environmentTimer.Start();
+
   // custom projection for square texture (90 fov)
   Math::Matrix4 environment_projection = Math::Matrix4::Perspective(PI / 2.0f,
     1.0f, MeshRenderer::_nearPlane, MeshRenderer::_farPlane);
@@ -111,113 +247,347 @@ void Renderer::RenderEnvironment()
     0.0f, 0.0f, 1.0f, -Editor::trans.z,
     0.0f, 0.0f, 0.0f, 1.0f);
 
-  for (EnvironmentRender & er : _environmentRenders)
+  unsigned int num_faces = (unsigned int)_environmentRenders.size();
+  for (unsigned int i = 0; i < num_faces; ++i)
   {
-    er._fb.Bind();
+    if ((unsigned int)_environmentFacesRendered >= max_faces)
+      break;
+    unsigned int face = (_nextEnvironmentFace + i) % num_faces;
+    EnvironmentRender & er = _environmentRenders[face];
+    if (er._valid)
+      continue;
+    _environmentFramebuffer.BindFace(face);
     Clear();
     Math::Matrix4 view(er._linear * translation);
-    RenderFrame(environment_projection, view, Editor::trans, false);
+    RenderFrame(environment_projection, view, Editor::trans, false, face);
     Framebuffer::BindDefault();
+    er._valid = true;
+    ++_environmentFacesRendered;
+    _nextEnvironmentFace = (face + 1) % num_faces;
+  }
+  // the lower levels are rebuilt from the faces that changed and the
+  // prefiltered cubemap has to start over
+  if (_environmentFacesRendered > 0) {
+    _environmentFramebuffer.GenerateMipmaps();
+    _prefilterFacesComplete = 0;
+  }
+  _environmentTimer.End();
+}
+
+void Renderer::PrefilterEnvironment()
+{
+  _prefilterTimer.Start();
+  PrefilterFaces();
+  _prefilterTimer.End();
+}
+
+void Renderer::PrefilterFaces()
+{
+  unsigned int num_faces = (unsigned int)_environmentRenders.size();
+  unsigned int total_faces = num_faces * PREFILTER_LEVELS;
+  if (_prefilterFacesComplete >= total_faces)
+    return;
+  PrefilterShader * prefilter_shader = ShaderManager::_prefilter;
+  if (!prefilter_shader->Ready())
+    return;
+  prefilter_shader->Use();
+  TexturePool::Bind(_environmentFramebuffer._texture, 0);
+  prefilter_shader->SetUniform1i("UEnvironmentMap", 0);
+  prefilter_shader->SetUniform1f("USourceSize", (float)ENVIRONMENT_SIZE);
+  glBindVertexArray(_emptyVAO);
+  glDisable(GL_DEPTH_TEST);
+  // The work is spread over multiple frames. Faces go from the sharpest
+  // level to the roughest and then wrap around.
+  unsigned int faces_rendered = 0;
+  while (_prefilterFacesComplete < total_faces &&
+    faces_rendered < (unsigned int)_prefilterFacesPerFrame)
+  {
+    unsigned int level = _nextPrefilterFace / num_faces;
+    unsigned int face = _nextPrefilterFace % num_faces;
+    _prefilterFramebuffer.BindFace(face, level);
+    float roughness = (float)level / (float)(PREFILTER_LEVELS - 1);
+    prefilter_shader->SetUniform1f("URoughness", roughness);
+    prefilter_shader->SetUniformMatrix4("UView",
+      _environmentRenders[face]._linear);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+    _nextPrefilterFace = (_nextPrefilterFace + 1) % total_faces;
+    ++_prefilterFacesComplete;
+    ++faces_rendered;
   }
+  glEnable(GL_DEPTH_TEST);
+  glBindVertexArray(0);
+  TexturePool::Unbind(_environmentFramebuffer._texture);
+  Framebuffer::BindDefault();
 }
 
+/*****************************************************************************/
+/*!
+\brief
+  Renders the normal map of the height map into the normal map framebuffer.
+  It matches Texture::CreateNormalMap with the current strength, but the
+  normals never leave the gpu. Nothing is rendered until the heights are
+  uploaded, and the framebuffer is created with their size and a full mip
+  chain the first time they are. The mips are generated after every draw.
+*/
+/*****************************************************************************/
+void Renderer::GenerateNormalMap()
+{
+  NormalMapShader * normal_map_shader = ShaderManager::_normalMap;
+  if (!normal_map_shader->Ready() ||
+    !TexturePool::Loaded(_heightTextureObject))
+    return;
+  if (!_normalMapFramebuffer._texture) {
+    int width, height;
+    TexturePool::Size(_heightTextureObject, &width, &height);
+    // mipmapped like the normal maps that are loaded from files
+    unsigned int levels = 1;
+    while ((width | height) >> levels)
+      ++levels;
+    _normalMapFramebuffer.Initialize(width, height, GL_RGB, levels);
+  }
+  _normalMapTimer.Start();
+  _normalMapFramebuffer.Bind();
+  normal_map_shader->Use();
+  TexturePool::Bind(_heightTextureObject, 0);
+  normal_map_shader->SetUniform1i("UHeightMap", 0);
+  normal_map_shader->SetUniform1f("UStrength", _normalMapStrength);
+  glBindVertexArray(_emptyVAO);
+  glDisable(GL_DEPTH_TEST);
+  glDrawArrays(GL_TRIANGLES, 0, 3);
+  glEnable(GL_DEPTH_TEST);
+  glBindVertexArray(0);
+  TexturePool::Unbind(_heightTextureObject);
+  Framebuffer::BindDefault();
+  _normalMapFramebuffer.GenerateMipmaps();
+  _normalMapTimer.End();
+  _normalMapDirty = false;
+}
+
+/*****************************************************************************/
+/*!
+\brief
+  Declares the passes of the frame in the frame graph and runs them. Passes
+  that make something the main view does not sample this frame, like the
+  environment when the material does not use environment mapping, are
+  culled by the graph and keep their results for when they are needed.
+
+\param projection
+  The projection matrix of the main view.
+\param view
+  The view matrix of the main view.
+\param view_position
+  The position of the main view.
+\param mesh
+  When true, the mesh is drawn.
+*/
+/*****************************************************************************/
 void Renderer::Render(const Math::Matrix4 & projection, 
   const Math::Matrix4 & view, const Math::Vector3 & view_position, bool mesh)
 {
-  RenderEnvironment();
-  Clear();
-  RenderFrame(projection, view, view_position, mesh);
+  UpdateVirtualTextures();
+  _materialArray.Update();
+  _environmentFacesRendered = 0;
+  bool virtual_texturing = mesh && VirtualTexturing();
+  bool texture_array = mesh && !virtual_texturing && TextureArrayMapping();
+  bool phong = Editor::shader_in_use == MeshRenderer::ShaderType::PHONG;
+  FrameGraph & graph = _frameGraph;
+  graph.Reset();
+  int backbuffer = graph.Import("Backbuffer", nullptr, true,
+    MeshRenderer::_fogColor);
+  int normal_map = graph.Import("Normal Map", &_normalMapFramebuffer);
+  int environment = graph.Import("Environment", &_environmentFramebuffer);
+  int prefiltered = graph.Import("Prefiltered Environment",
+    &_prefilterFramebuffer);
+  graph.Output(backbuffer);
+  // the normal map only needs to run again once its strength changes, so its
+  // time is read whenever it finishes rather than when the timer restarts
+  _normalMapTimer.Update();
+  if (_normalMapDirty) {
+    int pass = graph.AddPass("Normal Map", GenerateNormalMap);
+    graph.Write(pass, normal_map);
+  }
+  int pass = graph.AddPass("Environment", RenderEnvironment);
+  graph.Write(pass, environment);
+  if (_prefilterEnvironment) {
+    pass = graph.AddPass("Prefilter", PrefilterEnvironment);
+    graph.Read(pass, environment);
+    graph.Write(pass, prefiltered);
+  }
+  pass = graph.AddPass("Main", [&]()
+  {
+    Framebuffer::BindDefault();
+    RenderFrame(projection, view, view_position, mesh, MAIN_PASS);
+  });
+  graph.Write(pass, backbuffer);
+  if (mesh && phong && _meshObject->_material._environmentMapping)
+    graph.Read(pass, PrefilteredReflections() ? prefiltered : environment);
+  if (mesh && _generatedNormalMap && !virtual_texturing && !texture_array)
+    graph.Read(pass, normal_map);
+  // the feedback is only needed until its readback has been queued
+  if (virtual_texturing && phong) {
+    int feedback = graph.Create("Feedback", _feedbackBuffer._width,
+      _feedbackBuffer._height, GL_RGBA16);
+    // the pass runs after this block ends, so the handle is copied
+    pass = graph.AddPass("Feedback", [&, feedback]()
+    {
+      RenderFeedback(projection, view, graph.Target(feedback));
+    });
+    graph.Write(pass, feedback);
+    graph.Output(feedback);
+  }
+  graph.Compile();
+  graph.Execute();
 }
 
 void Renderer::RenderFrame(const Math::Matrix4 & projection,
-  const Math::Matrix4 & view, const Math::Vector3 & view_position, bool mesh)
+  const Math::Matrix4 & view, const Math::Vector3 & view_position, bool mesh,
+  unsigned int pass)
 {
+  Math::Vector4 frustum_planes[6];
+  Math::ExtractFrustumPlanes(projection * view, frustum_planes);
+  _testedObjects[pass] = 0;
+  _culledObjects[pass] = 0;
+
+  // The draws are queued and sorted so they are grouped by their state and
+  // opaque draws go front to back. The skybox does not write depth, so it
+  // is in the first layer and everything after it covers it.
+  _renderQueue.Clear();
   if (_renderSkybox)
-    _skybox->Render(projection, view);
-
-  // bind textures for rendering
-  // model textures
-  TexturePool::Bind(_diffuseTextureObject, 0);
-  TexturePool::Bind(_specularTextureObject, 1);
-  TexturePool::Bind(_normalTextureObject, 2);
-  // environment map textures
-  TexturePool::Bind(_environmentRenders[FB_UP]._fb._texture, 3);
-  TexturePool::Bind(_environmentRenders[FB_DN]._fb._texture, 4);
-  TexturePool::Bind(_environmentRenders[FB_LT]._fb._texture, 5);
-  TexturePool::Bind(_environmentRenders[FB_RT]._fb._texture, 6);
-  TexturePool::Bind(_environmentRenders[FB_FT]._fb._texture, 7);
-  TexturePool::Bind(_environmentRenders[FB_BK]._fb._texture, 8);
-
-
-  SolidShader * solid_shader = MeshRenderer::GetSolidShader();
-  PhongShader * phong_shader = MeshRenderer::GetPhongShader();
-  GouraudShader * gouraud_shader = MeshRenderer::GetGouraudShader();
-  BlinnShader * blinn_shader = MeshRenderer::GetBlinnShader();
+    _renderQueue.Push(RenderQueue::Key(BACKGROUND_LAYER,
+      ShaderManager::_skybox->ID(), 0, 0, 1.0f), SKYBOX_DRAW);
+
+  // all of the visible light spheres are drawn with a single instanced draw
+  // that is sorted by the nearest sphere
   Math::Matrix4 model;
   Math::Matrix4 translate;
-  Math::Matrix4 rotate;
   Math::Matrix4 scale;
-
-  // render lights
-  solid_shader->Use();
-
+  _lightInstances.clear();
+  scale.Scale(0.25f, 0.25f, 0.25f);
+  float nearest_light = 1.0f;
   for (int i = 0; i < Light::_activeLights; ++i) {
-    translate.Translate(Editor::lights[i]._position.x, Editor::lights[i]._position.y, Editor::lights[i]._position.z);
-    scale.Scale(0.25f, 0.25f, 0.25f);
+    const Math::Vector3 & position = Editor::lights[i]._position;
+    translate.Translate(position.x, position.y, position.z);
     model = translate * scale;
-    Color & color = Editor::lights[i]._diffuseColor;
-    glUniform3f(solid_shader->UColor, color._r, color._g, color._b);
-    MeshRenderer::Render(_sphereMeshObject, MeshRenderer::SOLID, projection, view, model);
+    if (!InFrustum(frustum_planes, _sphereMeshObject, model, 0.25f, pass))
+      continue;
+    MeshRenderer::Instance instance;
+    instance._model = model;
+    instance._color = Editor::lights[i]._diffuseColor;
+    _lightInstances.push_back(instance);
+    float depth = ViewDepth(view, position);
+    if (depth < nearest_light)
+      nearest_light = depth;
   }
+  if (!_lightInstances.empty())
+    _renderQueue.Push(RenderQueue::Key(OPAQUE_LAYER,
+      MeshRenderer::GetInstancedSolidShader()->ID(), 0,
+      _sphereMeshObject->_vaoInstanced, nearest_light), LIGHTS_DRAW);
 
-  translate.Translate(Editor::trans.x, Editor::trans.y, Editor::trans.z);
-  scale.Scale(Editor::cur_scale, Editor::cur_scale, Editor::cur_scale);
-  Math::ToMatrix4(Editor::rotation, &rotate);
-  model = translate * rotate * scale;
-
+  model = MeshModel();
+  Shader * mesh_shader = nullptr;
   switch (Editor::shader_in_use)
   {
-    //PHONG SHADER
   case MeshRenderer::ShaderType::PHONG:
-    phong_shader->Use();
-    glUniform3f(phong_shader->UCameraPosition, view_position.x, view_position.y, view_position.z);
-    glUniform1i(phong_shader->UActiveLights, Light::_activeLights);
-    for (int i = 0; i < Light::_activeLights; ++i)
-      Editor::lights[i].SetUniforms(i, phong_shader);
+    mesh_shader = MeshRenderer::GetPhongShader(_meshObject->_material);
     break;
-    // GOURAUD SHADER
   case MeshRenderer::ShaderType::GOURAUD:
-    gouraud_shader->Use();
-    glUniform3f(gouraud_shader->UCameraPosition, view_position.x, view_position.y, view_position.z);
-    glUniform1i(gouraud_shader->UActiveLights, Light::_activeLights);
-    glUniform1i(gouraud_shader->UActiveLights, Light::_activeLights);
-    for (int i = 0; i < Light::_activeLights; ++i)
-      Editor::lights[i].SetUniforms(i, gouraud_shader);
+    mesh_shader = MeshRenderer::GetGouraudShader();
     break;
   case MeshRenderer::ShaderType::BLINN:
-    blinn_shader->Use();
-    glUniform3f(blinn_shader->UCameraPosition, view_position.x, view_position.y, view_position.z);
-    glUniform1i(blinn_shader->UActiveLights, Light::_activeLights);
-    for (int i = 0; i < Light::_activeLights; ++i)
-      Editor::lights[i].SetUniforms(i, blinn_shader);
+    mesh_shader = MeshRenderer::GetBlinnShader();
     break;
   default:
+    mesh_shader = MeshRenderer::GetSolidShader();
     break;
   }
-  // rendering mesh
-  if (mesh)
-    MeshRenderer::Render(_meshObject, Editor::shader_in_use, projection, view, model);
+  if (mesh && InFrustum(frustum_planes, _meshObject, model,
+    Editor::cur_scale, pass)) {
+    Math::Vector3 mesh_position(model(0, 3), model(1, 3), model(2, 3));
+    _renderQueue.Push(RenderQueue::Key(OPAQUE_LAYER, mesh_shader->ID(),
+      MESH_MATERIAL, _meshObject->_vao, ViewDepth(view, mesh_position)),
+      MESH_DRAW);
+  }
+
+  // model textures are only bound when the mesh is drawn, and only the
+  // textures the material samples its maps from are bound
+  bool virtual_texturing = mesh && VirtualTexturing();
+  bool texture_array = mesh && !virtual_texturing && TextureArrayMapping();
+  TextureObject * normal_texture = _normalTextureObject;
+  // the placeholder is used until the normal map is first generated
+  if (_generatedNormalMap && _normalMapFramebuffer._texture)
+    normal_texture = _normalMapFramebuffer._texture;
+  // the environment map is only sampled by the mesh, and it can't be sampled
+  // while it is being rendered to. Sharp reflections keep the environment
+  // map, whose first level is not blurred by the prefilter.
+  TextureObject * environment_texture = _environmentFramebuffer._texture;
+  float environment_max_lod = (float)(ENVIRONMENT_LEVELS - 1);
+  if (PrefilteredReflections()) {
+    environment_texture = _prefilterFramebuffer._texture;
+    environment_max_lod = (float)(PREFILTER_LEVELS - 1);
+  }
+
+  // phong and blinn read their lights from the light clusters, which are
+  // only built for the main frame since that is the only frame the mesh is
+  // drawn in
+  bool clustered = mesh &&
+    (Editor::shader_in_use == MeshRenderer::ShaderType::PHONG ||
+     Editor::shader_in_use == MeshRenderer::ShaderType::BLINN);
+  if (clustered)
+    LightCluster::Build(projection, view, MeshRenderer::_nearPlane,
+      MeshRenderer::_farPlane, Editor::lights, Light::_activeLights);
+
+  _renderQueue.Sort();
+  _renderQueue.Submit([&](const RenderQueue::Item & item,
+    unsigned int changes)
+  {
+    switch (item._payload)
+    {
+    case SKYBOX_DRAW:
+      // only the main frame is timed
+      if (mesh)
+        _skyboxTimer.Start();
+      _skybox->Render(projection, view);
+      if (mesh)
+        _skyboxTimer.End();
+      break;
+    case LIGHTS_DRAW:
+      MeshRenderer::RenderInstanced(_sphereMeshObject, _lightInstances.data(),
+        (unsigned int)_lightInstances.size(), projection, view);
+      break;
+    case MESH_DRAW:
+      if (changes & RENDERQUEUE_MATERIAL_CHANGED)
+        BindMeshTextures(virtual_texturing, texture_array, normal_texture,
+          environment_texture);
+      if (changes & RENDERQUEUE_PROGRAM_CHANGED)
+        SetMeshUniforms(view_position, environment_max_lod, clustered);
+      _meshTimer.Start();
+      MeshRenderer::Render(_meshObject, Editor::shader_in_use, projection,
+        view, model);
+      _meshTimer.End();
+      if (_benchmarkPhongVariants &&
+        Editor::shader_in_use == MeshRenderer::ShaderType::PHONG)
+        BenchmarkPhongVariants(projection, view, view_position, model,
+          environment_max_lod);
+      break;
+    default:
+      break;
+    }
+  });
 
   // unbind textures
   TexturePool::Unbind(_diffuseTextureObject);
   TexturePool::Unbind(_specularTextureObject);
-  TexturePool::Unbind(_normalTextureObject);
-  TexturePool::Unbind(_environmentRenders[FB_UP]._fb._texture);
-  TexturePool::Unbind(_environmentRenders[FB_DN]._fb._texture);
-  TexturePool::Unbind(_environmentRenders[FB_LT]._fb._texture);
-  TexturePool::Unbind(_environmentRenders[FB_RT]._fb._texture);
-  TexturePool::Unbind(_environmentRenders[FB_FT]._fb._texture);
-  TexturePool::Unbind(_environmentRenders[FB_BK]._fb._texture);
+  TexturePool::Unbind(normal_texture);
+  TexturePool::Unbind(environment_texture);
+  if (virtual_texturing) {
+    _virtualDiffuse.Unbind();
+    _virtualSpecular.Unbind();
+    _virtualNormal.Unbind();
+  }
+  if (texture_array)
+    _materialArray.Unbind();
+  if (clustered)
+    LightCluster::Unbind();
   // disable writing to error strings
   try
   {
@@ -230,8 +600,571 @@ void Renderer::RenderFrame(const Math::Matrix4 & projection,
   }
 }
 
+// Binds the textures the mesh's material samples
+void Renderer::BindMeshTextures(bool virtual_texturing, bool texture_array,
+  TextureObject * normal_texture, TextureObject * environment_texture)
+{
+  if (virtual_texturing) {
+    _virtualDiffuse.Bind(VIRTUAL_TEXTURE_LOCATION);
+    _virtualSpecular.Bind(VIRTUAL_TEXTURE_LOCATION + 2);
+    _virtualNormal.Bind(VIRTUAL_TEXTURE_LOCATION + 4);
+  }
+  else if (texture_array) {
+    _materialArray.Bind(_meshObject->_material._mapArray);
+  }
+  else {
+    TexturePool::Bind(_diffuseTextureObject, 0);
+    TexturePool::Bind(_specularTextureObject, 1);
+    TexturePool::Bind(normal_texture, 2);
+  }
+  TexturePool::Bind(environment_texture, 3);
+}
+
+// Sets the uniforms of the shader the mesh is drawn with
+void Renderer::SetMeshUniforms(const Math::Vector3 & view_position,
+  float environment_max_lod, bool clustered)
+{
+  if (clustered)
+    LightCluster::Bind(4);
+  PhongShader * phong_shader =
+    MeshRenderer::GetPhongShader(_meshObject->_material);
+  GouraudShader * gouraud_shader = MeshRenderer::GetGouraudShader();
+  BlinnShader * blinn_shader = MeshRenderer::GetBlinnShader();
+  // gouraud lights every vertex with a uniform array
+  int uniform_lights = Light::_activeLights;
+  if (uniform_lights > MAXUNIFORMLIGHTS)
+    uniform_lights = MAXUNIFORMLIGHTS;
+
+  switch (Editor::shader_in_use)
+  {
+    //PHONG SHADER
+  case MeshRenderer::ShaderType::PHONG:
+    if (!phong_shader->Ready())
+      break;
+    SetPhongUniforms(phong_shader, view_position, environment_max_lod,
+      clustered);
+    break;
+    // GOURAUD SHADER
+  case MeshRenderer::ShaderType::GOURAUD:
+    if (!gouraud_shader->Ready())
+      break;
+    gouraud_shader->Use();
+    gouraud_shader->SetUniform3f("UCameraPosition", view_position.x, view_position.y, view_position.z);
+    gouraud_shader->SetUniform1i("UActiveLights", uniform_lights);
+    for (int i = 0; i < uniform_lights; ++i)
+      Editor::lights[i].SetUniforms(i, gouraud_shader);
+    break;
+  case MeshRenderer::ShaderType::BLINN:
+    if (!blinn_shader->Ready())
+      break;
+    blinn_shader->Use();
+    blinn_shader->SetUniform3f("UCameraPosition", view_position.x, view_position.y, view_position.z);
+    if (clustered)
+      LightCluster::SetUniforms(blinn_shader, 4);
+    break;
+  default:
+    break;
+  }
+}
+
+// The distance from the view to a point, from 0 at the near plane to 1 at
+// the far plane
+float Renderer::ViewDepth(const Math::Matrix4 & view,
+  const Math::Vector3 & position)
+{
+  float distance = -(view(2, 0) * position.x + view(2, 1) * position.y +
+    view(2, 2) * position.z + view(2, 3));
+  return (distance - MeshRenderer::_nearPlane) /
+    (MeshRenderer::_farPlane - MeshRenderer::_nearPlane);
+}
+
+void Renderer::SetPhongUniforms(PhongShader * phong_shader,
+  const Math::Vector3 & view_position, float environment_max_lod,
+  bool clustered)
+{
+  phong_shader->Use();
+  phong_shader->SetUniform3f("UCameraPosition", view_position.x, view_position.y, view_position.z);
+  if (clustered)
+    LightCluster::SetUniforms(phong_shader, 4);
+  // variants only have the uniforms of the features they were built with
+  phong_shader->BeginOptionalUniforms();
+  phong_shader->SetUniform1f("UEnvironmentMaxLod", environment_max_lod);
+  if (VirtualTexturing()) {
+    _virtualDiffuse.SetUniforms(phong_shader, "UVirtualDiffuse",
+      VIRTUAL_TEXTURE_LOCATION);
+    _virtualSpecular.SetUniforms(phong_shader, "UVirtualSpecular",
+      VIRTUAL_TEXTURE_LOCATION + 2);
+    _virtualNormal.SetUniforms(phong_shader, "UVirtualNormal",
+      VIRTUAL_TEXTURE_LOCATION + 4);
+  }
+  if (TextureArrayMapping())
+    _materialArray.SetUniforms(phong_shader, "UMaterial.UMap");
+  phong_shader->EndOptionalUniforms();
+}
+
+/*****************************************************************************/
+/*!
+\brief
+  Draws the mesh into the feedback target with the feedback shader so the
+  virtual textures can find the pages the mesh needs. The target is read
+  back a few frames later by UpdateVirtualTextures.
+
+\param projection
+  The projection matrix the mesh was drawn with.
+\param view
+  The view matrix the mesh was drawn with.
+\param target
+  The cleared target the feedback is drawn into.
+*/
+/*****************************************************************************/
+void Renderer::RenderFeedback(const Math::Matrix4 & projection,
+  const Math::Matrix4 & view, Framebuffer * target)
+{
+  FeedbackShader * feedback_shader = ShaderManager::_feedback;
+  if (!feedback_shader->Ready())
+    return;
+  Math::Matrix4 model = MeshModel();
+  _feedbackBuffer.Begin(target);
+  feedback_shader->Use();
+  feedback_shader->SetUniformMatrix4("UProjection", projection);
+  feedback_shader->SetUniformMatrix4("UView", view);
+  feedback_shader->SetUniformMatrix4("UModel", model);
+  feedback_shader->SetUniform1i("UMappingType",
+    _meshObject->_material._mappingType);
+  feedback_shader->SetUniform1f("UFeedbackScale", _feedbackBuffer.Scale());
+  glBindVertexArray(_meshObject->_vao);
+  glDrawElements(GL_TRIANGLES, _meshObject->_elements, GL_UNSIGNED_INT,
+    nullptr);
+  glBindVertexArray(0);
+  _feedbackBuffer.End(target);
+}
+
+// The model matrix the mesh is drawn with
+Math::Matrix4 Renderer::MeshModel()
+{
+  Math::Matrix4 translate;
+  Math::Matrix4 rotate;
+  Math::Matrix4 scale;
+  translate.Translate(Editor::trans.x, Editor::trans.y, Editor::trans.z);
+  scale.Scale(Editor::cur_scale, Editor::cur_scale, Editor::cur_scale);
+  Math::ToMatrix4(Editor::rotation, &rotate);
+  return translate * rotate * scale;
+}
+
+// Gives the latest finished feedback to the virtual textures and uploads the
+// pages they have read
+void Renderer::UpdateVirtualTextures()
+{
+  // the textures are made by the first Update after their page files open
+  if (VirtualTexturesLoading()) {
+    _virtualDiffuse.Update();
+    _virtualSpecular.Update();
+    _virtualNormal.Update();
+    return;
+  }
+  if (!VirtualTexturing())
+    return;
+  if (_feedbackBuffer.Read(&_feedback)) {
+    _virtualDiffuse.RequestPages(_feedback);
+    _virtualSpecular.RequestPages(_feedback);
+    _virtualNormal.RequestPages(_feedback);
+  }
+  _virtualDiffuse.Update();
+  _virtualSpecular.Update();
+  _virtualNormal.Update();
+}
+
+void Renderer::BenchmarkPhongVariants(const Math::Matrix4 & projection,
+  const Math::Matrix4 & view, const Math::Vector3 & view_position,
+  const Math::Matrix4 & model, float environment_max_lod)
+{
+  // The mesh is drawn on top of itself. Equal depths must pass or almost
+  // every fragment would be rejected before it is shaded.
+  glDepthFunc(GL_LEQUAL);
+  bool phong_variants = MeshRenderer::_phongVariants;
+  GPUTimer * timers[2] = { &_uberTimer, &_variantTimer };
+  for (int i = 0; i < 2; ++i) {
+    MeshRenderer::_phongVariants = (i == 1);
+    PhongShader * phong_shader =
+      MeshRenderer::GetPhongShader(_meshObject->_material);
+    if (!phong_shader->Ready())
+      continue;
+    SetPhongUniforms(phong_shader, view_position, environment_max_lod, true);
+    timers[i]->Start();
+    for (int j = 0; j < BENCHMARK_DRAWS; ++j)
+      MeshRenderer::Render(_meshObject, MeshRenderer::ShaderType::PHONG,
+        projection, view, model);
+    timers[i]->End();
+  }
+  MeshRenderer::_phongVariants = phong_variants;
+  glDepthFunc(GL_LESS);
+}
+
+bool Renderer::InFrustum(const Math::Vector4 planes[6],
+  const MeshRenderer::MeshObject * mesh_object, const Math::Matrix4 & model,
+  float scale, unsigned int pass)
+{
+  ++_testedObjects[pass];
+  if (!_frustumCulling)
+    return true;
+  // The sphere test is cheap, so it is done first. The model matrix must
+  // scale uniformly for the scaled radius to be correct.
+  const Math::Vector3 & center = mesh_object->_boundingSphereCenter;
+  Math::Vector3 world_center(
+    model(0, 0) * center.x + model(0, 1) * center.y + model(0, 2) * center.z + model(0, 3),
+    model(1, 0) * center.x + model(1, 1) * center.y + model(1, 2) * center.z + model(1, 3),
+    model(2, 0) * center.x + model(2, 1) * center.y + model(2, 2) * center.z + model(2, 3));
+  float radius = mesh_object->_boundingSphereRadius * scale;
+  if (!Math::SphereInFrustum(planes, world_center, radius)) {
+    ++_culledObjects[pass];
+    return false;
+  }
+  // The box is rotated with the model, so the world space box is the one
+  // that contains the transformed model space box.
+  const Math::Vector3 & box_min = mesh_object->_boundingBoxMin;
+  const Math::Vector3 & box_max = mesh_object->_boundingBoxMax;
+  Math::Vector3 world_min(model(0, 3), model(1, 3), model(2, 3));
+  Math::Vector3 world_max(world_min);
+  for (unsigned int r = 0; r < 3; ++r) {
+    for (unsigned int c = 0; c < 3; ++c) {
+      float a = model(r, c) * box_min[c];
+      float b = model(r, c) * box_max[c];
+      world_min[r] += a < b ? a : b;
+      world_max[r] += a < b ? b : a;
+    }
+  }
+  if (!Math::AabbInFrustum(planes, world_min, world_max)) {
+    ++_culledObjects[pass];
+    return false;
+  }
+  return true;
+}
+
+void Renderer::CaptureEnvironmentState(std::vector<float> * state)
+{
+  // The environment renders only contain the skybox and the light spheres.
+  // Everything that changes what those look like is recorded here.
+  state->clear();
+  // capture position
+  state->push_back(Editor::trans.x);
+  state->push_back(Editor::trans.y);
+  state->push_back(Editor::trans.z);
+  // fog and projection
+  Color & fog_color = MeshRenderer::_fogColor;
+  state->push_back(fog_color._r);
+  state->push_back(fog_color._g);
+  state->push_back(fog_color._b);
+  state->push_back(MeshRenderer::_nearPlane);
+  state->push_back(MeshRenderer::_farPlane);
+  // skybox and any textures that replaced their placeholders
+  state->push_back(_renderSkybox ? 1.0f : 0.0f);
+  state->push_back((float)TexturePool::_completedRequests);
+  // lights
+  state->push_back((float)Light::_activeLights);
+  for (int i = 0; i < Light::_activeLights; ++i) {
+    const Light & light = Editor::lights[i];
+    state->push_back(light._position.x);
+    state->push_back(light._position.y);
+    state->push_back(light._position.z);
+    state->push_back(light._diffuseColor._r);
+    state->push_back(light._diffuseColor._g);
+    state->push_back(light._diffuseColor._b);
+  }
+}
+
+void Renderer::UpdateEnvironmentValidity()
+{
+  std::vector<float> current_state;
+  CaptureEnvironmentState(&current_state);
+  if (current_state == _environmentState && _skybox == _environmentSkybox)
+    return;
+  // the environment changed, but it may not be time to update it yet
+  float time = Time::TotalTime();
+  if (_environmentUpdateRate > 0.0f &&
+    time - _environmentInvalidationTime < 1.0f / _environmentUpdateRate)
+    return;
+  _environmentState.swap(current_state);
+  _environmentSkybox = _skybox;
+  _environmentInvalidationTime = time;
+  InvalidateEnvironment();
+}
+
 void Renderer::ReplaceMesh(Mesh & mesh)
 {
   MeshRenderer::Unload(_meshObject);
   _meshObject = MeshRenderer::Upload(&mesh);
-}
\ No newline at end of file
+}
+
+/*****************************************************************************/
+/*!
+\brief
+  Loads every skybox twice and times both. First each skybox is decoded and
+  uploaded one after another like they were at startup before requests
+  existed. Then all of them are requested at once and the time is taken
+  once every request has been uploaded.
+*/
+/*****************************************************************************/
+void Renderer::BenchmarkSkyboxLoading()
+{
+  const char * directories[] = { "Alpha/", "Boulder/", "Crater/",
+    "CriminalImpact/", "Majestic/", "Test/" };
+  std::vector<Skybox *> skyboxes;
+  for (const char * directory : directories)
+    skyboxes.push_back(new Skybox(SKYBOX_PATH + std::string(directory),
+      "up.tga", "dn.tga", "lf.tga", "rt.tga", "ft.tga", "bk.tga"));
+  // other requests would be included in the time
+  TexturePool::FinishUploads();
+  std::chrono::high_resolution_clock::time_point start =
+    std::chrono::high_resolution_clock::now();
+  for (Skybox * skybox : skyboxes)
+    skybox->Upload(false);
+  glFinish();
+  std::chrono::duration<float, std::milli> serial_time =
+    std::chrono::high_resolution_clock::now() - start;
+  _serialSkyboxMilliseconds = serial_time.count();
+  for (Skybox * skybox : skyboxes)
+    skybox->Unload();
+  start = std::chrono::high_resolution_clock::now();
+  for (Skybox * skybox : skyboxes)
+    skybox->Upload(true);
+  TexturePool::FinishUploads();
+  glFinish();
+  std::chrono::duration<float, std::milli> request_time =
+    std::chrono::high_resolution_clock::now() - start;
+  _requestSkyboxMilliseconds = request_time.count();
+  for (Skybox * skybox : skyboxes) {
+    skybox->Unload();
+    delete skybox;
+  }
+}
+
+// Times the creation of a normal map from an 8K height map
+void Renderer::BenchmarkNormalMap()
+{
+  const int size = 8192;
+  std::vector<unsigned char> heights(size * size);
+  for (int y = 0; y < size; ++y) {
+    for (int x = 0; x < size; ++x)
+      heights[y * size + x] = (unsigned char)((x * 7) ^ (y * 13));
+  }
+  std::vector<unsigned char> normal_map(size * size * CHANNELS_RGB);
+  std::chrono::high_resolution_clock::time_point start =
+    std::chrono::high_resolution_clock::now();
+  Texture::CreateNormalMap(heights.data(), size, size, 1, 2.0f / 255.0f,
+    normal_map.data(), CHANNELS_RGB);
+  std::chrono::duration<float, std::milli> time =
+    std::chrono::high_resolution_clock::now() - start;
+  _normalMapThroughput = (float)size * (float)size / (time.count() * 1000.0f);
+}
+
+// Times decoding the skybox faces and material maps with stb and with the
+// ImageDecoder
+void Renderer::BenchmarkImageDecoding()
+{
+  const char * directories[] = { "Alpha/", "Boulder/", "Crater/",
+    "CriminalImpact/", "Majestic/", "Test/" };
+  const char * faces[] = { "up.tga", "dn.tga", "lf.tga", "rt.tga", "ft.tga",
+    "bk.tga" };
+  std::vector<std::string> files;
+  for (const char * directory : directories) {
+    for (const char * face : faces)
+      files.push_back(SKYBOX_PATH + std::string(directory) + face);
+  }
+  files.push_back("Resource/Texture/diffuse.tga");
+  files.push_back("Resource/Texture/specular.tga");
+  files.push_back("Resource/Texture/normal.png");
+  files.push_back("Resource/Texture/normal_map.png");
+  ImageDecoder::Benchmark(files, &_stbDecodeMilliseconds,
+    &_decoderMilliseconds);
+}
+
+/*****************************************************************************/
+/*!
+\brief
+  Draws _queueBenchmarkDraws spheres scattered in front of a fixed view with
+  two programs and sixteen materials, once in the order they were pushed and
+  once sorted by the render queue. State is only changed when it differs
+  from the previous draw, so the difference between the two is the cost of
+  the state changes that sorting removed.
+*/
+/*****************************************************************************/
+void Renderer::BenchmarkRenderQueue()
+{
+  const unsigned int material_count = 16;
+  Shader * programs[2] = { MeshRenderer::GetSolidShader(),
+    MeshRenderer::GetGouraudShader() };
+  if (!programs[0]->Ready() || !programs[1]->Ready() ||
+    _queueBenchmarkDraws <= 0)
+    return;
+  TextureObject * textures[4] = { _diffuseTextureObject,
+    _specularTextureObject, _normalTextureObject, _heightTextureObject };
+  // the same seed is used every time so runs can be compared
+  std::mt19937 generator(0);
+  std::uniform_real_distribution<float> spread(-20.0f, 20.0f);
+  std::uniform_real_distribution<float> distance(-60.0f, -5.0f);
+  std::uniform_int_distribution<unsigned int> program_pick(0, 1);
+  std::uniform_int_distribution<unsigned int> material_pick(0,
+    material_count - 1);
+  Math::Matrix4 projection = Math::Matrix4::Perspective(PI / 2.0f,
+    1.0f, MeshRenderer::_nearPlane, MeshRenderer::_farPlane);
+  Math::Matrix4 view;
+  view.SetIdentity();
+  std::vector<Math::Matrix4> models(_queueBenchmarkDraws);
+  std::vector<unsigned long long> keys(_queueBenchmarkDraws);
+  Math::Matrix4 scale;
+  scale.Scale(0.25f, 0.25f, 0.25f);
+  for (int i = 0; i < _queueBenchmarkDraws; ++i) {
+    Math::Vector3 position(spread(generator), spread(generator),
+      distance(generator));
+    Math::Matrix4 translate;
+    translate.Translate(position.x, position.y, position.z);
+    models[i] = translate * scale;
+    // the program field holds the index of the program in programs
+    keys[i] = RenderQueue::Key(OPAQUE_LAYER, program_pick(generator),
+      material_pick(generator), _sphereMeshObject->_vao,
+      ViewDepth(view, position));
+  }
+
+  const unsigned int size = 512;
+  Framebuffer * target = RenderTargetPool::Acquire("Render Queue Benchmark",
+    size, size);
+  // only the state that differs from the previous draw is changed
+  Shader * program = nullptr;
+  TextureObject * bound_texture = nullptr;
+  auto submit = [&](const RenderQueue::Item & item, unsigned int changes)
+  {
+    unsigned long long key = item._key;
+    if (changes & RENDERQUEUE_PROGRAM_CHANGED) {
+      program = programs[RenderQueue::Program(key)];
+      program->Use();
+      program->SetUniformMatrix4("UProjection", projection);
+      program->SetUniformMatrix4("UView", view);
+    }
+    if (changes & (RENDERQUEUE_PROGRAM_CHANGED |
+      RENDERQUEUE_MATERIAL_CHANGED)) {
+      unsigned int material = RenderQueue::Material(key);
+      float shade = (float)material / (float)(material_count - 1);
+      // the pool skips binding a texture that is still bound, so the last
+      // one is unbound first and every material change reaches OpenGL
+      if (bound_texture)
+        TexturePool::Unbind(bound_texture);
+      bound_texture = textures[material % 4];
+      TexturePool::Bind(bound_texture, 0);
+      // each program only uses one of the colors
+      program->BeginOptionalUniforms();
+      program->SetUniform3f("UColor", shade, 1.0f - shade, 0.5f);
+      program->SetUniform3f("UEmissiveColor", shade, 0.5f, 1.0f - shade);
+      program->EndOptionalUniforms();
+    }
+    // the key only keeps the low bits of the id, so it is only for grouping
+    if (changes & RENDERQUEUE_VAO_CHANGED)
+      glBindVertexArray(_sphereMeshObject->_vao);
+    program->SetUniformMatrix4("UModel", models[item._payload]);
+    glDrawElements(GL_TRIANGLES, _sphereMeshObject->_elements,
+      GL_UNSIGNED_INT, nullptr);
+  };
+  float * submit_times[2] = { &_unsortedSubmitMilliseconds,
+    &_queueSubmitMilliseconds };
+  int * state_changes[2] = { &_unsortedStateChanges, &_queueStateChanges };
+  RenderQueue queue;
+  for (int sorted = 0; sorted < 2; ++sorted) {
+    queue.Clear();
+    for (int i = 0; i < _queueBenchmarkDraws; ++i)
+      queue.Push(keys[i], i);
+    if (sorted) {
+      std::chrono::high_resolution_clock::time_point start =
+        std::chrono::high_resolution_clock::now();
+      queue.Sort();
+      std::chrono::duration<float, std::milli> time =
+        std::chrono::high_resolution_clock::now() - start;
+      _queueSortMilliseconds = time.count();
+    }
+    target->Bind();
+    glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    // earlier work would be included in the time
+    glFinish();
+    std::chrono::high_resolution_clock::time_point start =
+      std::chrono::high_resolution_clock::now();
+    queue.Submit(submit);
+    glFinish();
+    std::chrono::duration<float, std::milli> time =
+      std::chrono::high_resolution_clock::now() - start;
+    *submit_times[sorted] = time.count();
+    *state_changes[sorted] = queue._programChanges + queue._materialChanges +
+      queue._vaoChanges;
+  }
+  glBindVertexArray(0);
+  if (bound_texture)
+    TexturePool::Unbind(bound_texture);
+  Framebuffer::BindDefault();
+  RenderTargetPool::Release(target);
+  try {
+    GLenum gl_error = glGetError();
+    OPENGLERRORCHECK("Renderer.cpp", "BenchmarkRenderQueue",
+      "During the render queue benchmark", gl_error);
+  }
+  catch (const Error & error) {
+    ErrorLog::Write(error);
+  }
+}
+
+// Starts opening the page files of the virtual textures on the ThreadPool.
+// The page files are made the first time each map is seen, so this is only
+// done once virtual texturing is asked for.
+void Renderer::LoadVirtualTextures()
+{
+  _virtualDiffuse.Initialize("Resource/Texture/diffuse.tga",
+    MipGenerator::COLOR);
+  _virtualSpecular.Initialize("Resource/Texture/specular.tga",
+    MipGenerator::COLOR);
+  _virtualNormal.Initialize("Resource/Texture/normal.png",
+    MipGenerator::NORMAL_MAP);
+}
+
+// Starts building the material texture array on the ThreadPool. It is only
+// built once a material asks for it.
+void Renderer::LoadMaterialArray()
+{
+  if (_materialArray.Ready() || _materialArray.Loading())
+    return;
+  // a build that failed starts over
+  _materialArray.Purge();
+  // the order matches the map indices in phong.frag
+  _materialArray.Add("Resource/Texture/diffuse.tga", MipGenerator::COLOR);
+  _materialArray.Add("Resource/Texture/specular.tga", MipGenerator::COLOR);
+  _materialArray.Add("Resource/Texture/normal.png", MipGenerator::NORMAL_MAP);
+  _materialArray.Build();
+}
+
+// True while any virtual texture is still opening its page file
+bool Renderer::VirtualTexturesLoading()
+{
+  return _virtualDiffuse.Loading() || _virtualSpecular.Loading() ||
+    _virtualNormal.Loading();
+}
+
+// True when every virtual texture opened its page file
+bool Renderer::VirtualTexturesReady()
+{
+  return _virtualDiffuse.Ready() && _virtualSpecular.Ready() &&
+    _virtualNormal.Ready();
+}
+
+// True when the mesh's material samples the virtual textures
+bool Renderer::VirtualTexturing()
+{
+  return _meshObject->_material._virtualTexturing && VirtualTexturesReady();
+}
+
+// True when the mesh's material samples the prefiltered environment
+bool Renderer::PrefilteredReflections()
+{
+  return _prefilterEnvironment && _meshObject->_material._roughReflections;
+}
+
+// True when the mesh's material samples the texture array
+bool Renderer::TextureArrayMapping()
+{
+  return _meshObject->_material._textureArray && _materialArray.Ready();
+}
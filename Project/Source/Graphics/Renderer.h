@@ -4,14 +4,28 @@
 
 #include "Mesh/Mesh.h"
 #include "Mesh/MeshRenderer.h"
+#include "Texture/FeedbackBuffer.h"
+#include "Texture/TextureArray.h"
 #include "Texture/TexturePool.h"
+#include "Texture/VirtualTexture.h"
+#include "FrameGraph.h"
+#include "RenderQueue.h"
 #include "Framebuffer.h"
+#include "GPUTimer.h"
 #include "Skybox.h"
 #include "Camera.h"
 
 #ifndef RENDERER_H
 #define RENDERER_H
 
+// The six environment faces are the first passes and the main view is last
+#define RENDER_PASSES 7
+#define MAIN_PASS 6
+// The number of times the mesh is drawn with each phong shader when comparing
+// the shader that branches on material uniforms with its variant
+#define BENCHMARK_DRAWS 16
+// The number of spheres the render queue benchmark draws
+#define RENDERQUEUE_BENCHMARK_DRAWS 50000
 
 class Renderer
 {
@@ -19,14 +33,26 @@ public:
   static void Initialize(Mesh & mesh);
   static void Purge();
   static void Clear();
+  static void InvalidateEnvironment();
   static void RenderEnvironment();
   static void Render(const Math::Matrix4 & projection,
     const Math::Matrix4 & view, const Math::Vector3 & view_position, 
     bool mesh);
   static void RenderFrame(const Math::Matrix4 & projection,
     const Math::Matrix4 & view, const Math::Vector3 & view_position,
-    bool mesh);
+    bool mesh, unsigned int pass);
   static void ReplaceMesh(Mesh & mesh);
+  static void BenchmarkSkyboxLoading();
+  static void BenchmarkNormalMap();
+  static void BenchmarkImageDecoding();
+  static void BenchmarkRenderQueue();
+  static void LoadVirtualTextures();
+  static void LoadMaterialArray();
+  static bool VirtualTexturesLoading();
+  static bool VirtualTexturesReady();
+  static bool VirtualTexturing();
+  static bool TextureArrayMapping();
+  static bool PrefilteredReflections();
 public:
   static Mesh * _mesh;
   static MeshRenderer::MeshObject * _meshObject;
@@ -36,31 +62,167 @@ public:
   static TextureObject * _diffuseTextureObject;
   static TextureObject * _specularTextureObject;
   static TextureObject * _normalTextureObject;
+  // When true, the normal map made from the heights of the specular map is
+  // used instead of the normal map file. It is made on the gpu and remade
+  // whenever the strength changes.
+  static bool _generatedNormalMap;
+  static float _normalMapStrength;
+  static bool _normalMapDirty;
+  // The gpu time the last normal map took to make
+  static GPUTimer _normalMapTimer;
+  // The same maps streamed through page caches. The material chooses them
+  // over the textures above. Only the pages that the feedback pass finds are
+  // kept in video memory.
+  static VirtualTexture _virtualDiffuse;
+  static VirtualTexture _virtualSpecular;
+  static VirtualTexture _virtualNormal;
+  static FeedbackBuffer _feedbackBuffer;
+  // The same maps packed into the layers of one texture array, so the
+  // material can bind all of them at once
+  static TextureArray _materialArray;
 
   static bool _renderSkybox;
   static Skybox * _skybox;
 
+  // The ways in which the environment renders can be kept up to date
+  enum EnvironmentUpdate
+  {
+    ALWAYS,
+    ON_CHANGE,
+    TIME_SLICED,
+    NUMENVIRONMENTUPDATES
+  };
+
   struct EnvironmentRender
   {
-    // Initializes the linear part of the view matrix and the width and height
-    // of the framebuffer
-    EnvironmentRender(unsigned int width, unsigned int height,
-      const Math::Matrix4 & linear) : _linear(linear)
-    {
-      _fb.Initialize(width, height);
-    }
-    // The framebuffer used for the environment render
-    Framebuffer _fb;
+    // Initializes the linear part of the view matrix
+    EnvironmentRender(const Math::Matrix4 & linear) :
+      _linear(linear), _valid(false)
+    {}
     // The linear part of the view matrix used for the environment render
     Math::Matrix4 _linear;
+    // False when the cubemap face no longer matches the environment
+    bool _valid;
   };
 
   // Stores all environment renders used for dynmaic reflections and 
-  // refractions. The environment renders are stored in the following
-  // order.
-  // up, down, left, right, front, back
+  // refractions. Each one renders a face of the environment cubemap, so they
+  // are stored in the order of the cubemap faces.
+  // right, left, up, down, back, front
   static std::vector<EnvironmentRender> _environmentRenders;
+  // The framebuffer containing the environment cubemap
+  static Framebuffer _environmentFramebuffer;
+
+  // How the environment renders are updated
+  static EnvironmentUpdate _environmentUpdate;
+  // The maximum number of times per second the environment is invalidated.
+  // A value of zero will invalidate the environment as soon as it changes.
+  static float _environmentUpdateRate;
+  // The number of environment faces that were rendered during the last frame
+  static int _environmentFacesRendered;
 
+  // When true, rough reflections sample a cubemap whose mip levels are
+  // convolved with GGX lobes of increasing roughness. Otherwise they sample
+  // the box filtered mip levels of the environment cubemap.
+  static bool _prefilterEnvironment;
+  // The framebuffer containing the prefiltered environment cubemap
+  static Framebuffer _prefilterFramebuffer;
+  // The number of prefiltered faces (across all levels) rendered per frame
+  static int _prefilterFacesPerFrame;
+  // The number of prefiltered faces rendered since the environment changed
+  static unsigned int _prefilterFacesComplete;
+
+  // Skips drawing objects whose bounding volumes are outside of the frustum
+  static bool _frustumCulling;
+  // The number of objects that were tested and culled during the last time
+  // each pass was rendered
+  static int _testedObjects[RENDER_PASSES];
+  static int _culledObjects[RENDER_PASSES];
+
+  // Gpu times for the different parts of a frame
+  static GPUTimer _environmentTimer;
+  static GPUTimer _prefilterTimer;
+  static GPUTimer _skyboxTimer;
+  static GPUTimer _meshTimer;
+  // Schedules the passes of every frame and times each of them
+  static FrameGraph _frameGraph;
+  // Sorts the draws of every RenderFrame by their state and depth
+  static RenderQueue _renderQueue;
+
+  // When true, the mesh is drawn BENCHMARK_DRAWS extra times with the phong
+  // shader that branches on material uniforms and with the material's
+  // variant. Each is timed so their fragment costs can be compared.
+  static bool _benchmarkPhongVariants;
+  static GPUTimer _uberTimer;
+  static GPUTimer _variantTimer;
+
+  // The time it took to load every skybox one after another on the main
+  // thread and the time it took when they were requested from the pool
+  static float _serialSkyboxMilliseconds;
+  static float _requestSkyboxMilliseconds;
+  // The millions of pixels per second Texture::CreateNormalMap made from an
+  // 8K height map
+  static float _normalMapThroughput;
+  // The time stb and the ImageDecoder took to decode every skybox face and
+  // material map
+  static float _stbDecodeMilliseconds;
+  static float _decoderMilliseconds;
+  // The spheres drawn by BenchmarkRenderQueue, the time it took to sort
+  // them, and the time and state changes of submitting them sorted and in
+  // the order they were pushed
+  static int _queueBenchmarkDraws;
+  static float _queueSortMilliseconds;
+  static float _queueSubmitMilliseconds;
+  static float _unsortedSubmitMilliseconds;
+  static int _queueStateChanges;
+  static int _unsortedStateChanges;
+private:
+  static bool InFrustum(const Math::Vector4 planes[6],
+    const MeshRenderer::MeshObject * mesh_object, const Math::Matrix4 & model,
+    float scale, unsigned int pass);
+  static void CaptureEnvironmentState(std::vector<float> * state);
+  static void UpdateEnvironmentValidity();
+  static void PrefilterEnvironment();
+  static void PrefilterFaces();
+  static void GenerateNormalMap();
+  static void RenderFeedback(const Math::Matrix4 & projection,
+    const Math::Matrix4 & view, Framebuffer * target);
+  static Math::Matrix4 MeshModel();
+  static void UpdateVirtualTextures();
+  static void BindMeshTextures(bool virtual_texturing, bool texture_array,
+    TextureObject * normal_texture, TextureObject * environment_texture);
+  static void SetMeshUniforms(const Math::Vector3 & view_position,
+    float environment_max_lod, bool clustered);
+  static float ViewDepth(const Math::Matrix4 & view,
+    const Math::Vector3 & position);
+  static void SetPhongUniforms(PhongShader * phong_shader,
+    const Math::Vector3 & view_position, float environment_max_lod,
+    bool clustered);
+  static void BenchmarkPhongVariants(const Math::Matrix4 & projection,
+    const Math::Matrix4 & view, const Math::Vector3 & view_position,
+    const Math::Matrix4 & model, float environment_max_lod);
+  // Everything that affected the environment renders when they were last
+  // invalidated. Compared against every frame to find changes.
+  static std::vector<float> _environmentState;
+  static Skybox * _environmentSkybox;
+  // The time at which the environment renders were last invalidated
+  static float _environmentInvalidationTime;
+  // The face that time slicing will start searching from
+  static unsigned int _nextEnvironmentFace;
+  // An empty vertex array used for drawing the fullscreen prefilter triangle
+  static GLuint _emptyVAO;
+  //! The height map the generated normal map is made from
+  static TextureObject * _heightTextureObject;
+  //! Holds the generated normal map
+  static Framebuffer _normalMapFramebuffer;
+  //! The latest feedback read back from the feedback buffer
+  static std::vector<unsigned short> _feedback;
+  // The light spheres that pass culling. Kept between frames so the memory
+  // is reused.
+  static std::vector<MeshRenderer::Instance> _lightInstances;
+  // The next prefiltered face that will be rendered. This continues from where
+  // it stopped when the environment changes so every level is kept current.
+  static unsigned int _nextPrefilterFace;
 };
 
 #endif
\ No newline at end of file
@@ -11,59 +11,136 @@
 */
 /*****************************************************************************/
 
+#include <algorithm>
+#include <chrono>
+#include <cstring>
 #include <iostream>
 #include <fstream>
+#include <sstream>
 
 #include "../../Utility/Error.h"
 #include "../../Utility/OpenGLError.h"
 
+#include "ShaderCache.h"
 #include "Shader.h"
 
 //! The size of the buffer (in bytes) that is used to store the errors
 // encountered during the shader link and compile steps.
 #define ERROR_BUFFER_SIZE 512
 
+// static initializations
+unsigned long long Shader::_uniformUploads = 0;
+unsigned long long Shader::_uniformSkips = 0;
+int Shader::_fileReads = 0;
+int Shader::_fileCacheHits = 0;
+std::unordered_map<std::string, std::string> Shader::_fileCache;
+
+// Creates the FNV-1a hash that uniforms and uniform blocks are found with
+static unsigned long long HashName(const char * name)
+{
+  unsigned long long hash = FNV_OFFSET;
+  for (; *name; ++name) {
+    hash ^= (unsigned char)*name;
+    hash *= FNV_PRIME;
+  }
+  return hash;
+}
+
+// Gives every path to a file the same spelling. Slashes become forward
+// slashes and "." and "dir/.." segments are removed, so "a/./b.glsl",
+// "a\b.glsl", and "a/c/../b.glsl" all become "a/b.glsl". ".." segments that
+// leave the starting directory are kept.
+static std::string NormalizePath(const std::string & path)
+{
+  std::vector<std::string> segments;
+  std::size_t start = 0;
+  while (start <= path.size()) {
+    std::size_t end = path.find_first_of("/\\", start);
+    if (end == std::string::npos)
+      end = path.size();
+    std::string segment = path.substr(start, end - start);
+    if (segment == ".." && !segments.empty() && segments.back() != "..")
+      segments.pop_back();
+    else if (!segment.empty() && segment != ".")
+      segments.push_back(segment);
+    start = end + 1;
+  }
+  std::string normalized;
+  if (!path.empty() && (path[0] == '/' || path[0] == '\\'))
+    normalized = "/";
+  for (std::size_t i = 0; i < segments.size(); ++i) {
+    if (i > 0)
+      normalized += "/";
+    normalized += segments[i];
+  }
+  return normalized;
+}
+
 /*****************************************************************************/
 /*!
 \brief
   The constructor for a shader. Given the path to the vertex and fragment shader
-  files from the executable directory, the constructor will compile and link
-  the shaders.
+  files from the executable directory, the constructor will submit the shaders
+  for compiling and linking. Nothing waits for the driver to finish, so many
+  shaders can be created together and the driver can build them at the same
+  time. If the ShaderCache has a program created from the same sources, that
+  program is restored instead. Ready or Finish must be called before the
+  shader is used.
 
 \param vertex_file
   The path to the vertex shader from the executable.
 
 \param fragment_file
   The path to the fragment shader from the executable.
+
+\param defines
+  #define lines that are added to both shaders after their #version line.
+  This is used for compiling different variants of the same shader files.
 */
 /*****************************************************************************/
 Shader::Shader(const std::string & vertex_file, 
-               const std::string & fragment_file) :
-_vertexFile(vertex_file), _fragmentFile(fragment_file)
+               const std::string & fragment_file,
+               const std::string & defines) :
+_programID(0), _compiled(false), _pending(false),
+_vertexFile(vertex_file), _fragmentFile(fragment_file), _defines(defines),
+_vertexShader(0), _fragmentShader(0), _cacheKey(0),
+_optionalUniforms(false)
 {
+  std::chrono::high_resolution_clock::time_point start =
+    std::chrono::high_resolution_clock::now();
   try
   {
-    //compile shaders
-    GLuint vshader = CompileShader(vertex_file, GL_VERTEX_SHADER);
-    GLuint fshader = CompileShader(fragment_file, GL_FRAGMENT_SHADER);
-    //link shaders
-    CreateProgram(vshader, fshader);
-    _compiled = true;
+    //read sources
+    std::string vertex_source = ReadShaderFile(vertex_file, &_vertexFiles);
+    std::string fragment_source =
+      ReadShaderFile(fragment_file, &_fragmentFiles);
+    InjectDefines(&vertex_source);
+    InjectDefines(&fragment_source);
+    _cacheKey = ShaderCache::Key(vertex_source, fragment_source);
+    if (!ShaderCache::Load(_cacheKey, &_programID)) {
+      //submit shaders
+      _vertexShader = CompileShader(vertex_source, GL_VERTEX_SHADER);
+      _fragmentShader = CompileShader(fragment_source, GL_FRAGMENT_SHADER);
+      //submit link
+      CreateProgram();
+    }
+    _pending = true;
   }
   catch (Error & error) 
   { 
-    _compiled = false;
-    error.Add("<Shader Files Involved>");
-    error.Add(vertex_file.c_str());
-    error.Add(fragment_file.c_str());
-    ErrorLog::Write(error);
+    ReportError(error);
   }
+  std::chrono::duration<float, std::milli> build_time =
+    std::chrono::high_resolution_clock::now() - start;
+  ShaderCache::_buildMilliseconds += build_time.count();
 }
 
 /*****************************************************************************/
 /*!
 \brief
-  Used to check whether a shader successfully compiled or not.
+  Used to check whether a shader successfully compiled or not. This does not
+  wait for the driver, so it is false until Ready or Finish completes the
+  shader.
 
 \return True if the shader successfully compiled.
 */
@@ -73,11 +150,122 @@ bool Shader::Compiled()
   return _compiled;
 }
 
+/*****************************************************************************/
+/*!
+\brief
+  Checks whether the shader can be used without waiting for the driver. When
+  the driver supports GL_ARB_parallel_shader_compile, this only completes the
+  shader once the driver reports that the link is done. Otherwise the shader
+  is completed the first time this is called.
+
+\return True if the shader was built and its uniforms were found.
+*/
+/*****************************************************************************/
+bool Shader::Ready()
+{
+  if (_pending) {
+    if (GLEW_ARB_parallel_shader_compile) {
+      GLint complete = GL_FALSE;
+      glGetProgramiv(_programID, GL_COMPLETION_STATUS_ARB, &complete);
+      if (complete == GL_FALSE)
+        return false;
+    }
+    Complete();
+  }
+  return _compiled;
+}
+
+/*****************************************************************************/
+/*!
+\brief
+  Waits for the driver to finish building the shader and completes it.
+
+\return True if the shader was built and its uniforms were found.
+*/
+/*****************************************************************************/
+bool Shader::Finish()
+{
+  if (_pending)
+    Complete();
+  return _compiled;
+}
+
+/*****************************************************************************/
+/*!
+\brief
+  Used to check whether the driver may still be building the shader. A shader
+  that is not ready and not pending failed to build.
+
+\return True if the shader has not been completed.
+*/
+/*****************************************************************************/
+bool Shader::Pending() const
+{
+  return _pending;
+}
+
+/*****************************************************************************/
+/*!
+\brief
+  Checks whether the shader is built from a file. This includes the files
+  that were included by the vertex and fragment shader files.
+
+\param filename
+  The name of the file. This can be the full path or a name relative to any
+  of the directories in the path.
+
+\return True if the shader was built with the file.
+*/
+/*****************************************************************************/
+bool Shader::UsesFile(const std::string & filename) const
+{
+  const std::vector<std::string> * stages[2] = { &_vertexFiles,
+    &_fragmentFiles };
+  for (const std::vector<std::string> * files : stages) {
+    for (const std::string & file : *files) {
+      if (file.size() < filename.size())
+        continue;
+      std::size_t start = file.size() - filename.size();
+      if (file.compare(start, std::string::npos, filename) != 0)
+        continue;
+      if (start == 0 || file[start - 1] == '/' || file[start - 1] == '\\')
+        return true;
+    }
+  }
+  return false;
+}
+
+// Removes every file the shader was built from from the file cache, so
+// building the shader again reads them from disk
+void Shader::InvalidateFiles() const
+{
+  for (const std::string & file : _vertexFiles)
+    InvalidateFile(file);
+  for (const std::string & file : _fragmentFiles)
+    InvalidateFile(file);
+}
+
+/*****************************************************************************/
+/*!
+\brief
+  Removes a file from the file cache. Shaders that are created afterwards
+  read the file from disk again.
+
+\param file
+  The path of the file from the executable.
+*/
+/*****************************************************************************/
+void Shader::InvalidateFile(const std::string & file)
+{
+  _fileCache.erase(NormalizePath(file));
+}
+
 /*****************************************************************************/
 /*!
 \brief
   Will find the location of an attribute given the name of the attribute.
-  Writes an error to the ErrorLog if the attribute is not found.
+  Writes an error to the ErrorLog if the attribute is not found. Variants
+  compiled with defines can remove attributes, so they do not write errors.
 
 \par Important Notes
   - Call Use() on the shader instance before calling this function.
@@ -91,7 +279,7 @@ bool Shader::Compiled()
  GLuint Shader::GetAttribLocation(const std::string & name)
 {
   GLuint attribute_location = glGetAttribLocation(_programID, name.c_str());
-  if (attribute_location == -1) {
+  if (attribute_location == -1 && _defines.empty()) {
     Error error("Shader.cpp", "GetAttribLocation");
     error.Add("An attribute was not found.");
     error.Add("<Attribute name>");
@@ -106,31 +294,90 @@ bool Shader::Compiled()
 /*****************************************************************************/
 /*!
 \brief
-  Will find the location of an uniform given the name of the uniform. Writes
-  an error to the ErrorLog if the uniform is not found.
-
-\par Important Notes
-  - Call Use() on the shader instance before calling this function.
+  Finds the location of a uniform in the table that was created when the
+  program was linked.
 
 \param name
-  The name of the uniform being searched for.
+  The name of the uniform. Elements of arrays and members of structs are
+  named the way they are in GLSL, like "ULights[2].UType".
 
-\return The GLuint uniform location.
+\return The uniform location or -1 if the uniform is not active.
 */
 /*****************************************************************************/
-GLuint Shader::GetUniformLocation(const std::string & name)
+GLint Shader::GetUniformLocation(const char * name) const
 {
-  GLuint uniform_location = glGetUniformLocation(_programID, name.c_str());
-  if (uniform_location == -1) {
-    Error error("Shader.cpp", "GetUniformLocation");
-    error.Add("An uniform was not found.");
-    error.Add("<Uniform name>");
-    error.Add(name.c_str());
-    error.Add("<Shader Files Involved>");
-    error.Add(_vertexFile); error.Add(_fragmentFile);
-    ErrorLog::Write(error);
-  }
-  return uniform_location;
+  std::unordered_map<unsigned long long, unsigned int>::const_iterator it =
+    _uniformTable.find(HashName(name));
+  if (it == _uniformTable.end())
+    return -1;
+  return _uniforms[it->second]._location;
+}
+
+// Returns the index of a uniform block or GL_INVALID_INDEX if the program
+// does not use the block
+GLuint Shader::GetUniformBlockIndex(const char * name) const
+{
+  std::unordered_map<unsigned long long, GLuint>::const_iterator it =
+    _uniformBlocks.find(HashName(name));
+  if (it == _uniformBlocks.end())
+    return GL_INVALID_INDEX;
+  return it->second;
+}
+
+unsigned int Shader::UniformCount() const
+{
+  return (unsigned int)_uniforms.size();
+}
+
+void Shader::SetUniform1i(const char * name, GLint value)
+{
+  Uniform * uniform = FindUniform(name);
+  if (uniform && Changed(uniform, &value, sizeof(GLint)))
+    glUniform1i(uniform->_location, value);
+}
+
+void Shader::SetUniform1f(const char * name, GLfloat value)
+{
+  Uniform * uniform = FindUniform(name);
+  if (uniform && Changed(uniform, &value, sizeof(GLfloat)))
+    glUniform1f(uniform->_location, value);
+}
+
+void Shader::SetUniform2f(const char * name, GLfloat x, GLfloat y)
+{
+  GLfloat value[2] = { x, y };
+  Uniform * uniform = FindUniform(name);
+  if (uniform && Changed(uniform, value, sizeof(value)))
+    glUniform2f(uniform->_location, x, y);
+}
+
+void Shader::SetUniform3f(const char * name, GLfloat x, GLfloat y, GLfloat z)
+{
+  GLfloat value[3] = { x, y, z };
+  Uniform * uniform = FindUniform(name);
+  if (uniform && Changed(uniform, value, sizeof(value)))
+    glUniform3f(uniform->_location, x, y, z);
+}
+
+// Matrices are row major, so they are transposed when they are uploaded
+void Shader::SetUniformMatrix4(const char * name, const Math::Matrix4 & matrix)
+{
+  Uniform * uniform = FindUniform(name);
+  if (uniform && Changed(uniform, matrix.array, 16 * sizeof(GLfloat)))
+    glUniformMatrix4fv(uniform->_location, 1, GL_TRUE, matrix.array);
+}
+
+// Uniforms set until EndOptionalUniforms is called are not reported when the
+// program does not use them. This is for values that are shared by shaders
+// or variants that only use some of them.
+void Shader::BeginOptionalUniforms()
+{
+  _optionalUniforms = true;
+}
+
+void Shader::EndOptionalUniforms()
+{
+  _optionalUniforms = false;
 }
 
 /*****************************************************************************/
@@ -169,7 +416,12 @@ void Shader::Use() const
 /*****************************************************************************/
 void Shader::Purge() const
 {
-  if(_compiled)
+  // a shader that is still being built has not released its stages
+  if (_vertexShader)
+    glDeleteShader(_vertexShader);
+  if (_fragmentShader)
+    glDeleteShader(_fragmentShader);
+  if (_programID)
     glDeleteProgram(_programID);
   // error check
   GLenum error_code = glGetError();
@@ -184,46 +436,227 @@ void Shader::Purge() const
 /*****************************************************************************/
 /*!
 \brief
-  Should be overloaded by the derived Shader type. Specifies Responsible
-  for specifying the layout of shader attributes when reading vertex arrays.
+  Checks the results of the compile and link that were submitted by the
+  constructor. If they succeeded, the program is saved to the ShaderCache and
+  the active uniforms are found. This waits for the driver if it is not done.
 */
 /*****************************************************************************/
-void Shader::EnableAttributes()
-{}
+void Shader::Complete()
+{
+  std::chrono::high_resolution_clock::time_point start =
+    std::chrono::high_resolution_clock::now();
+  _pending = false;
+  try
+  {
+    // programs restored from the cache have no stages to check
+    if (_vertexShader) {
+      CheckShader(_vertexShader, _vertexFiles);
+      CheckShader(_fragmentShader, _fragmentFiles);
+      CheckProgram();
+      ShaderCache::Save(_cacheKey, _programID);
+    }
+    _compiled = true;
+    Reflect();
+  }
+  catch (Error & error)
+  {
+    _compiled = false;
+    ReportError(error);
+  }
+  //deleting shaders
+  if (_vertexShader) {
+    glDetachShader(_programID, _vertexShader);
+    glDetachShader(_programID, _fragmentShader);
+    glDeleteShader(_vertexShader);
+    glDeleteShader(_fragmentShader);
+    _vertexShader = 0;
+    _fragmentShader = 0;
+  }
+  std::chrono::duration<float, std::milli> build_time =
+    std::chrono::high_resolution_clock::now() - start;
+  ShaderCache::_buildMilliseconds += build_time.count();
+}
+
+/*****************************************************************************/
+/*!
+\brief
+  Finds every active uniform and uniform block in the linked program and
+  adds them to the tables that the SetUniform functions search. Uniforms in
+  blocks have no location and are set through buffers instead.
+*/
+/*****************************************************************************/
+void Shader::Reflect()
+{
+  _uniforms.clear();
+  _uniformTable.clear();
+  _uniformBlocks.clear();
+  _missingUniforms.clear();
+  GLint uniform_count = 0;
+  GLint max_length = 0;
+  glGetProgramiv(_programID, GL_ACTIVE_UNIFORMS, &uniform_count);
+  glGetProgramiv(_programID, GL_ACTIVE_UNIFORM_MAX_LENGTH, &max_length);
+  std::vector<GLchar> name_buffer(max_length + 1);
+  for (GLint i = 0; i < uniform_count; ++i) {
+    GLsizei length = 0;
+    GLint size = 0;
+    GLenum type = 0;
+    glGetActiveUniform(_programID, (GLuint)i, (GLsizei)name_buffer.size(),
+      &length, &size, &type, name_buffer.data());
+    std::string name(name_buffer.data(), length);
+    GLint location = glGetUniformLocation(_programID, name.c_str());
+    if (location == -1)
+      continue;
+    // Arrays of basic types are reported once as name[0]. Every element is
+    // added and the name without [0] refers to the first element.
+    std::size_t array_start = name.size() - 3;
+    if (name.size() > 3 && name.compare(array_start, 3, "[0]") == 0) {
+      std::string base = name.substr(0, array_start);
+      AddUniform(name, location, type);
+      _uniformTable[HashName(base.c_str())] =
+        (unsigned int)_uniforms.size() - 1;
+      for (GLint e = 1; e < size; ++e) {
+        std::string element = base + "[" + std::to_string(e) + "]";
+        AddUniform(element,
+          glGetUniformLocation(_programID, element.c_str()), type);
+      }
+    }
+    else
+      AddUniform(name, location, type);
+  }
+  GLint block_count = 0;
+  glGetProgramiv(_programID, GL_ACTIVE_UNIFORM_BLOCKS, &block_count);
+  glGetProgramiv(_programID, GL_ACTIVE_UNIFORM_BLOCK_MAX_NAME_LENGTH,
+    &max_length);
+  name_buffer.resize(max_length + 1);
+  for (GLint i = 0; i < block_count; ++i) {
+    glGetActiveUniformBlockName(_programID, (GLuint)i,
+      (GLsizei)name_buffer.size(), nullptr, name_buffer.data());
+    _uniformBlocks[HashName(name_buffer.data())] = (GLuint)i;
+  }
+}
+
+void Shader::AddUniform(const std::string & name, GLint location,
+  GLenum type)
+{
+  unsigned long long hash = HashName(name.c_str());
+  // Two names with the same hash would set each other's values, which is
+  // too unlikely to handle but not too unlikely to report
+  std::unordered_map<unsigned long long, unsigned int>::iterator it =
+    _uniformTable.find(hash);
+  if (it != _uniformTable.end()) {
+    Error error("Shader.cpp", "AddUniform");
+    error.Add("Two uniform names have the same hash.");
+    error.Add("<Uniform names>");
+    error.Add(_uniforms[it->second]._name);
+    error.Add(name);
+    error.Add("<Shader Files Involved>");
+    error.Add(_vertexFile); error.Add(_fragmentFile);
+    ErrorLog::Write(error);
+    return;
+  }
+  Uniform uniform;
+  uniform._name = name;
+  uniform._location = location;
+  uniform._type = type;
+  uniform._set = false;
+  _uniformTable[hash] = (unsigned int)_uniforms.size();
+  _uniforms.push_back(uniform);
+}
+
+// Uniforms that are not active and not optional are usually misspelled or
+// were removed from the shader, so they are reported the first time they are
+// set. Nothing is reported before the uniforms of the program are found.
+Shader::Uniform * Shader::FindUniform(const char * name)
+{
+  unsigned long long hash = HashName(name);
+  std::unordered_map<unsigned long long, unsigned int>::iterator it =
+    _uniformTable.find(hash);
+  if (it != _uniformTable.end())
+    return &_uniforms[it->second];
+  if (_compiled && !_optionalUniforms && _missingUniforms.insert(hash).second)
+  {
+    Error error("Shader.cpp", "FindUniform");
+    error.Add("A uniform that is not active in the program was set.");
+    error.Add("<Uniform name>");
+    error.Add(name);
+    ReportError(error);
+  }
+  return nullptr;
+}
+
+// Records a value that is about to be set. False is returned when the
+// program already has the value and the upload can be skipped.
+bool Shader::Changed(Uniform * uniform, const void * value, std::size_t bytes)
+{
+  if (uniform->_set && std::memcmp(uniform->_value, value, bytes) == 0) {
+    ++_uniformSkips;
+    return false;
+  }
+  std::memcpy(uniform->_value, value, bytes);
+  uniform->_set = true;
+  ++_uniformUploads;
+  return true;
+}
 
 /*****************************************************************************/
 /*!
 \brief
-  Should be overloaded by a derived Shader type. Simply disables any vertex
-  attributes associated with the shader.
+  Adds the files involved with the shader to an error and writes it to the
+  ErrorLog.
+
+\param error
+  The error that was encountered while building the shader.
 */
 /*****************************************************************************/
-void Shader::DisableAttributes()
-{}
+void Shader::ReportError(Error & error) const
+{
+  error.Add("<Shader Files Involved>");
+  error.Add(_vertexFile.c_str());
+  error.Add(_fragmentFile.c_str());
+  if (!_defines.empty())
+    error.Add(_defines.c_str());
+  ErrorLog::Write(error);
+}
 
 /*****************************************************************************/
 /*!
 \brief
-  This will compile a single shader. If any errors occur during the compilation
-  of the shader, the function will throw an Error.
+  This will submit a single shader for compiling. The result is not checked
+  here so the driver does not have to finish the compile before returning.
 
-\param filename
-  The path the shader file from the executable directory.
+\param source
+  The source of the shader.
 \param type
   The type of shader being compiled. (GL_VERTEX_SHADER, GL_FRAGMENT_SHADER)
 
-\return The ID of the compiled shader.
+\return The ID of the shader.
 */
 /*****************************************************************************/
-GLuint Shader::CompileShader(const std::string & filename, GLenum type) const
+GLuint Shader::CompileShader(const std::string & source, GLenum type) const
 {
-  //read from file
-  std::string shader_content = ReadShaderFile(filename);
-  const GLchar * shader_cstr = shader_content.c_str();
+  const GLchar * shader_cstr = source.c_str();
   //create and compile
   GLuint shader = glCreateShader(type);
   glShaderSource(shader, 1, &shader_cstr, nullptr);
   glCompileShader(shader);
+  return shader;
+}
+
+/*****************************************************************************/
+/*!
+\brief
+  Checks whether a submitted shader compiled. If it did not, the function will
+  throw an Error containing the compile errors.
+
+\param shader
+  The ID of the shader.
+\param filename
+  The path the shader file from the executable directory.
+*/
+/*****************************************************************************/
+void Shader::CheckShader(GLuint shader,
+  const std::vector<std::string> & files) const
+{
   //check for success
   GLint success;
   glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
@@ -234,69 +667,177 @@ GLuint Shader::CompileShader(const std::string & filename, GLenum type) const
     glGetShaderInfoLog(shader, ERROR_BUFFER_SIZE, nullptr, errorlog);
     Error error("Shader.cpp" ,"CompileShader");
     error.Add("SHADER COMPILE ERROR");
-    error.Add(filename.c_str());
+    // the compiler refers to files by their source string number
+    for (unsigned int i = 0; i < files.size(); ++i)
+      error.Add(std::to_string(i) + ": " + files[i]);
     error.Add(errorlog);
     throw(error);
   }
-  return shader;
 }
 
 /*****************************************************************************/
 /*!
 \brief
-  Reads an entire shader file into a standard string.
+  Reads an entire shader file into a standard string and replaces its
+  #include lines with the contents of the included files.
 
 \param shader_file
   The path to the shader file that will be read.
+\param files
+  The shader file and every file it included are added to this. The index of
+  a file is the source string number the compiler uses for it.
 
-\return A standard string containing the contents of the shader file. If the
-  file could not be opened, the function will throw an Error.
+\return A standard string containing the preprocessed shader. If a file
+  could not be opened, the function will throw an Error.
 */
 /*****************************************************************************/
-std::string Shader::ReadShaderFile(const std::string & shader_file) const
+std::string Shader::ReadShaderFile(const std::string & shader_file,
+  std::vector<std::string> * files) const
+{
+  files->clear();
+  std::string content;
+  Preprocess(NormalizePath(shader_file), files, &content);
+  return content;
+}
+
+/*****************************************************************************/
+/*!
+\brief
+  Adds a file to the preprocessed source. #line directives are placed around
+  included files so compile errors refer to the line in the file the error
+  is actually in.
+
+\param file
+  The normalized path of the file from the executable.
+\param files
+  The files that were already included. Those files are skipped, which also
+  stops files that include each other from being included forever. Include
+  paths are normalized against the including file's directory before they
+  are compared, so different spellings of a path are the same file.
+\param content
+  The preprocessed source that the file is added to.
+*/
+/*****************************************************************************/
+void Shader::Preprocess(const std::string & file,
+  std::vector<std::string> * files, std::string * content) const
+{
+  files->push_back(file);
+  unsigned int file_number = (unsigned int)files->size() - 1;
+  std::string directory;
+  std::size_t slash = file.find_last_of("/\\");
+  if (slash != std::string::npos)
+    directory = file.substr(0, slash + 1);
+  std::istringstream stream(ReadFile(file));
+  std::string line;
+  unsigned int line_number = 0;
+  while (std::getline(stream, line)) {
+    ++line_number;
+    std::size_t start = line.find_first_not_of(" \t");
+    if (start == std::string::npos || line.compare(start, 8, "#include") != 0) {
+      content->append(line + "\n");
+      continue;
+    }
+    std::size_t name_start = line.find('"', start);
+    std::size_t name_end = name_start == std::string::npos ?
+      std::string::npos : line.find('"', name_start + 1);
+    if (name_end == std::string::npos) {
+      Error error("Shader.cpp", "Preprocess");
+      error.Add("An #include line is missing its quoted file name.");
+      error.Add(file + " line " + std::to_string(line_number));
+      error.Add(line);
+      throw(error);
+    }
+    std::string include = NormalizePath(directory +
+      line.substr(name_start + 1, name_end - name_start - 1));
+    if (std::find(files->begin(), files->end(), include) != files->end())
+      continue;
+    content->append("#line 1 " + std::to_string(files->size()) + "\n");
+    Preprocess(include, files, content);
+    content->append("#line " + std::to_string(line_number + 1) + " " +
+      std::to_string(file_number) + "\n");
+  }
+}
+
+// Reads a file from disk or from the file cache if it was already read
+const std::string & Shader::ReadFile(const std::string & file)
 {
-  //opening file
-  std::ifstream file(shader_file.c_str());
-  if (!file.is_open())
+  std::unordered_map<std::string, std::string>::iterator it =
+    _fileCache.find(file);
+  if (it != _fileCache.end()) {
+    ++_fileCacheHits;
+    return it->second;
+  }
+  std::ifstream stream(file.c_str());
+  if (!stream.is_open())
   {
     Error error("Shader.cpp", "ReadShaderFile");
     error.Add("The following Shader file failed to open.");
-    error.Add(shader_file.c_str());
+    error.Add(file.c_str());
     throw(error);
   }
-  //copying over data
-  std::string content;
-  std::string line;
-  std::getline(file, line);
-  while (!file.eof())
-  {
-    content.append(line + "\n");
-    std::getline(file, line);
+  std::stringstream content;
+  content << stream.rdbuf();
+  ++_fileReads;
+  return _fileCache[file] = content.str();
+}
+
+/*****************************************************************************/
+/*!
+\brief
+  Adds the shader's defines to the shader source. The #version directive must
+  come first, so the defines are placed on the line after it.
+
+\param content
+  The shader source that the defines will be added to.
+*/
+/*****************************************************************************/
+void Shader::InjectDefines(std::string * content) const
+{
+  if (_defines.empty())
+    return;
+  std::size_t version = content->find("#version");
+  std::size_t insert = 0;
+  if (version != std::string::npos) {
+    insert = content->find('\n', version);
+    insert = (insert == std::string::npos) ? content->size() : insert + 1;
   }
-  return content;
+  // the lines after the defines keep the numbers they have in the file
+  unsigned int next_line =
+    (unsigned int)std::count(content->begin(), content->begin() + insert,
+    '\n') + 1;
+  content->insert(insert, _defines + "#line " + std::to_string(next_line) +
+    "\n");
 }
 
 /*****************************************************************************/
 /*!
 \brief
-  Links and creates the shader program given a compiled vertex and fragment 
-  shader. If any errors occur during the link step, an exception of type Error
-  is thrown. The string contains the linker error generated when the shaders
-  were linked.
-
-\param vshader
-  The compiled vertex shader ID.
-\param fshader
-  The compiled fragment shader ID.
+  Creates the shader program from the submitted vertex and fragment shaders
+  and submits it for linking. The result is not checked here.
 */
 /*****************************************************************************/
-void Shader::CreateProgram(GLuint vshader, GLuint fshader)
+void Shader::CreateProgram()
 {
   //creating program and linking shaders
   _programID = glCreateProgram();
-  glAttachShader(_programID, vshader);
-  glAttachShader(_programID, fshader);
+  glAttachShader(_programID, _vertexShader);
+  glAttachShader(_programID, _fragmentShader);
+  if (ShaderCache::Supported())
+    glProgramParameteri(_programID, GL_PROGRAM_BINARY_RETRIEVABLE_HINT,
+      GL_TRUE);
   glLinkProgram(_programID);
+}
+
+/*****************************************************************************/
+/*!
+\brief
+  Checks whether the program linked. If any errors occured during the link
+  step, an exception of type Error is thrown. The string contains the linker
+  error generated when the shaders were linked.
+*/
+/*****************************************************************************/
+void Shader::CheckProgram() const
+{
   //checking for success
   GLint success;
   glGetProgramiv(_programID, GL_LINK_STATUS, &success);
@@ -310,9 +851,4 @@ void Shader::CreateProgram(GLuint vshader, GLuint fshader)
     error.Add(errorlog);
     throw(error);
   }
-  //deleting shaders
-  glDetachShader(_programID, vshader);
-  glDetachShader(_programID, fshader);
-  glDeleteShader(vshader);
-  glDeleteShader(fshader);
 }
\ No newline at end of file
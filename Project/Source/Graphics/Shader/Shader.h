@@ -15,8 +15,15 @@
 #define SHADER_H
 
 #include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
 #include <GL\glew.h>
 
+#include "../../Math/Matrix4.h"
+
+class Error;
+
 /*****************************************************************************/
 /*!
 \class Shader
@@ -26,33 +33,124 @@
   shader class will compile, link, and use those shaders to create a shader
   program. That shader can then be managed with this object. Contact me if you 
   want to know about how to write and manipulate shaders.
+
+\par Important Notes
+  - Shaders are built in the background by the driver. Check Ready before
+    drawing, or call Finish when the shader is needed right away.
+  - Vertex shaders declare their inputs at the locations in VertexFormat.h,
+    so vertex arrays do not depend on the shader that draws them.
+  - The active uniforms are found once the program is linked. The SetUniform
+    functions find a uniform by name and only call OpenGL when its value
+    changed. Call Use() before setting uniforms. Uniforms that are not
+    active in the program are ignored and written to the ErrorLog the
+    first time they are set. Uniforms that only some variants use are set
+    between BeginOptionalUniforms and EndOptionalUniforms so they are not
+    reported.
+  - Shader files can contain #include "file" lines. The path is relative to
+    the including file and each file is only included once per stage. Files
+    are cached after they are read, so a changed file must be invalidated
+    before the shaders that use it are built again.
 */
 /*****************************************************************************/
 class Shader
 {
   public:
-    Shader(const std::string & vertex_file, const std::string & fragment_file);
+    Shader(const std::string & vertex_file, const std::string & fragment_file,
+      const std::string & defines = "");
+    // shaders are deleted through Shader pointers
+    virtual ~Shader() {}
     bool Compiled();
+    bool Ready();
+    bool Finish();
+    bool Pending() const;
+    bool UsesFile(const std::string & filename) const;
+    void InvalidateFiles() const;
     GLuint GetAttribLocation(const std::string & name);
-    GLuint GetUniformLocation(const std::string & name);
+    GLint GetUniformLocation(const char * name) const;
+    GLuint GetUniformBlockIndex(const char * name) const;
+    unsigned int UniformCount() const;
+    void SetUniform1i(const char * name, GLint value);
+    void SetUniform1f(const char * name, GLfloat value);
+    void SetUniform2f(const char * name, GLfloat x, GLfloat y);
+    void SetUniform3f(const char * name, GLfloat x, GLfloat y, GLfloat z);
+    void SetUniformMatrix4(const char * name, const Math::Matrix4 & matrix);
+    void BeginOptionalUniforms();
+    void EndOptionalUniforms();
     GLuint ID() const;
     virtual void Use() const;
     void Purge() const;
-    virtual void EnableAttributes();
-    virtual void DisableAttributes();
+    // The number of uniform values that were uploaded and the number that
+    // were skipped because the program already had them
+    static unsigned long long _uniformUploads;
+    static unsigned long long _uniformSkips;
+    static void InvalidateFile(const std::string & file);
+    // The number of files read from disk and the number of reads that used
+    // the file cache instead
+    static int _fileReads;
+    static int _fileCacheHits;
   protected:
     //! The ID of the program created after linking the shaders.
     GLuint _programID;
     //! Identifies whether the program successfully compiled or not.
     bool _compiled;
+    //! Identifies whether the driver may still be building the program.
+    bool _pending;
     //! The name of the vertex shader file.
     std::string _vertexFile;
     //! The name of the fragment shader file.
     std::string _fragmentFile;
+    //! The #define lines added to the start of both shader files.
+    std::string _defines;
+    //! Every file each stage was built from. A file's index is the source
+    //! string number the compiler reports errors with.
+    std::vector<std::string> _vertexFiles;
+    std::vector<std::string> _fragmentFiles;
   private:
-    GLuint CompileShader(const std::string & filename, GLenum type) const;
-    std::string ReadShaderFile(const std::string & shader_file) const;
-    void CreateProgram(GLuint vshader, GLuint fshader);
+    //! An active uniform and the last value that was uploaded to it.
+    struct Uniform
+    {
+      std::string _name;
+      GLint _location;
+      GLenum _type;
+      bool _set;
+      //! Large enough for a mat4. Integers are stored in the same bytes.
+      GLfloat _value[16];
+    };
+    void Complete();
+    void Reflect();
+    void AddUniform(const std::string & name, GLint location, GLenum type);
+    Uniform * FindUniform(const char * name);
+    bool Changed(Uniform * uniform, const void * value, std::size_t bytes);
+    void ReportError(Error & error) const;
+    GLuint CompileShader(const std::string & source, GLenum type) const;
+    void CheckShader(GLuint shader,
+      const std::vector<std::string> & files) const;
+    std::string ReadShaderFile(const std::string & shader_file,
+      std::vector<std::string> * files) const;
+    void Preprocess(const std::string & file, std::vector<std::string> * files,
+      std::string * content) const;
+    static const std::string & ReadFile(const std::string & file);
+    void InjectDefines(std::string * content) const;
+    void CreateProgram();
+    void CheckProgram() const;
+    //! The shader stages that are being built. Zero once released.
+    GLuint _vertexShader;
+    GLuint _fragmentShader;
+    //! The key the program is saved to the ShaderCache with.
+    unsigned long long _cacheKey;
+    //! The active uniforms of the program.
+    std::vector<Uniform> _uniforms;
+    //! Maps the hash of a uniform name to its index in _uniforms.
+    std::unordered_map<unsigned long long, unsigned int> _uniformTable;
+    //! Identifies whether uniforms that are not active are expected.
+    bool _optionalUniforms;
+    //! The hashes of the names that were set but are not active. Each is
+    //! only reported once.
+    std::unordered_set<unsigned long long> _missingUniforms;
+    //! Maps the hash of a uniform block name to the block's index.
+    std::unordered_map<unsigned long long, GLuint> _uniformBlocks;
+    //! The contents of every file that has been read, keyed by path.
+    static std::unordered_map<std::string, std::string> _fileCache;
 };
 
 #endif // SHADER_H
@@ -0,0 +1,189 @@
+/* All content(c) 2017 - 2018 DigiPen(USA) Corporation, all rights reserved. */
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <vector>
+
+#include "ShaderCache.h"
+
+// static initializations
+bool ShaderCache::_enabled = true;
+int ShaderCache::_hits = 0;
+int ShaderCache::_misses = 0;
+float ShaderCache::_buildMilliseconds = 0.0f;
+bool ShaderCache::_supported = false;
+std::string ShaderCache::_driver;
+std::unordered_set<unsigned long long> ShaderCache::_keys;
+
+// Adds a string and its terminator to an FNV-1a hash
+static void HashString(const std::string & string, unsigned long long * hash)
+{
+  for (char c : string) {
+    *hash ^= (unsigned char)c;
+    *hash *= FNV_PRIME;
+  }
+  *hash ^= 0;
+  *hash *= FNV_PRIME;
+}
+
+// Returns a gl string or an empty string if the driver does not provide it
+static std::string GetGLString(GLenum name)
+{
+  const GLubyte * string = glGetString(name);
+  if (!string)
+    return std::string();
+  return std::string((const char *)string);
+}
+
+/*****************************************************************************/
+/*!
+\brief
+  Finds whether the driver supports program binaries and records the driver
+  strings that are part of every key. Call this after the OpenGLContext is
+  initialized and before any shaders are created.
+*/
+/*****************************************************************************/
+void ShaderCache::Initialize()
+{
+  GLint formats = 0;
+  if (GLEW_ARB_get_program_binary)
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+  _supported = formats > 0;
+  _driver = GetGLString(GL_VENDOR);
+  _driver += GetGLString(GL_RENDERER);
+  _driver += GetGLString(GL_VERSION);
+  _driver += GetGLString(GL_SHADING_LANGUAGE_VERSION);
+}
+
+bool ShaderCache::Supported()
+{
+  return _supported && _enabled;
+}
+
+/*****************************************************************************/
+/*!
+\brief
+  Creates the key for a program. The sources should already contain any
+  defines that were added to them.
+
+\param vertex_source
+  The source of the program's vertex shader.
+\param fragment_source
+  The source of the program's fragment shader.
+
+\return The key of the program.
+*/
+/*****************************************************************************/
+unsigned long long ShaderCache::Key(const std::string & vertex_source,
+  const std::string & fragment_source)
+{
+  unsigned long long hash = FNV_OFFSET;
+  HashString(vertex_source, &hash);
+  HashString(fragment_source, &hash);
+  HashString(_driver, &hash);
+  return hash;
+}
+
+/*****************************************************************************/
+/*!
+\brief
+  Restores a program from the cache.
+
+\param key
+  The key of the program.
+\param program
+  The created program is written here when the program is restored.
+
+\return True if the program was restored. False if there was no entry or
+  the driver rejected the stored binary.
+*/
+/*****************************************************************************/
+bool ShaderCache::Load(unsigned long long key, GLuint * program)
+{
+  _keys.insert(key);
+  if (!Supported()) {
+    ++_misses;
+    return false;
+  }
+  std::ifstream file(Filename(key).c_str(), std::ios::binary);
+  if (!file.is_open()) {
+    ++_misses;
+    return false;
+  }
+  GLenum format = 0;
+  GLint length = 0;
+  file.read((char *)&format, sizeof(GLenum));
+  file.read((char *)&length, sizeof(GLint));
+  if (!file || length <= 0) {
+    ++_misses;
+    return false;
+  }
+  std::vector<char> binary(length);
+  file.read(binary.data(), length);
+  if (!file) {
+    ++_misses;
+    return false;
+  }
+  GLuint new_program = glCreateProgram();
+  glProgramBinary(new_program, format, binary.data(), length);
+  GLint success = 0;
+  glGetProgramiv(new_program, GL_LINK_STATUS, &success);
+  // an unknown format creates an error that must not reach the error checks
+  // done later
+  glGetError();
+  if (!success) {
+    glDeleteProgram(new_program);
+    ++_misses;
+    return false;
+  }
+  *program = new_program;
+  ++_hits;
+  return true;
+}
+
+/*****************************************************************************/
+/*!
+\brief
+  Writes a linked program to the cache. Nothing is written if the program
+  was not linked with GL_PROGRAM_BINARY_RETRIEVABLE_HINT.
+
+\param key
+  The key of the program.
+\param program
+  The linked program.
+*/
+/*****************************************************************************/
+void ShaderCache::Save(unsigned long long key, GLuint program)
+{
+  if (!Supported())
+    return;
+  GLint length = 0;
+  glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+  if (length <= 0)
+    return;
+  std::vector<char> binary(length);
+  GLenum format = 0;
+  glGetProgramBinary(program, length, &length, &format, binary.data());
+  // the cache directory may not exist, in which case nothing is cached
+  std::ofstream file(Filename(key).c_str(), std::ios::binary);
+  if (!file.is_open())
+    return;
+  file.write((const char *)&format, sizeof(GLenum));
+  file.write((const char *)&length, sizeof(GLint));
+  file.write(binary.data(), length);
+}
+
+// Removes the cache entries of every program created since the start, so
+// the next start will be a cold start
+void ShaderCache::Clear()
+{
+  for (unsigned long long key : _keys)
+    std::remove(Filename(key).c_str());
+}
+
+std::string ShaderCache::Filename(unsigned long long key)
+{
+  std::stringstream filename;
+  filename << SHADERCACHE_PATH << std::hex << key << ".program";
+  return filename.str();
+}
@@ -0,0 +1,54 @@
+/* All content(c) 2017 - 2018 DigiPen(USA) Corporation, all rights reserved. */
+#ifndef SHADERCACHE_H
+#define SHADERCACHE_H
+
+#include <string>
+#include <unordered_set>
+#include <GL/glew.h>
+
+// The directory linked programs are written to. It is relative to the
+// working directory like the shader files.
+#define SHADERCACHE_PATH "Cache/"
+// FNV-1a constants for 64 bit hashes
+#define FNV_OFFSET 14695981039346656037ULL
+#define FNV_PRIME 1099511628211ULL
+
+/*****************************************************************************/
+/*!
+\class ShaderCache
+\brief
+  Stores linked shader programs on disk so they can be restored with
+  glProgramBinary instead of being compiled and linked again. A program is
+  found by a hash of its shader sources and the driver that created it, so
+  editing a shader or updating the driver creates a new entry.
+*/
+/*****************************************************************************/
+class ShaderCache
+{
+public:
+  static void Initialize();
+  static bool Supported();
+  static unsigned long long Key(const std::string & vertex_source,
+    const std::string & fragment_source);
+  static bool Load(unsigned long long key, GLuint * program);
+  static void Save(unsigned long long key, GLuint program);
+  static void Clear();
+  // When false, programs are always compiled and nothing is saved
+  static bool _enabled;
+  // The number of programs that were restored from and missing from the cache
+  static int _hits;
+  static int _misses;
+  // The total cpu time spent creating shader programs
+  static float _buildMilliseconds;
+private:
+  ShaderCache() {}
+  static std::string Filename(unsigned long long key);
+  // Identifies whether the driver can save program binaries
+  static bool _supported;
+  // The vendor, renderer, and version strings of the driver
+  static std::string _driver;
+  // Every key that was used since the program started
+  static std::unordered_set<unsigned long long> _keys;
+};
+
+#endif // !SHADERCACHE_H
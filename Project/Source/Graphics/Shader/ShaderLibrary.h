@@ -14,59 +14,27 @@
 
 #include "Shader.h"
 
-#define MAXLIGHTS 10
-
-//----------// Uniform Blocks //----------//
-
-
-struct UMaterial
-{
-  // Material Factors
-  GLuint UColor;
-  GLuint UAmbientFactor;
-  GLuint UDiffuseFactor;
-  GLuint USpecularFactor;
-  GLuint USpecularExponent;
-  GLuint UEnvironmentFactor;
-  GLuint URefractionIndex;
-  GLuint UChromaticAbberation;
-  GLuint UChromaticOffset;
-  GLuint UFresnelReflection;
-  GLuint UFresnelRatio;
-  // Texture Mapping Properties
-  GLuint UTextureMapping;
-  GLuint USpecularMapping;
-  GLuint UNormalMapping;
-  GLuint UEnvironmentMapping;
-  GLuint UMappingType;
-  // Samplers
-  GLuint UDiffuseMap;
-  GLuint USpecularMap;
-  GLuint UNormalMap;
-  GLuint UUp;
-  GLuint UDown;
-  GLuint ULeft;
-  GLuint URight;
-  GLuint UFront;
-  GLuint UBack;
-};
-
-
-struct ULight
-{
-  GLuint UType;
-  GLuint UPosition;
-  GLuint UDirection;
-  GLuint UInnerAngle;
-  GLuint UOuterAngle;
-  GLuint USpotExponent;
-  GLuint UAmbientColor;
-  GLuint UDiffuseColor;
-  GLuint USpecularColor;
-  GLuint UAttenuationC0;
-  GLuint UAttenuationC1;
-  GLuint UAttenuationC2;
-};
+// The most lights that can be active. Phong and Blinn shading find the
+// lights that affect each fragment through the light clusters.
+#define MAXLIGHTS 4096
+// Gouraud shading still passes its lights through a uniform array
+#define MAXUNIFORMLIGHTS 10
+
+// The material features that can be compiled into a phong shader variant
+#define PHONG_TEXTURE_MAPPING      (1 << 0)
+#define PHONG_SPECULAR_MAPPING     (1 << 1)
+#define PHONG_NORMAL_MAPPING       (1 << 2)
+#define PHONG_ENVIRONMENT_MAPPING  (1 << 3)
+#define PHONG_ROUGH_REFLECTIONS    (1 << 4)
+#define PHONG_CHROMATIC_ABBERATION (1 << 5)
+#define PHONG_FRESNEL_REFLECTION   (1 << 6)
+// The mapping type is stored in the two bits above the features
+#define PHONG_MAPPING_SHIFT 7
+#define PHONG_MAPPING_MASK (3 << PHONG_MAPPING_SHIFT)
+// The maps are sampled through virtual textures
+#define PHONG_VIRTUAL_TEXTURING    (1 << 9)
+// The maps are sampled from a texture array
+#define PHONG_TEXTURE_ARRAY        (1 << 10)
 
 /*****************************************************************************/
 /*!
@@ -77,94 +45,70 @@ struct ULight
 /*****************************************************************************/
 class LineShader : public Shader
 {
-public:
-  virtual void EnableAttributes();
-  virtual void DisableAttributes();
 public:
   LineShader();
-  // Attributes
-  GLuint APosition;
-  // Uniforms
-  GLuint UProjection;
-  GLuint UView;
-  GLuint UModel;
-  GLuint ULineColor;
 };
 
-
-
 class SolidShader : public Shader
 {
-public:
-  virtual void EnableAttributes();
-  virtual void DisableAttributes();
 public:
   SolidShader();
-  // Attributes
-  GLuint APosition;
-  // Uniforms
-  GLuint UProjection;
-  GLuint UView;
-  GLuint UModel;
-  GLuint UColor;
 };
 
-class SkyboxShader : public Shader
+// Draws many single color meshes with one draw call. The model matrix and
+// color are per instance attributes rather than uniforms.
+class InstancedSolidShader : public Shader
 {
 public:
-  virtual void EnableAttributes();
-  virtual void DisableAttributes();
+  InstancedSolidShader();
+};
+
+class SkyboxShader : public Shader
+{
 public:
   SkyboxShader();
-  // Attributes
-  GLuint APosition;
-  // Uniforms
-  GLuint UProjection;
-  GLuint UView;
-  GLuint UUp;
-  GLuint UDown;
-  GLuint ULeft;
-  GLuint URight;
-  GLuint UFront;
-  GLuint UBack;
+};
+
+// Renders a single face and mip level of a prefiltered environment cubemap.
+// Each level is convolved with a GGX lobe of increasing roughness.
+class PrefilterShader : public Shader
+{
+public:
+  PrefilterShader();
+};
+
+// Renders a normal map from the heights in the red channel of a texture
+class NormalMapShader : public Shader
+{
+public:
+  NormalMapShader();
+};
+
+// Writes the texture coordinates and texel footprints seen by each pixel for
+// the virtual textures
+class FeedbackShader : public Shader
+{
+public:
+  FeedbackShader();
 };
 
 /*****************************************************************************/
 /*!
 \class PhongShader
 \brief
-  Used for drawing objects that undergo phong shading. Supports lighting
-  with up to 10 lights.
+  Used for drawing objects that undergo phong shading. Lights are found
+  through the light clusters. The default shader branches on the material
+  uniforms for every fragment. A variant has its material features compiled
+  in as defines, so it only contains the code those features need.
 */
 /*****************************************************************************/
 class PhongShader : public Shader
 {
 public:
   PhongShader();
-  virtual void EnableAttributes();
-  virtual void DisableAttributes();
-  // Attributes
-  GLuint APosition;
-  GLuint ANormal;
-  GLuint ATangent;
-  GLuint ABitangent;
-  GLuint AUV;
-  // Uniforms
-  GLuint UProjection;
-  GLuint UView;
-  GLuint UModel;
-  GLuint UCameraPosition;
-  GLuint UEmissiveColor;
-  GLuint UGlobalAmbientColor;
-  // Material Uniform
-  UMaterial UMaterial;
-  // Light Uniforms
-  GLuint UActiveLights;
-  ULight ULights[MAXLIGHTS];
-  // Fog Uniforms
-  GLuint UFogColor;
-  GLuint UNearPlane;
-  GLuint UFarPlane;
+  PhongShader(unsigned int features);
+private:
+  static std::string VariantDefines(unsigned int features);
 };
 
 /*****************************************************************************/
@@ -172,72 +116,29 @@ public:
 \class GouraudShader
 \brief
   Used for drawing objects that undergo gouraud shading. Can be used for
-  shading with up to 10 lights.
+  shading with up to MAXUNIFORMLIGHTS lights.
 */
 /*****************************************************************************/
 class GouraudShader : public Shader
 {
 public:
   GouraudShader();
-  virtual void EnableAttributes();
-  virtual void DisableAttributes();
-  // Attributes
-  GLuint APosition;
-  GLuint ANormal;
-  // Uniforms
-  GLuint UProjection;
-  GLuint UView;
-  GLuint UModel;
-  GLuint UCameraPosition;
-  GLuint UEmissiveColor;
-  GLuint UGlobalAmbientColor;
-  // Material Uniform
-  UMaterial UMaterial;
-  // Light Uniforms
-  GLuint UActiveLights;
-  ULight ULights[MAXLIGHTS];
-  // Fog Uniforms
-  GLuint UFogColor;
-  GLuint UNearPlane;
-  GLuint UFarPlane;
 };
 
 /*****************************************************************************/
 /*!
-\class PhongShader
+\class BlinnShader
 \brief
-Used for drawing objects that undergo phong shading. Supports lighting
-with up to 10 lights.
+Used for drawing objects that undergo blinn shading. Lights are found
+through the light clusters.
 */
 /*****************************************************************************/
 class BlinnShader : public Shader
 {
 public:
   BlinnShader();
-  virtual void EnableAttributes();
-  virtual void DisableAttributes();
-  // Attributes
-  GLuint APosition;
-  GLuint ANormal;
-  // Uniforms
-  GLuint UProjection;
-  GLuint UView;
-  GLuint UModel;
-  GLuint UCameraPosition;
-  GLuint UEmissiveColor;
-  GLuint UGlobalAmbientColor;
-  // Material Uniform
-  UMaterial UMaterial;
-  // Light Uniforms
-  GLuint UActiveLights;
-  ULight ULights[MAXLIGHTS];
-  // Fog Uniforms
-  GLuint UFogColor;
-  GLuint UNearPlane;
-  GLuint UFarPlane;
 };
 
-
 /*****************************************************************************/
 /*!
 \class TextureShader
@@ -249,12 +150,4 @@ class TextureShader : public Shader
 {
 public:
   TextureShader();
-  // Attributes
-  GLuint APosition;
-  GLuint ATexCoord;
-  // Uniforms
-  GLuint UProjection;
-  GLuint UView;
-  GLuint UModel;
-  GLuint UTexture;
 };
@@ -1,13 +1,25 @@
 #include "ShaderManager.h"
 
 SkyboxShader * ShaderManager::_skybox = nullptr;
+PrefilterShader * ShaderManager::_prefilter = nullptr;
+NormalMapShader * ShaderManager::_normalMap = nullptr;
+FeedbackShader * ShaderManager::_feedback = nullptr;
 
 void ShaderManager::Initialize()
 {
   _skybox = new SkyboxShader();
+  _prefilter = new PrefilterShader();
+  _normalMap = new NormalMapShader();
+  _feedback = new FeedbackShader();
 }
 void ShaderManager::Purge()
 {
   _skybox->Purge();
   delete _skybox;
+  _prefilter->Purge();
+  delete _prefilter;
+  _normalMap->Purge();
+  delete _normalMap;
+  _feedback->Purge();
+  delete _feedback;
 }
\ No newline at end of file
@@ -13,6 +13,9 @@ public:
   static void Purge();
 public:
   static SkyboxShader * _skybox;
+  static PrefilterShader * _prefilter;
+  static NormalMapShader * _normalMap;
+  static FeedbackShader * _feedback;
 private:
   ShaderManager();
 };
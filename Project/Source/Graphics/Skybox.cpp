@@ -1,6 +1,9 @@
 
+#include "../Utility/Error.h"
 #include "Shader/ShaderManager.h"
+#include "Texture/Texture.h"
 #include "Mesh/Mesh.h"
+#include "VertexFormat.h"
 
 #include "Skybox.h"
 
@@ -8,8 +11,8 @@ Skybox::Skybox(const std::string & directory,
   const std::string & up, const std::string & down,
   const std::string & left, const std::string & right,
   const std::string & front, const std::string & back) :
-  _directory(directory), _fUp(up), _fDown(down), _fLeft(left), _fRight(right),
-  _fFront(front), _fBack(back)
+  _texture(nullptr), _directory(directory), _fUp(up), _fDown(down),
+  _fLeft(left), _fRight(right), _fFront(front), _fBack(back)
 {
   // uploading skybox mesh (sm)
   Mesh sm("Resource/Model/skybox.obj", Mesh::OBJ);
@@ -17,7 +20,7 @@ Skybox::Skybox(const std::string & directory,
   glBindVertexArray(_sky._vao);
   _sky._vbo = UploadArrayBuffer(sm.VertexData(), sm.VertexDataSizeBytes());
   _sky._ebo = UploadIndexBuffer(sm.IndexData(), sm.IndexDataSizeBytes());
-  ShaderManager::_skybox->EnableAttributes();
+  VertexFormat::_mesh.Enable();
   glBindVertexArray(0);
   _sky._numElements = sm.IndexDataSize();
 }
@@ -27,28 +30,60 @@ Skybox::~Skybox()
   _sky.Purge();
 }
 
-bool Skybox::Upload()
+/*****************************************************************************/
+/*!
+\brief
+  Creates the skybox cubemap from the six face files.
+
+\param request
+  When true, the faces are decoded on the ThreadPool and the cubemap shows a
+  placeholder until TexturePool::UpdateUploads uploads them. Otherwise the
+  faces are decoded and uploaded before this returns.
+
+\return True if the cubemap was created.
+*/
+/*****************************************************************************/
+bool Skybox::Upload(bool request)
 {
-  _tUp = TexturePool::Upload(_directory + _fUp);
-  _tDown = TexturePool::Upload(_directory + _fDown);
-  _tLeft = TexturePool::Upload(_directory + _fLeft);
-  _tRight = TexturePool::Upload(_directory + _fRight);
-  _tFront = TexturePool::Upload(_directory + _fFront);
-  _tBack = TexturePool::Upload(_directory + _fBack);
-  if (_tUp && _tDown && _tLeft && _tRight && _tFront && _tBack)
+  if (request) {
+    std::string faces[6] = { _directory + _fRight, _directory + _fLeft,
+      _directory + _fUp, _directory + _fDown, _directory + _fBack,
+      _directory + _fFront };
+    // The up and down textures are rotated relative to how a cubemap
+    // expects them to be oriented.
+    int rotations[6] = { 0, 0, -1, 1, 0, 0 };
+    _texture = TexturePool::RequestCubemap(faces, rotations);
+    return true;
+  }
+  try {
+    Texture up(_directory + _fUp);
+    Texture down(_directory + _fDown);
+    Texture left(_directory + _fLeft);
+    Texture right(_directory + _fRight);
+    Texture front(_directory + _fFront);
+    Texture back(_directory + _fBack);
+    // The up and down textures are rotated relative to how a cubemap
+    // expects them to be oriented.
+    up.Rotate(false);
+    down.Rotate(true);
+    const Texture * faces[6] = { &right, &left, &up, &down, &back, &front };
+    _texture = TexturePool::UploadCubemap(faces);
+  }
+  catch (const Error & error) {
+    ErrorLog::Write(error);
+    return false;
+  }
+  if (_texture)
     return true;
   return false;
 }
 
 void Skybox::Unload()
 {
-  // TODO: make sure the skybox was successfully loaded first
-  TexturePool::Unload(_tUp);
-  TexturePool::Unload(_tDown);
-  TexturePool::Unload(_tLeft);
-  TexturePool::Unload(_tRight);
-  TexturePool::Unload(_tFront);
-  TexturePool::Unload(_tBack);
+  if (!_texture)
+    return;
+  TexturePool::Unload(_texture);
+  _texture = nullptr;
 }
 
 // use the linear part of your view matrix
@@ -56,24 +91,16 @@ void Skybox::Render(const Math::Matrix4 & projection,
   const Math::Matrix4 & view)
 {
   SkyboxShader * shader = ShaderManager::_skybox;
+  if (!shader->Ready())
+    return;
   ShaderManager::_skybox->Use();
   // transformation uniforms
-  glUniformMatrix4fv(shader->UProjection, 1, GL_TRUE, projection.array);
-  glUniformMatrix4fv(shader->UView, 1, GL_TRUE, view.array);
-  // sampler uniforms
-  glUniform1i(shader->UUp, 0);
-  glUniform1i(shader->UDown, 1);
-  glUniform1i(shader->ULeft, 2);
-  glUniform1i(shader->URight, 3);
-  glUniform1i(shader->UFront, 4);
-  glUniform1i(shader->UBack, 5);
-  // binding textures
-  TexturePool::Bind(_tUp, 0);
-  TexturePool::Bind(_tDown, 1);
-  TexturePool::Bind(_tLeft, 2);
-  TexturePool::Bind(_tRight, 3);
-  TexturePool::Bind(_tFront, 4);
-  TexturePool::Bind(_tBack, 5);
+  shader->SetUniformMatrix4("UProjection", projection);
+  shader->SetUniformMatrix4("UView", view);
+  // sampler uniform
+  shader->SetUniform1i("USkybox", 0);
+  // binding texture
+  TexturePool::Bind(_texture, 0);
   // drawing
   glDepthMask(GL_FALSE);
   glBindVertexArray(_sky._vao);
@@ -81,11 +108,6 @@ void Skybox::Render(const Math::Matrix4 & projection,
   glDrawElements(GL_TRIANGLES, _sky._numElements, GL_UNSIGNED_INT, nullptr);
   glBindVertexArray(0);
   glDepthMask(GL_TRUE);
-  // unbind textures
-  TexturePool::Unbind(_tUp);
-  TexturePool::Unbind(_tDown);
-  TexturePool::Unbind(_tLeft);
-  TexturePool::Unbind(_tRight);
-  TexturePool::Unbind(_tFront);
-  TexturePool::Unbind(_tBack);
+  // unbind texture
+  TexturePool::Unbind(_texture);
 }
\ No newline at end of file
@@ -18,16 +18,11 @@ public:
     const std::string & front, const std::string & back);
   ~Skybox();
 
-  bool Upload();
+  bool Upload(bool request = true);
   void Unload();
   void Render(const Math::Matrix4 & projection, const Math::Matrix4 & view);
-  // The texture objects used for rendering
-  TextureObject * _tUp;
-  TextureObject * _tDown;
-  TextureObject * _tLeft;
-  TextureObject * _tRight;
-  TextureObject * _tFront;
-  TextureObject * _tBack;
+  // The cubemap containing all six skybox textures
+  TextureObject * _texture;
   // The filenames for the skybox textures
   std::string _directory;
   std::string _fUp;
@@ -0,0 +1,67 @@
+/* All content(c) 2017 - 2018 DigiPen(USA) Corporation, all rights reserved. */
+#include "AtlasPacker.h"
+
+AtlasPacker::AtlasPacker(int width, int height, int alignment) :
+  _width(width), _height(height), _alignment(alignment), _top(0),
+  _usedArea(0)
+{}
+
+/*****************************************************************************/
+/*!
+\brief
+  Finds a place for a rectangle.
+
+\param width
+  The width of the rectangle.
+\param height
+  The height of the rectangle.
+\param x
+  The left edge of the place is written here.
+\param y
+  The bottom edge of the place is written here.
+
+\return False when the rectangle does not fit anywhere.
+*/
+/*****************************************************************************/
+bool AtlasPacker::Insert(int width, int height, int * x, int * y)
+{
+  int aligned_width = Align(width);
+  int aligned_height = Align(height);
+  if (aligned_width > _width)
+    return false;
+  Shelf * best = nullptr;
+  for (Shelf & shelf : _shelves) {
+    if (shelf._height < aligned_height ||
+      shelf._used + aligned_width > _width)
+      continue;
+    if (!best || shelf._height < best->_height)
+      best = &shelf;
+  }
+  if (!best) {
+    if (_top + aligned_height > _height)
+      return false;
+    Shelf shelf;
+    shelf._y = _top;
+    shelf._height = aligned_height;
+    shelf._used = 0;
+    _shelves.push_back(shelf);
+    _top += aligned_height;
+    best = &_shelves.back();
+  }
+  *x = best->_used;
+  *y = best->_y;
+  best->_used += aligned_width;
+  _usedArea += (long long)width * height;
+  return true;
+}
+
+// The fraction of the area that is taken by rectangles
+float AtlasPacker::Coverage() const
+{
+  return (float)_usedArea / ((float)_width * (float)_height);
+}
+
+int AtlasPacker::Align(int value) const
+{
+  return (value + _alignment - 1) / _alignment * _alignment;
+}
@@ -0,0 +1,48 @@
+/* All content(c) 2017 - 2018 DigiPen(USA) Corporation, all rights reserved. */
+#ifndef ATLASPACKER_H
+#define ATLASPACKER_H
+
+#include <vector>
+
+/*****************************************************************************/
+/*!
+\class AtlasPacker
+\brief
+  Finds places for rectangles of any size inside a larger rectangle. The
+  rectangles are placed on shelves. A rectangle goes on the shelf that wastes
+  the least height, and a new shelf is started above the others when none of
+  them have room.
+
+\par Important Notes
+  - Rectangles pack tightest when they are inserted from tallest to shortest.
+  - Sizes and positions are rounded up to the alignment so the rectangles
+    stay on texel boundaries in smaller mip levels.
+*/
+/*****************************************************************************/
+class AtlasPacker
+{
+public:
+  AtlasPacker(int width, int height, int alignment = 1);
+  bool Insert(int width, int height, int * x, int * y);
+  float Coverage() const;
+private:
+  struct Shelf
+  {
+    int _y;
+    int _height;
+    // The width already taken by rectangles on the shelf
+    int _used;
+  };
+  int Align(int value) const;
+  //! The size of the rectangle everything is packed into
+  int _width;
+  int _height;
+  int _alignment;
+  //! The bottom of the next shelf
+  int _top;
+  //! The area taken by the rectangles before they were aligned
+  long long _usedArea;
+  std::vector<Shelf> _shelves;
+};
+
+#endif // !ATLASPACKER_H
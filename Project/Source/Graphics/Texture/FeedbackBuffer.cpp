@@ -0,0 +1,131 @@
+/* All content(c) 2017 - 2018 DigiPen(USA) Corporation, all rights reserved. */
+#include <chrono>
+#include <cmath>
+#include <cstring>
+
+#include "../../Utility/OpenGLError.h"
+#include "../OpenGLContext.h"
+#include "FeedbackBuffer.h"
+
+FeedbackBuffer::FeedbackBuffer() : _width(0), _height(0),
+  _readMilliseconds(0.0f), _next(0)
+{
+  for (int i = 0; i < FEEDBACK_READBACKS; ++i) {
+    _pixelBuffers[i] = 0;
+    _fences[i] = nullptr;
+  }
+}
+
+/*****************************************************************************/
+/*!
+\brief
+  Creates the pixel buffers used for reading the render target back.
+
+\param width
+  The width of the feedback.
+\param height
+  The height of the feedback.
+*/
+/*****************************************************************************/
+void FeedbackBuffer::Initialize(unsigned int width, unsigned int height)
+{
+  _width = width;
+  _height = height;
+  glGenBuffers(FEEDBACK_READBACKS, _pixelBuffers);
+  for (int i = 0; i < FEEDBACK_READBACKS; ++i) {
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, _pixelBuffers[i]);
+    glBufferData(GL_PIXEL_PACK_BUFFER,
+      width * height * 4 * sizeof(unsigned short), NULL, GL_STREAM_READ);
+  }
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+  try {
+    GLenum gl_error = glGetError();
+    OPENGLERRORCHECK("FeedbackBuffer.cpp", "Initialize", "During feedback buffer creation", gl_error);
+  }
+  catch (const Error & error) {
+    ErrorLog::Write(error);
+  }
+}
+
+void FeedbackBuffer::Purge()
+{
+  for (int i = 0; i < FEEDBACK_READBACKS; ++i) {
+    if (_fences[i])
+      glDeleteSync(_fences[i]);
+    _fences[i] = nullptr;
+  }
+  glDeleteBuffers(FEEDBACK_READBACKS, _pixelBuffers);
+}
+
+// Binds a cleared GL_RGBA16 target of the feedback's size so meshes can be
+// drawn into it
+void FeedbackBuffer::Begin(Framebuffer * target)
+{
+  target->Bind();
+}
+
+// Starts copying the target into the next pixel buffer and binds the default
+// framebuffer again
+void FeedbackBuffer::End(Framebuffer * target)
+{
+  target->Bind();
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, _pixelBuffers[_next]);
+  glReadPixels(0, 0, _width, _height, GL_RGBA, GL_UNSIGNED_SHORT, 0);
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+  // a readback that was never read is replaced
+  if (_fences[_next])
+    glDeleteSync(_fences[_next]);
+  _fences[_next] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+  _next = (_next + 1) % FEEDBACK_READBACKS;
+  Framebuffer::BindDefault();
+}
+
+/*****************************************************************************/
+/*!
+\brief
+  Copies out the oldest readback whose copy has finished. This never waits
+  for the gpu.
+
+\param feedback
+  The RGBA values of every feedback pixel are written here.
+
+\return True when a readback was copied.
+*/
+/*****************************************************************************/
+bool FeedbackBuffer::Read(std::vector<unsigned short> * feedback)
+{
+  for (int i = 0; i < FEEDBACK_READBACKS; ++i) {
+    int index = (_next + i) % FEEDBACK_READBACKS;
+    if (!_fences[index])
+      continue;
+    GLenum status = glClientWaitSync(_fences[index], 0, 0);
+    if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+      continue;
+    std::chrono::high_resolution_clock::time_point start =
+      std::chrono::high_resolution_clock::now();
+    glDeleteSync(_fences[index]);
+    _fences[index] = nullptr;
+    unsigned int values = _width * _height * 4;
+    feedback->resize(values);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, _pixelBuffers[index]);
+    void * data = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0,
+      values * sizeof(unsigned short), GL_MAP_READ_BIT);
+    if (data) {
+      std::memcpy(feedback->data(), data, values * sizeof(unsigned short));
+      glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    std::chrono::duration<float, std::milli> time =
+      std::chrono::high_resolution_clock::now() - start;
+    _readMilliseconds = time.count();
+    return data != nullptr;
+  }
+  return false;
+}
+
+// log2 of the screen pixels along a side of a feedback pixel. The feedback
+// shader subtracts this from its footprints so they match the screen.
+float FeedbackBuffer::Scale() const
+{
+  return std::log2((float)OpenGLContext::Width() / (float)_width);
+}
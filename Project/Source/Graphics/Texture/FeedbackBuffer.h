@@ -0,0 +1,55 @@
+/* All content(c) 2017 - 2018 DigiPen(USA) Corporation, all rights reserved. */
+#ifndef FEEDBACKBUFFER_H
+#define FEEDBACKBUFFER_H
+
+#include <vector>
+#include <GL/glew.h>
+#include "../Framebuffer.h"
+
+// The number of readbacks that can be in flight. A readback is read a few
+// frames after it was made so the cpu never waits on the gpu.
+#define FEEDBACK_READBACKS 3
+// The feedback is this many times smaller than the screen on each side
+#define FEEDBACK_DIVISOR 8
+// The log2 texel footprints in the feedback cover -FEEDBACK_LOD_RANGE to 0.
+// feedback.frag uses the same value.
+#define FEEDBACK_LOD_RANGE 32.0f
+
+/*****************************************************************************/
+/*!
+\class FeedbackBuffer
+\brief
+  A small render target that meshes using virtual textures are drawn into
+  with the feedback shader. Every pixel stores the texture coordinates that
+  were seen and how large a texel footprint they had. The pixels are copied
+  into pixel buffers and read back once their fences have signaled.
+
+\par Important Notes
+  - A pixel that was not drawn has an alpha of zero.
+  - Read returns the oldest finished readback, which is a few frames old.
+  - The render target is given to Begin and End by the caller, which also
+    clears it to zero. It only needs to live until End has queued the copy.
+*/
+/*****************************************************************************/
+class FeedbackBuffer
+{
+public:
+  FeedbackBuffer();
+  void Initialize(unsigned int width, unsigned int height);
+  void Purge();
+  void Begin(Framebuffer * target);
+  void End(Framebuffer * target);
+  bool Read(std::vector<unsigned short> * feedback);
+  float Scale() const;
+  unsigned int _width;
+  unsigned int _height;
+  // The time spent copying the latest readback out of its pixel buffer
+  float _readMilliseconds;
+private:
+  GLuint _pixelBuffers[FEEDBACK_READBACKS];
+  GLsync _fences[FEEDBACK_READBACKS];
+  //! The pixel buffer that the next readback is copied into
+  int _next;
+};
+
+#endif // !FEEDBACKBUFFER_H
@@ -0,0 +1,545 @@
+/* All content(c) 2017 - 2018 DigiPen(USA) Corporation, all rights reserved. */
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <emmintrin.h>
+#include <fstream>
+
+#include <STB\stb_image.h>
+#include "../../Core/ThreadPool.h"
+#include "ImageDecoder.h"
+
+#define TGA_HEADER_BYTES 18
+#define PNG_SIGNATURE_BYTES 8
+
+// static initializations
+int ImageDecoder::_decodedImages = 0;
+int ImageDecoder::_fallbacks = 0;
+int ImageDecoder::_mismatches = 0;
+std::mutex ImageDecoder::_statsMutex;
+
+// Gives out buffers with malloc, which is also what stb uses
+class MallocAllocator : public ImageDecoder::Allocator
+{
+public:
+  unsigned char * Allocate(std::size_t bytes)
+  {
+    return (unsigned char *)std::malloc(bytes);
+  }
+  void Free(unsigned char * buffer, std::size_t)
+  {
+    std::free(buffer);
+  }
+};
+static MallocAllocator malloc_allocator;
+
+// The file and inflate buffers of each thread. They grow to the largest
+// image the thread has seen and are reused for every image after that.
+static thread_local std::vector<unsigned char> file_buffer;
+static thread_local std::vector<unsigned char> compressed_buffer;
+static thread_local std::vector<unsigned char> inflated_buffer;
+
+static unsigned int ReadBig32(const unsigned char * bytes)
+{
+  return (unsigned int)bytes[0] << 24 | (unsigned int)bytes[1] << 16 |
+    (unsigned int)bytes[2] << 8 | (unsigned int)bytes[3];
+}
+
+static bool ReadFile(const std::string & file,
+  std::vector<unsigned char> * contents)
+{
+  std::ifstream stream(file.c_str(), std::ios::binary);
+  if (!stream.is_open())
+    return false;
+  stream.seekg(0, std::ios::end);
+  std::streamoff size = stream.tellg();
+  stream.seekg(0, std::ios::beg);
+  contents->resize((std::size_t)size);
+  stream.read((char *)contents->data(), size);
+  return (bool)stream;
+}
+
+ImageDecoder::BufferPool::BufferPool(std::size_t max_bytes) :
+  _maxBytes(max_bytes), _reuses(0), _allocations(0), _freeBytes(0)
+{}
+
+ImageDecoder::BufferPool::~BufferPool()
+{
+  Clear();
+}
+
+unsigned char * ImageDecoder::BufferPool::Allocate(std::size_t bytes)
+{
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    std::unordered_map<std::size_t, std::vector<unsigned char *> >::iterator
+      it = _free.find(bytes);
+    if (it != _free.end() && !it->second.empty()) {
+      unsigned char * buffer = it->second.back();
+      it->second.pop_back();
+      _freeBytes -= bytes;
+      ++_reuses;
+      return buffer;
+    }
+    ++_allocations;
+  }
+  return (unsigned char *)std::malloc(bytes);
+}
+
+void ImageDecoder::BufferPool::Free(unsigned char * buffer, std::size_t bytes)
+{
+  if (!buffer)
+    return;
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_freeBytes + bytes <= _maxBytes) {
+      _free[bytes].push_back(buffer);
+      _freeBytes += bytes;
+      return;
+    }
+  }
+  std::free(buffer);
+}
+
+// Frees every buffer the pool is keeping
+void ImageDecoder::BufferPool::Clear()
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  for (std::pair<const std::size_t, std::vector<unsigned char *> > & sized :
+    _free) {
+    for (unsigned char * buffer : sized.second)
+      std::free(buffer);
+  }
+  _free.clear();
+  _freeBytes = 0;
+}
+
+/*****************************************************************************/
+/*!
+\brief
+  Decodes a TGA or PNG file.
+
+\param file
+  The image file.
+\param width
+  The width of the image is written here.
+\param height
+  The height of the image is written here.
+\param channels
+  The number of bytes per pixel is written here.
+\param allocator
+  Where the pixel buffer comes from.
+
+\return The pixels, starting with the top row, or null when the file could
+  not be read or is not something this decodes.
+*/
+/*****************************************************************************/
+unsigned char * ImageDecoder::Decode(const std::string & file, int * width,
+  int * height, int * channels, Allocator * allocator)
+{
+  unsigned char * pixels = nullptr;
+  if (ReadFile(file, &file_buffer)) {
+    std::size_t dot = file.find_last_of('.');
+    std::string extension = dot == std::string::npos ? "" :
+      file.substr(dot + 1);
+    if (extension == "tga" || extension == "TGA")
+      pixels = DecodeTGA(file_buffer, width, height, channels, allocator);
+    else if (extension == "png" || extension == "PNG")
+      pixels = DecodePNG(file_buffer, width, height, channels, allocator);
+  }
+  std::lock_guard<std::mutex> lock(_statsMutex);
+  if (pixels)
+    ++_decodedImages;
+  else
+    ++_fallbacks;
+  return pixels;
+}
+
+ImageDecoder::Allocator * ImageDecoder::DefaultAllocator()
+{
+  return &malloc_allocator;
+}
+
+/*****************************************************************************/
+/*!
+\brief
+  Copies pixels while swapping their first and third bytes, which turns BGR
+  into RGB. Sixteen bytes are done at a time with SSE2. The source and the
+  destination can be the same buffer.
+
+\param source
+  The BGR or BGRA pixels.
+\param texels
+  The RGB or RGBA pixels are written here.
+\param pixels
+  The number of pixels.
+\param channels
+  The bytes per pixel. Pixels with fewer than three are only copied.
+*/
+/*****************************************************************************/
+void ImageDecoder::SwizzleBGR(const unsigned char * source,
+  unsigned char * texels, int pixels, int channels)
+{
+  int bytes = pixels * channels;
+  if (channels < 3) {
+    if (source != texels)
+      std::memmove(texels, source, bytes);
+    return;
+  }
+  int i = 0;
+  if (channels == 4) {
+    const __m128i keep = _mm_set1_epi32(0xff00ff00);
+    const __m128i swap = _mm_set1_epi32(0x00ff00ff);
+    for (; i + 16 <= bytes; i += 16) {
+      __m128i value = _mm_loadu_si128((const __m128i *)(source + i));
+      __m128i red_blue = _mm_and_si128(value, swap);
+      red_blue = _mm_or_si128(_mm_srli_epi32(red_blue, 16),
+        _mm_slli_epi32(red_blue, 16));
+      value = _mm_or_si128(_mm_and_si128(value, keep), red_blue);
+      _mm_storeu_si128((__m128i *)(texels + i), value);
+    }
+  }
+  else {
+    // Five pixels fit in 15 bytes. The sixteenth byte is kept as it is so
+    // it can still be read when the source is the destination.
+    const __m128i from_right = _mm_setr_epi8(-1, 0, 0, -1, 0, 0, -1, 0, 0,
+      -1, 0, 0, -1, 0, 0, 0);
+    const __m128i keep = _mm_setr_epi8(0, -1, 0, 0, -1, 0, 0, -1, 0, 0, -1,
+      0, 0, -1, 0, -1);
+    const __m128i from_left = _mm_setr_epi8(0, 0, -1, 0, 0, -1, 0, 0, -1, 0,
+      0, -1, 0, 0, -1, 0);
+    for (; i + 16 <= bytes; i += 15) {
+      __m128i value = _mm_loadu_si128((const __m128i *)(source + i));
+      __m128i swapped = _mm_or_si128(
+        _mm_and_si128(_mm_srli_si128(value, 2), from_right),
+        _mm_and_si128(_mm_slli_si128(value, 2), from_left));
+      value = _mm_or_si128(_mm_and_si128(value, keep), swapped);
+      _mm_storeu_si128((__m128i *)(texels + i), value);
+    }
+  }
+  for (; i < bytes; i += channels) {
+    unsigned char blue = source[i];
+    texels[i] = source[i + 2];
+    texels[i + 1] = source[i + 1];
+    texels[i + 2] = blue;
+    if (channels == 4)
+      texels[i + 3] = source[i + 3];
+  }
+}
+
+/*****************************************************************************/
+/*!
+\brief
+  Times decoding files with stb and with the ImageDecoder. Both decode every
+  file one after another on the calling thread, and the decoder reuses its
+  buffers through a BufferPool. Images that do not match are counted in
+  _mismatches.
+
+\param files
+  The image files.
+\param stb_milliseconds
+  The time stb took is written here.
+\param decoder_milliseconds
+  The time the ImageDecoder took is written here.
+*/
+/*****************************************************************************/
+void ImageDecoder::Benchmark(const std::vector<std::string> & files,
+  float * stb_milliseconds, float * decoder_milliseconds)
+{
+  std::vector<unsigned char *> expected(files.size());
+  std::vector<std::size_t> expected_bytes(files.size(), 0);
+  std::chrono::high_resolution_clock::time_point start =
+    std::chrono::high_resolution_clock::now();
+  for (unsigned int i = 0; i < files.size(); ++i) {
+    int width, height, channels;
+    expected[i] = stbi_load(files[i].c_str(), &width, &height, &channels, 0);
+    if (expected[i])
+      expected_bytes[i] = (std::size_t)width * height * channels;
+  }
+  std::chrono::duration<float, std::milli> stb_time =
+    std::chrono::high_resolution_clock::now() - start;
+  *stb_milliseconds = stb_time.count();
+  BufferPool pool;
+  int mismatches = 0;
+  start = std::chrono::high_resolution_clock::now();
+  for (unsigned int i = 0; i < files.size(); ++i) {
+    int width, height, channels;
+    unsigned char * pixels = Decode(files[i], &width, &height, &channels,
+      &pool);
+    if (!pixels) {
+      // files this does not handle are only a mismatch if stb read them
+      mismatches += expected[i] ? 1 : 0;
+      continue;
+    }
+    std::size_t bytes = (std::size_t)width * height * channels;
+    if (bytes != expected_bytes[i] ||
+      std::memcmp(pixels, expected[i], bytes) != 0)
+      ++mismatches;
+    pool.Free(pixels, bytes);
+  }
+  std::chrono::duration<float, std::milli> decoder_time =
+    std::chrono::high_resolution_clock::now() - start;
+  *decoder_milliseconds = decoder_time.count();
+  for (unsigned char * pixels : expected)
+    stbi_image_free(pixels);
+  _mismatches = mismatches;
+}
+
+// Decodes truecolor and grayscale TGA files, with or without RLE
+unsigned char * ImageDecoder::DecodeTGA(
+  const std::vector<unsigned char> & file, int * width, int * height,
+  int * channels, Allocator * allocator)
+{
+  if (file.size() < TGA_HEADER_BYTES)
+    return nullptr;
+  const unsigned char * header = file.data();
+  int id_length = header[0];
+  int color_map_type = header[1];
+  int image_type = header[2];
+  int image_width = header[12] | header[13] << 8;
+  int image_height = header[14] | header[15] << 8;
+  int bits = header[16];
+  // the first row in the file is the bottom row unless bit 5 is set
+  bool bottom_up = (header[17] & 0x20) == 0;
+  bool rle = image_type >= 8;
+  if (rle)
+    image_type -= 8;
+  if (color_map_type != 0 || (image_type != 2 && image_type != 3))
+    return nullptr;
+  int pixel_bytes;
+  switch (bits)
+  {
+  case 8: pixel_bytes = 1; break;
+  case 24: pixel_bytes = 3; break;
+  case 32: pixel_bytes = 4; break;
+  default: return nullptr;
+  }
+  if (image_width <= 0 || image_height <= 0)
+    return nullptr;
+  std::size_t offset = TGA_HEADER_BYTES + id_length;
+  int row_bytes = image_width * pixel_bytes;
+  std::size_t image_bytes = (std::size_t)row_bytes * image_height;
+  if (!rle && file.size() < offset + image_bytes)
+    return nullptr;
+  unsigned char * pixels = allocator->Allocate(image_bytes);
+  if (!pixels)
+    return nullptr;
+  if (!rle) {
+    // every row is swizzled straight into its final place
+    for (int y = 0; y < image_height; ++y) {
+      int row = bottom_up ? image_height - 1 - y : y;
+      SwizzleBGR(file.data() + offset + (std::size_t)y * row_bytes,
+        pixels + (std::size_t)row * row_bytes, image_width, pixel_bytes);
+    }
+  }
+  else {
+    // packets can cross rows, so they are expanded in file order first
+    const unsigned char * read = file.data() + offset;
+    const unsigned char * end = file.data() + file.size();
+    unsigned char * write = pixels;
+    unsigned char * write_end = pixels + image_bytes;
+    while (write < write_end) {
+      if (read >= end) {
+        allocator->Free(pixels, image_bytes);
+        return nullptr;
+      }
+      int command = *read++;
+      std::size_t count = (std::size_t)(command & 127) + 1;
+      std::size_t packet_bytes = count * pixel_bytes;
+      if (packet_bytes > (std::size_t)(write_end - write))
+        packet_bytes = write_end - write;
+      if (command & 128) {
+        if (end - read < pixel_bytes) {
+          allocator->Free(pixels, image_bytes);
+          return nullptr;
+        }
+        for (std::size_t i = 0; i < packet_bytes; i += pixel_bytes)
+          std::memcpy(write + i, read, pixel_bytes);
+        read += pixel_bytes;
+      }
+      else {
+        if ((std::size_t)(end - read) < packet_bytes) {
+          allocator->Free(pixels, image_bytes);
+          return nullptr;
+        }
+        std::memcpy(write, read, packet_bytes);
+        read += packet_bytes;
+      }
+      write += packet_bytes;
+    }
+    if (bottom_up) {
+      for (int top = 0, bottom = image_height - 1; top < bottom;
+        ++top, --bottom) {
+        unsigned char * top_row = pixels + (std::size_t)top * row_bytes;
+        std::swap_ranges(top_row, top_row + row_bytes,
+          pixels + (std::size_t)bottom * row_bytes);
+      }
+    }
+    SwizzleBGR(pixels, pixels, image_width * image_height, pixel_bytes);
+  }
+  *width = image_width;
+  *height = image_height;
+  *channels = pixel_bytes;
+  return pixels;
+}
+
+static unsigned char Paeth(int a, int b, int c)
+{
+  int p = a + b - c;
+  int pa = std::abs(p - a);
+  int pb = std::abs(p - b);
+  int pc = std::abs(p - c);
+  if (pa <= pb && pa <= pc)
+    return (unsigned char)a;
+  if (pb <= pc)
+    return (unsigned char)b;
+  return (unsigned char)c;
+}
+
+// Reverses the filter of one row. The row above is zero for the first row.
+static void UnfilterRow(int filter, const unsigned char * filtered,
+  const unsigned char * above, unsigned char * row, int row_bytes,
+  int pixel_bytes)
+{
+  int i = 0;
+  switch (filter)
+  {
+  case 0:
+    std::memcpy(row, filtered, row_bytes);
+    break;
+  case 1:
+    for (; i < pixel_bytes; ++i)
+      row[i] = filtered[i];
+    for (; i < row_bytes; ++i)
+      row[i] = (unsigned char)(filtered[i] + row[i - pixel_bytes]);
+    break;
+  case 2:
+    for (; i + 16 <= row_bytes; i += 16) {
+      __m128i sum = _mm_add_epi8(
+        _mm_loadu_si128((const __m128i *)(filtered + i)),
+        _mm_loadu_si128((const __m128i *)(above + i)));
+      _mm_storeu_si128((__m128i *)(row + i), sum);
+    }
+    for (; i < row_bytes; ++i)
+      row[i] = (unsigned char)(filtered[i] + above[i]);
+    break;
+  case 3:
+    for (; i < pixel_bytes; ++i)
+      row[i] = (unsigned char)(filtered[i] + (above[i] >> 1));
+    for (; i < row_bytes; ++i) {
+      row[i] = (unsigned char)(filtered[i] +
+        ((row[i - pixel_bytes] + above[i]) >> 1));
+    }
+    break;
+  default:
+    for (; i < pixel_bytes; ++i)
+      row[i] = (unsigned char)(filtered[i] + above[i]);
+    for (; i < row_bytes; ++i) {
+      row[i] = (unsigned char)(filtered[i] + Paeth(row[i - pixel_bytes],
+        above[i], above[i - pixel_bytes]));
+    }
+    break;
+  }
+}
+
+// Decodes 8 bit, non interlaced, non paletted PNG files. A file with a tRNS
+// chunk is left to stb, which adds an alpha channel for it.
+unsigned char * ImageDecoder::DecodePNG(
+  const std::vector<unsigned char> & file, int * width, int * height,
+  int * channels, Allocator * allocator)
+{
+  static const unsigned char signature[PNG_SIGNATURE_BYTES] =
+    { 137, 80, 78, 71, 13, 10, 26, 10 };
+  if (file.size() < PNG_SIGNATURE_BYTES ||
+    std::memcmp(file.data(), signature, PNG_SIGNATURE_BYTES) != 0)
+    return nullptr;
+  int image_width = 0;
+  int image_height = 0;
+  int pixel_bytes = 0;
+  compressed_buffer.clear();
+  std::size_t position = PNG_SIGNATURE_BYTES;
+  bool ended = false;
+  while (!ended && position + 12 <= file.size()) {
+    const unsigned char * chunk = file.data() + position;
+    std::size_t length = ReadBig32(chunk);
+    if (length > file.size() - position - 12)
+      return nullptr;
+    const unsigned char * data = chunk + 8;
+    if (std::memcmp(chunk + 4, "IHDR", 4) == 0) {
+      if (length < 13)
+        return nullptr;
+      image_width = (int)ReadBig32(data);
+      image_height = (int)ReadBig32(data + 4);
+      int depth = data[8];
+      int color_type = data[9];
+      int interlace = data[12];
+      if (depth != 8 || interlace != 0)
+        return nullptr;
+      switch (color_type)
+      {
+      case 0: pixel_bytes = 1; break;
+      case 2: pixel_bytes = 3; break;
+      case 4: pixel_bytes = 2; break;
+      case 6: pixel_bytes = 4; break;
+      default: return nullptr;
+      }
+    }
+    else if (std::memcmp(chunk + 4, "IDAT", 4) == 0) {
+      compressed_buffer.insert(compressed_buffer.end(), data, data + length);
+    }
+    else if (std::memcmp(chunk + 4, "tRNS", 4) == 0 ||
+      std::memcmp(chunk + 4, "CgBI", 4) == 0) {
+      return nullptr;
+    }
+    else if (std::memcmp(chunk + 4, "IEND", 4) == 0) {
+      ended = true;
+    }
+    position += length + 12;
+  }
+  if (pixel_bytes == 0 || image_width <= 0 || image_height <= 0 ||
+    compressed_buffer.empty())
+    return nullptr;
+  // every row starts with its filter byte
+  int row_bytes = image_width * pixel_bytes;
+  std::size_t filtered_bytes = (std::size_t)(row_bytes + 1) * image_height;
+  inflated_buffer.resize(filtered_bytes);
+  int inflated = stbi_zlib_decode_buffer((char *)inflated_buffer.data(),
+    (int)filtered_bytes, (const char *)compressed_buffer.data(),
+    (int)compressed_buffer.size());
+  if (inflated != (int)filtered_bytes)
+    return nullptr;
+  // Rows with no filter or the sub filter do not depend on the row above,
+  // so each one starts a run that can be unfiltered on its own.
+  std::vector<int> runs;
+  for (int y = 0; y < image_height; ++y) {
+    int filter = inflated_buffer[(std::size_t)y * (row_bytes + 1)];
+    if (filter > 4)
+      return nullptr;
+    if (y == 0 || filter <= 1)
+      runs.push_back(y);
+  }
+  runs.push_back(image_height);
+  std::size_t image_bytes = (std::size_t)row_bytes * image_height;
+  unsigned char * pixels = allocator->Allocate(image_bytes);
+  if (!pixels)
+    return nullptr;
+  std::vector<unsigned char> zero_row(row_bytes, 0);
+  const unsigned char * inflated_data = inflated_buffer.data();
+  ThreadPool::ParallelFor((unsigned int)runs.size() - 1,
+    [&](unsigned int run)
+  {
+    for (int y = runs[run]; y < runs[run + 1]; ++y) {
+      const unsigned char * filtered =
+        inflated_data + (std::size_t)y * (row_bytes + 1);
+      unsigned char * row = pixels + (std::size_t)y * row_bytes;
+      const unsigned char * above = y == 0 ? zero_row.data() :
+        row - row_bytes;
+      UnfilterRow(filtered[0], filtered + 1, above, row, row_bytes,
+        pixel_bytes);
+    }
+  });
+  *width = image_width;
+  *height = image_height;
+  *channels = pixel_bytes;
+  return pixels;
+}
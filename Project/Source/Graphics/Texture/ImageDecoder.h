@@ -0,0 +1,83 @@
+/* All content(c) 2017 - 2018 DigiPen(USA) Corporation, all rights reserved. */
+#ifndef IMAGEDECODER_H
+#define IMAGEDECODER_H
+
+#include <cstddef>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// The most bytes of free buffers a BufferPool keeps by default
+#define IMAGEBUFFER_POOL_BYTES (64 * 1024 * 1024)
+
+/*****************************************************************************/
+/*!
+\class ImageDecoder
+\brief
+  Decodes TGA and PNG files without going through stb. Uncompressed and RLE
+  TGA files are read straight into their final rows and their BGR texels
+  are swizzled to RGB with SSE2. PNG files are inflated into a buffer of the
+  exact size the image needs, and the rows are unfiltered on the ThreadPool
+  in runs that do not depend on the rows above them.
+
+\par Important Notes
+  - Decode returns null for anything it does not handle, such as paletted,
+    16 bit, or interlaced images, so the caller can fall back to stb. The
+    images it does decode match what stbi_load returns byte for byte.
+  - Pixel buffers come from an Allocator given by the caller and must be
+    given back to the same Allocator.
+*/
+/*****************************************************************************/
+class ImageDecoder
+{
+public:
+  // Hands out the buffers images are decoded into
+  class Allocator
+  {
+  public:
+    virtual ~Allocator() {}
+    virtual unsigned char * Allocate(std::size_t bytes) = 0;
+    virtual void Free(unsigned char * buffer, std::size_t bytes) = 0;
+  };
+  // Keeps freed buffers so later images of the same size reuse them. Only
+  // _maxBytes of free buffers are kept. This is safe to use from any thread.
+  class BufferPool : public Allocator
+  {
+  public:
+    BufferPool(std::size_t max_bytes = IMAGEBUFFER_POOL_BYTES);
+    ~BufferPool();
+    unsigned char * Allocate(std::size_t bytes);
+    void Free(unsigned char * buffer, std::size_t bytes);
+    void Clear();
+    std::size_t _maxBytes;
+    // The allocations that reused a buffer and the ones that did not
+    int _reuses;
+    int _allocations;
+  private:
+    std::unordered_map<std::size_t, std::vector<unsigned char *> > _free;
+    std::size_t _freeBytes;
+    std::mutex _mutex;
+  };
+  static unsigned char * Decode(const std::string & file, int * width,
+    int * height, int * channels, Allocator * allocator);
+  static Allocator * DefaultAllocator();
+  static void SwizzleBGR(const unsigned char * source, unsigned char * texels,
+    int pixels, int channels);
+  static void Benchmark(const std::vector<std::string> & files,
+    float * stb_milliseconds, float * decoder_milliseconds);
+  // The images decoded here and the ones left for stb
+  static int _decodedImages;
+  static int _fallbacks;
+  // The images whose bytes did not match stb during the last benchmark
+  static int _mismatches;
+private:
+  static unsigned char * DecodeTGA(const std::vector<unsigned char> & file,
+    int * width, int * height, int * channels, Allocator * allocator);
+  static unsigned char * DecodePNG(const std::vector<unsigned char> & file,
+    int * width, int * height, int * channels, Allocator * allocator);
+  static std::mutex _statsMutex;
+  ImageDecoder();
+};
+
+#endif // !IMAGEDECODER_H
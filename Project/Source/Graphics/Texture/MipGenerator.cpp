@@ -0,0 +1,265 @@
+/* All content(c) 2017 - 2018 DigiPen(USA) Corporation, all rights reserved. */
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+#include "../../Core/ThreadPool.h"
+#include "MipGenerator.h"
+
+#define PI 3.141592653589f
+// The radius of the windowed sinc filters in destination texels and the
+// shape parameter of the Kaiser window
+#define FILTER_RADIUS 3.0f
+#define KAISER_ALPHA 4.0f
+// The number of entries in the table used for converting linear values to
+// sRGB bytes
+#define SRGB_TABLE_SIZE 4096
+
+// static initializations
+MipGenerator::Filter MipGenerator::_filter = MipGenerator::KAISER;
+float MipGenerator::_milliseconds = 0.0f;
+long long MipGenerator::_pixels = 0;
+std::mutex MipGenerator::_statsMutex;
+
+// The tables for converting between sRGB bytes and linear values
+struct SRGBTables
+{
+  SRGBTables()
+  {
+    for (int i = 0; i < 256; ++i) {
+      float value = (float)i / 255.0f;
+      if (value <= 0.04045f)
+        _toLinear[i] = value / 12.92f;
+      else
+        _toLinear[i] = std::pow((value + 0.055f) / 1.055f, 2.4f);
+    }
+    for (int i = 0; i < SRGB_TABLE_SIZE; ++i) {
+      float value = (float)i / (float)(SRGB_TABLE_SIZE - 1);
+      float srgb;
+      if (value <= 0.0031308f)
+        srgb = value * 12.92f;
+      else
+        srgb = 1.055f * std::pow(value, 1.0f / 2.4f) - 0.055f;
+      _toSRGB[i] = (unsigned char)(srgb * 255.0f + 0.5f);
+    }
+  }
+  float _toLinear[256];
+  unsigned char _toSRGB[SRGB_TABLE_SIZE];
+};
+static const SRGBTables srgb_tables;
+
+static float Sinc(float x)
+{
+  if (x == 0.0f)
+    return 1.0f;
+  x *= PI;
+  return std::sin(x) / x;
+}
+
+// The zeroth order modified Bessel function of the first kind
+static float BesselI0(float x)
+{
+  float sum = 1.0f;
+  float term = 1.0f;
+  float half_x2 = 0.25f * x * x;
+  for (int k = 1; k < 20; ++k) {
+    term *= half_x2 / (float)(k * k);
+    sum += term;
+  }
+  return sum;
+}
+
+// Evaluates a filter at a distance from its center in destination texels
+static float Kernel(MipGenerator::Filter filter, float x)
+{
+  x = std::fabs(x);
+  switch (filter)
+  {
+  case MipGenerator::BOX:
+    return x <= 0.5f ? 1.0f : 0.0f;
+  case MipGenerator::LANCZOS:
+    if (x >= FILTER_RADIUS)
+      return 0.0f;
+    return Sinc(x) * Sinc(x / FILTER_RADIUS);
+  default:
+    if (x >= FILTER_RADIUS)
+      return 0.0f;
+    float ratio = x / FILTER_RADIUS;
+    float window = BesselI0(KAISER_ALPHA * std::sqrt(1.0f - ratio * ratio)) /
+      BesselI0(KAISER_ALPHA);
+    return Sinc(x) * window;
+  }
+}
+
+// The source texels and weights that make up each destination texel along
+// one axis. Texels past the edges repeat the edge texel.
+struct Taps
+{
+  Taps(MipGenerator::Filter filter, int source_size, int size)
+  {
+    float scale = (float)source_size / (float)size;
+    float radius = filter == MipGenerator::BOX ? 0.5f : FILTER_RADIUS;
+    float support = radius * scale;
+    _first.resize(size + 1);
+    for (int i = 0; i < size; ++i) {
+      _first[i] = (int)_indices.size();
+      float center = ((float)i + 0.5f) * scale;
+      int low = (int)std::floor(center - support);
+      int high = (int)std::ceil(center + support);
+      float total = 0.0f;
+      for (int j = low; j <= high; ++j) {
+        float weight = Kernel(filter, ((float)j + 0.5f - center) / scale);
+        if (weight == 0.0f)
+          continue;
+        _indices.push_back(std::min(std::max(j, 0), source_size - 1));
+        _weights.push_back(weight);
+        total += weight;
+      }
+      for (unsigned int j = _first[i]; j < _weights.size(); ++j)
+        _weights[j] /= total;
+    }
+    _first[size] = (int)_indices.size();
+  }
+  std::vector<int> _first;
+  std::vector<int> _indices;
+  std::vector<float> _weights;
+};
+
+/*****************************************************************************/
+/*!
+\brief
+  Creates every mip level of an image down to 1x1.
+
+\param pixels
+  The image data.
+\param width
+  The width of the image.
+\param height
+  The height of the image.
+\param channels
+  The number of bytes per pixel. Normal maps need at least three.
+\param content
+  What the image contains, which decides how it is filtered.
+\param levels
+  Every level is written here, starting with a copy of the image.
+*/
+/*****************************************************************************/
+void MipGenerator::Generate(const unsigned char * pixels, int width,
+  int height, int channels, Content content,
+  std::vector<std::vector<unsigned char> > * levels)
+{
+  std::chrono::high_resolution_clock::time_point start =
+    std::chrono::high_resolution_clock::now();
+  int size = width * height * channels;
+  levels->clear();
+  levels->push_back(std::vector<unsigned char>(pixels, pixels + size));
+  // the filtered values are kept as floats so rounding errors do not build
+  // up over the levels
+  std::vector<float> level(size);
+  for (int i = 0; i < size; ++i) {
+    int channel = i % channels;
+    if (content == NORMAL_MAP)
+      level[i] = (float)pixels[i] / 255.0f * 2.0f - 1.0f;
+    else if (channel < 3)
+      level[i] = srgb_tables._toLinear[pixels[i]];
+    else
+      level[i] = (float)pixels[i] / 255.0f;
+  }
+  std::vector<float> next_level;
+  long long pixel_count = 0;
+  while (width > 1 || height > 1) {
+    int new_width = std::max(width / 2, 1);
+    int new_height = std::max(height / 2, 1);
+    Downsample(level, width, height, channels, new_width, new_height,
+      &next_level);
+    level.swap(next_level);
+    width = new_width;
+    height = new_height;
+    levels->push_back(std::vector<unsigned char>());
+    Encode(&level, channels, content, &levels->back());
+    pixel_count += width * height;
+  }
+  std::chrono::duration<float, std::milli> time =
+    std::chrono::high_resolution_clock::now() - start;
+  std::lock_guard<std::mutex> lock(_statsMutex);
+  _milliseconds += time.count();
+  _pixels += pixel_count;
+}
+
+// Filters the rows and then the columns of a level into the next level
+void MipGenerator::Downsample(const std::vector<float> & source, int width,
+  int height, int channels, int new_width, int new_height,
+  std::vector<float> * result)
+{
+  Taps horizontal(_filter, width, new_width);
+  Taps vertical(_filter, height, new_height);
+  std::vector<float> rows(new_width * height * channels);
+  float * rows_data = rows.data();
+  const float * source_data = source.data();
+  ThreadPool::ParallelFor(height, [&](unsigned int y)
+  {
+    const float * source_row = source_data + y * width * channels;
+    float * row = rows_data + y * new_width * channels;
+    for (int x = 0; x < new_width; ++x) {
+      float * texel = row + x * channels;
+      for (int c = 0; c < channels; ++c)
+        texel[c] = 0.0f;
+      for (int t = horizontal._first[x]; t < horizontal._first[x + 1]; ++t) {
+        const float * tap = source_row + horizontal._indices[t] * channels;
+        float weight = horizontal._weights[t];
+        for (int c = 0; c < channels; ++c)
+          texel[c] += tap[c] * weight;
+      }
+    }
+  });
+  result->assign(new_width * new_height * channels, 0.0f);
+  float * result_data = result->data();
+  int row_size = new_width * channels;
+  ThreadPool::ParallelFor(new_height, [&](unsigned int y)
+  {
+    float * row = result_data + y * row_size;
+    for (int t = vertical._first[y]; t < vertical._first[y + 1]; ++t) {
+      const float * tap_row = rows_data + vertical._indices[t] * row_size;
+      float weight = vertical._weights[t];
+      for (int i = 0; i < row_size; ++i)
+        row[i] += tap_row[i] * weight;
+    }
+  });
+}
+
+// Converts a filtered level back to bytes. Normals are renormalized first,
+// and the level keeps the renormalized normals for filtering the next one.
+void MipGenerator::Encode(std::vector<float> * values, int channels,
+  Content content, std::vector<unsigned char> * level)
+{
+  int pixel_count = (int)values->size() / channels;
+  level->resize(values->size());
+  for (int p = 0; p < pixel_count; ++p) {
+    float * texel = values->data() + p * channels;
+    unsigned char * out = level->data() + p * channels;
+    int first = 0;
+    if (content == NORMAL_MAP && channels >= 3) {
+      float length = std::sqrt(texel[0] * texel[0] + texel[1] * texel[1] +
+        texel[2] * texel[2]);
+      if (length > 0.0f) {
+        for (int c = 0; c < 3; ++c)
+          texel[c] /= length;
+      }
+      for (int c = 0; c < 3; ++c) {
+        float value = (texel[c] * 0.5f + 0.5f) * 255.0f + 0.5f;
+        out[c] = (unsigned char)std::min(std::max(value, 0.0f), 255.0f);
+      }
+      first = 3;
+    }
+    for (int c = first; c < channels; ++c) {
+      float value = std::min(std::max(texel[c], 0.0f), 1.0f);
+      if (content == COLOR && c < 3) {
+        int index = (int)(value * (float)(SRGB_TABLE_SIZE - 1) + 0.5f);
+        out[c] = srgb_tables._toSRGB[index];
+      }
+      else {
+        out[c] = (unsigned char)(value * 255.0f + 0.5f);
+      }
+    }
+  }
+}
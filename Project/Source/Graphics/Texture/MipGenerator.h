@@ -0,0 +1,60 @@
+/* All content(c) 2017 - 2018 DigiPen(USA) Corporation, all rights reserved. */
+#ifndef MIPGENERATOR_H
+#define MIPGENERATOR_H
+
+#include <mutex>
+#include <vector>
+
+/*****************************************************************************/
+/*!
+\class MipGenerator
+\brief
+  Creates the full mip chain of an image on the cpu. Each level is filtered
+  from the level above it with a separable windowed sinc filter, and the
+  rows of each pass are split across the ThreadPool.
+
+\par Important Notes
+  - Color is treated as sRGB. It is converted to linear before filtering and
+    back to sRGB afterwards so dark and bright texels are weighted by the
+    light they give off rather than by their encoded values. Alpha is
+    filtered as it is.
+  - Normal maps are filtered as vectors and every texel is renormalized.
+  - Generate is safe to call from the ThreadPool.
+*/
+/*****************************************************************************/
+class MipGenerator
+{
+public:
+  enum Content
+  {
+    COLOR,
+    NORMAL_MAP
+  };
+  enum Filter
+  {
+    BOX,
+    LANCZOS,
+    KAISER,
+    NUMFILTERS
+  };
+  static void Generate(const unsigned char * pixels, int width, int height,
+    int channels, Content content,
+    std::vector<std::vector<unsigned char> > * levels);
+  // The filter used by every Generate call. It is part of the texture cache
+  // keys, so changing it creates new cache entries.
+  static Filter _filter;
+  // The time spent generating levels and the number of pixels generated
+  static float _milliseconds;
+  static long long _pixels;
+private:
+  MipGenerator() {}
+  static void Downsample(const std::vector<float> & source, int width,
+    int height, int channels, int new_width, int new_height,
+    std::vector<float> * result);
+  static void Encode(std::vector<float> * values, int channels,
+    Content content, std::vector<unsigned char> * level);
+  //! Guards the statistics, which are written by workers
+  static std::mutex _statsMutex;
+};
+
+#endif // !MIPGENERATOR_H
@@ -11,16 +11,26 @@
 */
 /*****************************************************************************/
 
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <emmintrin.h>
+#include <vector>
+
 // using stb's image functions
 #define STB_IMAGE_IMPLEMENTATION
 #define STB_IMAGE_WRITE_IMPLEMENTATION
 #include <STB\stb_image.h>
 #include <STB\stb_image_write.h>
+#include "../../Core/ThreadPool.h"
 #include "../../Math/Reals.h"
 #include "../../Math/Vector3.h"
 #include "../../Utility/Error.h"
 #include "Texture.h"
 
+// The number of rows of a normal map that are created by one ThreadPool job
+#define NORMALMAP_BAND_ROWS 16
+
 /*****************************************************************************/
 /*!
 \brief
@@ -28,16 +38,28 @@
 
 \param filename
   The name of the file being loaded.
+\param flip_image_vertically
+  When true, the last row of the file becomes the first row of the data.
+\param allocator
+  Where the image data is allocated when the ImageDecoder handles the file.
+  Files it does not handle are loaded by stb.
 */
 /*****************************************************************************/
-Texture::Texture(const std::string & filename, bool flip_image_vertically) :
-  _imageFile(filename)
+Texture::Texture(const std::string & filename, bool flip_image_vertically,
+  ImageDecoder::Allocator * allocator) :
+  _imageFile(filename), _allocator(allocator)
 {
-  // flip image
-  stbi_set_flip_vertically_on_load(flip_image_vertically);
+  if (!_allocator)
+    _allocator = ImageDecoder::DefaultAllocator();
   // loading image
-  _imageData = stbi_load(filename.c_str(), &_width, 
-    &_height, &_channels, 0);
+  _imageData = ImageDecoder::Decode(filename, &_width, &_height, &_channels,
+    _allocator);
+  if (!_imageData) {
+    // stb frees its images with free, which is what the default uses
+    _allocator = ImageDecoder::DefaultAllocator();
+    _imageData = stbi_load(filename.c_str(), &_width,
+      &_height, &_channels, 0);
+  }
   if (!_imageData) {
     Error error("Texture.cpp", "Texture Constructor");
     error.Add("Image file failed to load.");
@@ -46,51 +68,213 @@ Texture::Texture(const std::string & filename, bool flip_image_vertically) :
     throw(error);
   }
   _dataLength = _width * _height * _channels;
+  // Textures are loaded on worker threads and stb's flip setting is shared
+  // by all of them, so the rows are flipped here instead.
+  if (flip_image_vertically) {
+    int row_size = _width * _channels;
+    for (int top = 0, bottom = _height - 1; top < bottom; ++top, --bottom) {
+      unsigned char * top_row = _imageData + top * row_size;
+      std::swap_ranges(top_row, top_row + row_size,
+        _imageData + bottom * row_size);
+    }
+  }
 }
 
 /*****************************************************************************/
 /*!
-\brief Simply frees the image data allocated by stb.
+\brief Gives the image data back to the allocator it came from.
 */
 /*****************************************************************************/
 Texture::~Texture()
 {
-  stbi_image_free(_imageData);
+  _allocator->Free(_imageData, _dataLength);
 }
 
-void Texture::CreateNormalMap(const std::string & out_filename, float strength)
+/*****************************************************************************/
+/*!
+\brief
+  Creates a normal map from the red channel of the image and saves it.
+
+\param out_filename
+  The png file the normal map is written to.
+\param strength
+  How much a change of one in height tilts the normals.
+\param normal_channels
+  CHANNELS_RGB for the normal alone or CHANNELS_RGBA to also keep the
+  height in the alpha channel.
+*/
+/*****************************************************************************/
+void Texture::CreateNormalMap(const std::string & out_filename, float strength,
+  int normal_channels)
+{
+  std::vector<unsigned char> normal_map(_width * _height * normal_channels);
+  CreateNormalMap(_imageData, _width, _height, _channels, strength,
+    normal_map.data(), normal_channels);
+  Texture::Write(out_filename, normal_map.data(), _width, _height,
+    normal_channels);
+}
+
+// Writes one pixel of a normal map. The normal is the cross product of the
+// slopes (1, 0, sdz) and (0, 1, tdz), which is (-sdz, -tdz, 1).
+static void NormalMapPixel(const unsigned char * row,
+  const unsigned char * below, const unsigned char * above, int width,
+  int channels, float strength, int x, unsigned char * normal,
+  int normal_channels)
+{
+  int left = Math::Clamp(x - 1, 0, width - 1) * channels;
+  int right = Math::Clamp(x + 1, 0, width - 1) * channels;
+  float nx = strength * (float)(row[left] - row[right]);
+  float ny = strength * (float)(above[x * channels] - below[x * channels]);
+  float length = std::sqrt(nx * nx + ny * ny + 1.0f);
+  normal[0] = (unsigned char)(127.5f * (nx / length + 1.0f));
+  normal[1] = (unsigned char)(127.5f * (ny / length + 1.0f));
+  normal[2] = (unsigned char)(127.5f * (1.0f / length + 1.0f));
+  if (normal_channels == CHANNELS_RGBA)
+    normal[3] = row[x * channels];
+}
+
+// Reads the first channel of four neighbouring pixels
+static __m128 LoadHeights(const unsigned char * pixels, int channels)
+{
+  if (channels == 1) {
+    int packed;
+    std::memcpy(&packed, pixels, sizeof(packed));
+    __m128i bytes = _mm_cvtsi32_si128(packed);
+    __m128i zero = _mm_setzero_si128();
+    bytes = _mm_unpacklo_epi16(_mm_unpacklo_epi8(bytes, zero), zero);
+    return _mm_cvtepi32_ps(bytes);
+  }
+  return _mm_setr_ps(pixels[0], pixels[channels], pixels[channels * 2],
+    pixels[channels * 3]);
+}
+
+// Writes one row of a normal map. The pixels away from the left and right
+// edges are done four at a time.
+static void NormalMapRow(const unsigned char * heights, int width, int height,
+  int channels, float strength, int y, unsigned char * normals,
+  int normal_channels)
+{
+  int row_size = width * channels;
+  const unsigned char * row = heights + y * row_size;
+  const unsigned char * below = heights + std::max(y - 1, 0) * row_size;
+  const unsigned char * above =
+    heights + std::min(y + 1, height - 1) * row_size;
+  NormalMapPixel(row, below, above, width, channels, strength, 0, normals,
+    normal_channels);
+  __m128 scale = _mm_set1_ps(strength);
+  __m128 one = _mm_set1_ps(1.0f);
+  __m128 half_range = _mm_set1_ps(127.5f);
+  int x = 1;
+  for (; x + 4 < width; x += 4) {
+    __m128 left = LoadHeights(row + (x - 1) * channels, channels);
+    __m128 right = LoadHeights(row + (x + 1) * channels, channels);
+    __m128 down = LoadHeights(below + x * channels, channels);
+    __m128 up = LoadHeights(above + x * channels, channels);
+    __m128 nx = _mm_mul_ps(scale, _mm_sub_ps(left, right));
+    __m128 ny = _mm_mul_ps(scale, _mm_sub_ps(up, down));
+    __m128 length = _mm_sqrt_ps(_mm_add_ps(one,
+      _mm_add_ps(_mm_mul_ps(nx, nx), _mm_mul_ps(ny, ny))));
+    __m128 components[3] = { nx, ny, one };
+    alignas(16) int values[3][4];
+    for (int c = 0; c < 3; ++c) {
+      __m128 value = _mm_add_ps(_mm_div_ps(components[c], length), one);
+      _mm_store_si128((__m128i *)values[c],
+        _mm_cvttps_epi32(_mm_mul_ps(half_range, value)));
+    }
+    unsigned char * normal = normals + x * normal_channels;
+    for (int i = 0; i < 4; ++i) {
+      normal[0] = (unsigned char)values[0][i];
+      normal[1] = (unsigned char)values[1][i];
+      normal[2] = (unsigned char)values[2][i];
+      if (normal_channels == CHANNELS_RGBA)
+        normal[3] = row[(x + i) * channels];
+      normal += normal_channels;
+    }
+  }
+  for (; x < width; ++x) {
+    NormalMapPixel(row, below, above, width, channels, strength, x,
+      normals + x * normal_channels, normal_channels);
+  }
+}
+
+/*****************************************************************************/
+/*!
+\brief
+  Creates a normal map from a height map using the central differences of
+  the heights. Bands of rows are split across the ThreadPool.
+
+\param heights
+  The height map. Only the first channel of each pixel is used.
+\param width
+  The width of the height map.
+\param height
+  The height of the height map.
+\param channels
+  The number of bytes per pixel of the height map.
+\param strength
+  How much a change of one in height tilts the normals.
+\param normal_map
+  The normals are written here. It must hold width * height *
+  normal_channels bytes.
+\param normal_channels
+  CHANNELS_RGB for the normal alone or CHANNELS_RGBA to also keep the
+  height in the alpha channel.
+*/
+/*****************************************************************************/
+void Texture::CreateNormalMap(const unsigned char * heights, int width,
+  int height, int channels, float strength, unsigned char * normal_map,
+  int normal_channels)
+{
+  int bands = (height + NORMALMAP_BAND_ROWS - 1) / NORMALMAP_BAND_ROWS;
+  ThreadPool::ParallelFor(bands, [=](unsigned int band)
+  {
+    int first_row = band * NORMALMAP_BAND_ROWS;
+    int last_row = std::min(first_row + NORMALMAP_BAND_ROWS, height);
+    for (int y = first_row; y < last_row; ++y) {
+      NormalMapRow(heights, width, height, channels, strength, y,
+        normal_map + y * width * normal_channels, normal_channels);
+    }
+  });
+}
+
+/*****************************************************************************/
+/*!
+\brief
+  Rotates the image data by 90 degrees. The first row of the image data is
+  treated as the top of the image.
+
+\param clockwise
+  When true, the image is rotated clockwise. Otherwise it is rotated counter
+  clockwise.
+*/
+/*****************************************************************************/
+void Texture::Rotate(bool clockwise)
 {
-  // buffer with normal map image data
-  unsigned char * normal_map_data = new unsigned char[_dataLength];
-  for (int i = 0; i < _width; ++i) {
-    for (int j = 0; j < _height; ++j) {
-      // find heights on the bump map
-      unsigned char left_height = RedAt(i - 1, j);
-      unsigned char right_height = RedAt(i + 1, j);
-      unsigned char bottom_height = RedAt(i, j - 1);
-      unsigned char top_height = RedAt(i, j + 1);
-      // find the change in heights
-      float sdz = strength * (float)(right_height - left_height);
-      float tdz = strength * (float)(bottom_height - top_height);
-      Math::Vector3 s(1.0f, 0.0f, sdz);
-      Math::Vector3 t(0.0f, 1.0f, tdz);
-      // find the normal and translate the normal into rgb
-      Math::Vector3 normal = Math::Cross(s, t).Normalized();
-      unsigned char r = (unsigned char)(255.0f * 0.5f * (normal.x + 1.0f));
-      unsigned char g = (unsigned char)(255.0f * 0.5f * (normal.y + 1.0f));
-      unsigned char b = (unsigned char)(255.0f * 0.5f * (normal.z + 1.0f));
-      // offset into new image array
-      unsigned offset = (j * _width + i) * CHANNELS_RGB;
-      // save the calculated rgb values
-      normal_map_data[offset + 0] = r;
-      normal_map_data[offset + 1] = g;
-      normal_map_data[offset + 2] = b;
+  unsigned char * rotated_data = _allocator->Allocate(_dataLength);
+  int rotated_width = _height;
+  int rotated_height = _width;
+  for (int r = 0; r < rotated_height; ++r) {
+    for (int c = 0; c < rotated_width; ++c) {
+      // find the pixel that ends up at row r, column c
+      int src_r, src_c;
+      if (clockwise) {
+        src_r = _height - 1 - c;
+        src_c = r;
+      }
+      else {
+        src_r = c;
+        src_c = _width - 1 - r;
+      }
+      unsigned dst_offset = (r * rotated_width + c) * _channels;
+      unsigned src_offset = (src_r * _width + src_c) * _channels;
+      for (int k = 0; k < _channels; ++k)
+        rotated_data[dst_offset + k] = _imageData[src_offset + k];
     }
   }
-  // save the normal_map to file
-  Texture::Write(out_filename, normal_map_data,
-    _width, _height, CHANNELS_RGB);
-  delete [] normal_map_data;
+  _allocator->Free(_imageData, _dataLength);
+  _imageData = rotated_data;
+  _width = rotated_width;
+  _height = rotated_height;
 }
 
 unsigned char Texture::RedAt(int i, int j)
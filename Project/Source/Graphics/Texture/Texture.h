@@ -16,6 +16,7 @@
 
 #include <string>
 #include "../Color.h"
+#include "ImageDecoder.h"
 
 #define CHANNELS_RGB  3
 #define CHANNELS_RGBA 4
@@ -34,15 +35,21 @@ class TexturePool;
 class Texture
 {
 public:
-  Texture(const std::string & filename, bool flip_image_vertically = false);
+  Texture(const std::string & filename, bool flip_image_vertically = false,
+    ImageDecoder::Allocator * allocator = nullptr);
   ~Texture();
-  void CreateNormalMap(const std::string & out_filename, float strength);
+  void CreateNormalMap(const std::string & out_filename, float strength,
+    int normal_channels = CHANNELS_RGB);
+  void Rotate(bool clockwise);
   unsigned char RedAt(int i, int j);
   const unsigned char * ImageData();
   int Width();
   int Height();
   int DataLength();
   int Channels();
+  static void CreateNormalMap(const unsigned char * heights, int width,
+    int height, int channels, float strength, unsigned char * normal_map,
+    int normal_channels);
   static void Write(const std::string & filename, const void * image_data, 
     int width, int height, int channels);
 private:
@@ -58,6 +65,8 @@ private:
   int _channels;
   //! The name of the file that the image was loaded from.
   std::string _imageFile;
+  //! Where the image data came from and where it is given back to.
+  ImageDecoder::Allocator * _allocator;
   // friends
   friend TexturePool;
 };
@@ -0,0 +1,372 @@
+/* All content(c) 2017 - 2018 DigiPen(USA) Corporation, all rights reserved. */
+#include <algorithm>
+#include <cstring>
+
+#include "../../Core/ThreadPool.h"
+#include "../../Utility/Error.h"
+#include "../../Utility/OpenGLError.h"
+#include "AtlasPacker.h"
+#include "Texture.h"
+#include "TextureArray.h"
+#include "TextureCompressor.h"
+
+// Changes whenever the way the cached levels are made changes. It is kept
+// above the bits TexturePool uses so the keys never match its images.
+#define TEXTUREARRAY_VERSION 1
+
+TextureArray::TextureArray() : _layers(0), _layerWidth(0), _layerHeight(0),
+  _coverage(0.0f), _texture(nullptr), _layerSize(0), _building(false),
+  _loaded(false)
+{}
+
+/*****************************************************************************/
+/*!
+\brief
+  Adds an image to the array. The image is not loaded until Build.
+
+\param file
+  The image file.
+\param content
+  What the image contains, which decides how its mip levels are filtered.
+
+\return The index of the image, which is the index its place is given to
+  the shader with.
+*/
+/*****************************************************************************/
+int TextureArray::Add(const std::string & file, MipGenerator::Content content)
+{
+  Entry entry;
+  entry._file = file;
+  entry._content = content;
+  entry._width = 0;
+  entry._height = 0;
+  entry._layer = 0;
+  entry._x = 0;
+  entry._y = 0;
+  _entries.push_back(entry);
+  return (int)_entries.size() - 1;
+}
+
+/*****************************************************************************/
+/*!
+\brief
+  Starts loading the mip levels of every added image on the ThreadPool. The
+  images are packed into layers and uploaded by the first Update after they
+  are loaded. Nothing happens while the array is loading or ready.
+
+\param layer_size
+  The size of each side of a layer. When this is zero and every image has
+  the same size, every image gets a layer of its own. Otherwise the images
+  share layers of this size, or of the smallest power of two that fits the
+  largest image when this is zero.
+*/
+/*****************************************************************************/
+void TextureArray::Build(int layer_size)
+{
+  if (_building || Ready() || _entries.empty())
+    return;
+  _layerSize = layer_size;
+  _building = true;
+  _loaded = false;
+  ThreadPool::Submit([this]()
+  {
+    ThreadPool::ParallelFor((unsigned int)_entries.size(),
+      [this](unsigned int i) { LoadLevels(&_entries[i]); });
+    {
+      std::lock_guard<std::mutex> lock(_loadedMutex);
+      _loaded = true;
+    }
+    _loadedCondition.notify_all();
+  });
+}
+
+/*****************************************************************************/
+/*!
+\brief
+  Packs and uploads the array once its images are loaded. Must be called on
+  the main thread, and only does work during the frame the loading finishes.
+*/
+/*****************************************************************************/
+void TextureArray::Update()
+{
+  if (!_building)
+    return;
+  {
+    std::lock_guard<std::mutex> lock(_loadedMutex);
+    if (!_loaded)
+      return;
+  }
+  Finish();
+  _building = false;
+}
+
+void TextureArray::Purge()
+{
+  if (_building) {
+    std::unique_lock<std::mutex> lock(_loadedMutex);
+    _loadedCondition.wait(lock, [this]() { return _loaded; });
+    _building = false;
+  }
+  if (_texture)
+    TexturePool::Unload(_texture);
+  _texture = nullptr;
+  _entries.clear();
+  _layers = 0;
+}
+
+void TextureArray::Bind(int location)
+{
+  TexturePool::Bind(_texture, location);
+}
+
+void TextureArray::Unbind()
+{
+  TexturePool::Unbind(_texture);
+}
+
+/*****************************************************************************/
+/*!
+\brief
+  Sets the uniform arrays that give the shader the place of every image.
+  A placement is the image's uv offset and layer, and a scale is the part of
+  the layer the image covers. The shader must be in use.
+
+\param shader
+  The shader the uniforms are set on.
+\param name
+  The start of the uniform names. The arrays are name + "Placements" and
+  name + "Scales".
+*/
+/*****************************************************************************/
+void TextureArray::SetUniforms(Shader * shader, const std::string & name)
+{
+  for (unsigned int i = 0; i < _entries.size(); ++i) {
+    const Entry & entry = _entries[i];
+    std::string index = "[" + std::to_string(i) + "]";
+    shader->SetUniform3f((name + "Placements" + index).c_str(),
+      (float)entry._x / (float)_layerWidth,
+      (float)entry._y / (float)_layerHeight, (float)entry._layer);
+    shader->SetUniform2f((name + "Scales" + index).c_str(),
+      (float)entry._width / (float)_layerWidth,
+      (float)entry._height / (float)_layerHeight);
+  }
+}
+
+bool TextureArray::Ready() const
+{
+  return _texture != nullptr;
+}
+
+// True from Build until the array is uploaded or fails
+bool TextureArray::Loading() const
+{
+  return _building;
+}
+
+/*****************************************************************************/
+/*!
+\brief
+  Finds the RGBA mip levels of an image in the texture cache or decodes the
+  image, makes its levels, and caches them. Runs on a worker.
+
+\param entry
+  The image. Its size and levels are written, or its errors when it could
+  not be loaded.
+*/
+/*****************************************************************************/
+void TextureArray::LoadLevels(Entry * entry)
+{
+  // everything that changes the levels is part of the key
+  unsigned int variant = (TEXTUREARRAY_VERSION << 24) |
+    ((unsigned int)MipGenerator::_filter << 8) | (unsigned int)entry->_content;
+  unsigned long long key = TextureCompressor::Key(entry->_file, variant);
+  TextureCompressor::Image image;
+  try {
+    if (!key || !TextureCompressor::Load(key, &image) ||
+      image._format != TextureCompressor::RGBA8) {
+      Texture texture(entry->_file);
+      int width = texture.Width();
+      int height = texture.Height();
+      int channels = texture.Channels();
+      const unsigned char * image_data = texture.ImageData();
+      // every layer is RGBA
+      std::vector<unsigned char> pixels(width * height * 4);
+      for (int p = 0; p < width * height; ++p) {
+        const unsigned char * in = image_data + p * channels;
+        unsigned char * out = pixels.data() + p * 4;
+        for (int c = 0; c < 3; ++c)
+          out[c] = in[std::min(c, channels - 1)];
+        out[3] = channels == 4 ? in[3] : 255;
+      }
+      TextureCompressor::Compress(pixels.data(), width, height, 4,
+        entry->_content, TextureCompressor::RGBA8, &image);
+      if (key)
+        TextureCompressor::Save(key, image);
+    }
+  }
+  catch (const Error & error) {
+    entry->_errors.push_back(error);
+    return;
+  }
+  entry->_width = image._width;
+  entry->_height = image._height;
+  entry->_levels.swap(image._levels);
+}
+
+// Packs the loaded images into layers and uploads the array. The levels are
+// freed once they are uploaded.
+void TextureArray::Finish()
+{
+  try {
+    bool same_size = true;
+    for (Entry & entry : _entries) {
+      for (const Error & error : entry._errors)
+        throw(error);
+      same_size = same_size && entry._width == _entries[0]._width &&
+        entry._height == _entries[0]._height;
+    }
+    bool shared = _layerSize != 0 || !same_size;
+    if (!Pack(_layerSize, shared)) {
+      Error error("TextureArray.cpp", "Finish");
+      error.Add("An image is larger than a layer");
+      error.Add("> Layer size");
+      error.Add(std::to_string(_layerWidth));
+      throw(error);
+    }
+    // shared layers only keep the levels that still have a gutter
+    int levels = 1 << 30;
+    for (const Entry & entry : _entries)
+      levels = std::min(levels, (int)entry._levels.size());
+    if (shared) {
+      int gutter_levels = 1;
+      while ((TEXTUREARRAY_GUTTER >> gutter_levels) > 0)
+        ++gutter_levels;
+      levels = std::min(levels, gutter_levels);
+    }
+    Upload(levels, shared);
+  }
+  catch (const Error & error) {
+    ErrorLog::Write(error);
+  }
+  for (Entry & entry : _entries) {
+    entry._levels.clear();
+    entry._errors.clear();
+  }
+}
+
+// Gives every image a layer and a place within it. Images are packed from
+// tallest to shortest into the first layer with room.
+bool TextureArray::Pack(int layer_size, bool shared)
+{
+  if (!shared) {
+    _layerWidth = _entries[0]._width;
+    _layerHeight = _entries[0]._height;
+    for (unsigned int i = 0; i < _entries.size(); ++i)
+      _entries[i]._layer = (int)i;
+    _layers = (int)_entries.size();
+    _coverage = 1.0f;
+    return true;
+  }
+  if (layer_size == 0) {
+    int largest = 1;
+    for (const Entry & entry : _entries) {
+      largest = std::max(largest,
+        std::max(entry._width, entry._height) + 2 * TEXTUREARRAY_GUTTER);
+    }
+    layer_size = 1;
+    while (layer_size < largest)
+      layer_size *= 2;
+  }
+  _layerWidth = layer_size;
+  _layerHeight = layer_size;
+  std::vector<Entry *> order;
+  for (Entry & entry : _entries)
+    order.push_back(&entry);
+  std::stable_sort(order.begin(), order.end(),
+    [](const Entry * a, const Entry * b) { return a->_height > b->_height; });
+  std::vector<AtlasPacker> packers;
+  for (Entry * entry : order) {
+    int width = entry->_width + 2 * TEXTUREARRAY_GUTTER;
+    int height = entry->_height + 2 * TEXTUREARRAY_GUTTER;
+    int x, y;
+    unsigned int layer = 0;
+    for (; layer < packers.size(); ++layer) {
+      if (packers[layer].Insert(width, height, &x, &y))
+        break;
+    }
+    if (layer == packers.size()) {
+      packers.push_back(AtlasPacker(layer_size, layer_size,
+        TEXTUREARRAY_GUTTER));
+      if (!packers.back().Insert(width, height, &x, &y))
+        return false;
+    }
+    entry->_layer = (int)layer;
+    entry->_x = x + TEXTUREARRAY_GUTTER;
+    entry->_y = y + TEXTUREARRAY_GUTTER;
+  }
+  _layers = (int)packers.size();
+  _coverage = 0.0f;
+  for (const AtlasPacker & packer : packers)
+    _coverage += packer.Coverage() / (float)_layers;
+  return true;
+}
+
+// Creates the array and copies every image level into its place. In shared
+// layers, the gutter around each image repeats the image's edge texels.
+void TextureArray::Upload(int levels, bool shared)
+{
+  GLuint id;
+  glGenTextures(1, &id);
+  glBindTexture(GL_TEXTURE_2D_ARRAY, id);
+  for (int level = 0; level < levels; ++level) {
+    glTexImage3D(GL_TEXTURE_2D_ARRAY, level, GL_RGBA8,
+      std::max(_layerWidth >> level, 1), std::max(_layerHeight >> level, 1),
+      _layers, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+  }
+  std::vector<unsigned char> texels;
+  for (int layer = 0; layer < _layers; ++layer) {
+    for (int level = 0; level < levels; ++level) {
+      int layer_width = std::max(_layerWidth >> level, 1);
+      int layer_height = std::max(_layerHeight >> level, 1);
+      int gutter = shared ? TEXTUREARRAY_GUTTER >> level : 0;
+      texels.assign(layer_width * layer_height * 4, 0);
+      for (const Entry & entry : _entries) {
+        if (entry._layer != layer)
+          continue;
+        int width = std::max(entry._width >> level, 1);
+        int height = std::max(entry._height >> level, 1);
+        int left = entry._x >> level;
+        int bottom = entry._y >> level;
+        const unsigned char * source = entry._levels[level].data();
+        for (int y = -gutter; y < height + gutter; ++y) {
+          int source_y = std::min(std::max(y, 0), height - 1);
+          int row = std::min(std::max(bottom + y, 0), layer_height - 1);
+          for (int x = -gutter; x < width + gutter; ++x) {
+            int source_x = std::min(std::max(x, 0), width - 1);
+            int column = std::min(std::max(left + x, 0), layer_width - 1);
+            std::memcpy(texels.data() + (row * layer_width + column) * 4,
+              source + (source_y * width + source_x) * 4, 4);
+          }
+        }
+      }
+      glTexSubImage3D(GL_TEXTURE_2D_ARRAY, level, 0, 0, layer, layer_width,
+        layer_height, 1, GL_RGBA, GL_UNSIGNED_BYTE, texels.data());
+    }
+  }
+  glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER,
+    GL_LINEAR_MIPMAP_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_BASE_LEVEL, 0);
+  glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, levels - 1);
+  glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+  _texture = TexturePool::Upload(id, GL_TEXTURE_2D_ARRAY);
+  try {
+    GLenum gl_error = glGetError();
+    OPENGLERRORCHECK("TextureArray.cpp", "Upload", "During texture array creation", gl_error);
+  }
+  catch (const Error & error) {
+    ErrorLog::Write(error);
+  }
+}
@@ -0,0 +1,94 @@
+/* All content(c) 2017 - 2018 DigiPen(USA) Corporation, all rights reserved. */
+#ifndef TEXTUREARRAY_H
+#define TEXTUREARRAY_H
+
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <GL/glew.h>
+#include "../../Utility/Error.h"
+#include "../Shader/Shader.h"
+#include "MipGenerator.h"
+#include "TexturePool.h"
+
+// The texels around each image in a shared layer that repeat the image's
+// edge. Images in shared layers only get the mip levels that still have a
+// gutter, so neighbouring images never bleed into each other.
+#define TEXTUREARRAY_GUTTER 8
+
+/*****************************************************************************/
+/*!
+\class TextureArray
+\brief
+  Packs several images into the layers of one GL_TEXTURE_2D_ARRAY so they
+  are bound with a single bind. When every image has the same size, each
+  image gets a layer of its own. Otherwise the images are packed into
+  shared layers by an AtlasPacker, and the shader maps its uvs into the
+  image's place with the offset and scale given by SetUniforms.
+
+\par Important Notes
+  - Images are added with Add. Build loads and filters them on the
+    ThreadPool, and the first Update after that packs and uploads the
+    array. Errors are written to the ErrorLog and leave the array unready.
+    Images must not be added while the array is loading.
+  - The layers are RGBA8. The mip levels of every image are made by the
+    MipGenerator with the image's own content, so color and normal maps can
+    share an array. The levels are kept in the texture cache, so only the
+    first build of an image decodes and filters it.
+*/
+/*****************************************************************************/
+class TextureArray
+{
+public:
+  TextureArray();
+  int Add(const std::string & file, MipGenerator::Content content);
+  void Build(int layer_size = 0);
+  void Update();
+  void Purge();
+  void Bind(int location);
+  void Unbind();
+  void SetUniforms(Shader * shader, const std::string & name);
+  bool Ready() const;
+  bool Loading() const;
+  // The number of layers and the size of a layer
+  int _layers;
+  int _layerWidth;
+  int _layerHeight;
+  // The fraction of the layers covered by images
+  float _coverage;
+private:
+  struct Entry
+  {
+    std::string _file;
+    MipGenerator::Content _content;
+    int _width;
+    int _height;
+    // Where the image is placed, not including the gutter
+    int _layer;
+    int _x;
+    int _y;
+    std::vector<std::vector<unsigned char> > _levels;
+    // Errors found while the levels were loaded
+    std::vector<Error> _errors;
+  };
+  void LoadLevels(Entry * entry);
+  void Finish();
+  bool Pack(int layer_size, bool shared);
+  void Upload(int levels, bool shared);
+  //! The images in the order they were added
+  std::vector<Entry> _entries;
+  TextureObject * _texture;
+  //! The layer size given to Build
+  int _layerSize;
+  //! Set from Build until the array is uploaded or fails
+  bool _building;
+  //! Set by the worker once the levels of every image are loaded
+  bool _loaded;
+  //! Guards the loaded flag
+  std::mutex _loadedMutex;
+  //! Signaled when the worker finishes loading
+  std::condition_variable _loadedCondition;
+};
+
+#endif // !TEXTUREARRAY_H
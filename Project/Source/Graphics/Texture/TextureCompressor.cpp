@@ -0,0 +1,697 @@
+/* All content(c) 2017 - 2018 DigiPen(USA) Corporation, all rights reserved. */
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <emmintrin.h>
+#include <fstream>
+#include <sstream>
+
+#include "../../Core/ThreadPool.h"
+#include "../Shader/ShaderCache.h"
+#include "TextureCompressor.h"
+
+// DDS constants. The header is 31 dwords after the magic number.
+#define DDS_MAGIC 0x20534444
+#define DDS_HEADER_DWORDS 31
+#define DDSD_CAPS 0x1
+#define DDSD_HEIGHT 0x2
+#define DDSD_WIDTH 0x4
+#define DDSD_PIXELFORMAT 0x1000
+#define DDSD_MIPMAPCOUNT 0x20000
+#define DDSD_PITCH 0x8
+#define DDSD_LINEARSIZE 0x80000
+#define DDPF_ALPHAPIXELS 0x1
+#define DDPF_FOURCC 0x4
+#define DDPF_RGB 0x40
+#define DDSCAPS_COMPLEX 0x8
+#define DDSCAPS_TEXTURE 0x1000
+#define DDSCAPS_MIPMAP 0x400000
+#define FOURCC(a, b, c, d) \
+  ((unsigned int)(a) | ((unsigned int)(b) << 8) | \
+  ((unsigned int)(c) << 16) | ((unsigned int)(d) << 24))
+
+// static initializations
+bool TextureCompressor::_enabled = true;
+int TextureCompressor::_hits = 0;
+int TextureCompressor::_misses = 0;
+float TextureCompressor::_encodeMilliseconds = 0.0f;
+long long TextureCompressor::_encodedPixels = 0;
+long long TextureCompressor::_rawBytes = 0;
+long long TextureCompressor::_compressedBytes = 0;
+bool TextureCompressor::_supported = false;
+double TextureCompressor::_squaredError = 0.0;
+long long TextureCompressor::_errorSamples = 0;
+std::mutex TextureCompressor::_statsMutex;
+
+// The 16 texels of a block split into channels so four texels of a channel
+// can be worked on at once
+struct Block
+{
+  alignas(16) float _channels[4][16];
+};
+
+// Copies the texels of block (bx, by) into a Block. Texels past the edge of
+// the image repeat the last row or column.
+static void LoadBlock(const unsigned char * pixels, int width, int height,
+  int channels, int bx, int by, Block * block)
+{
+  for (int y = 0; y < 4; ++y) {
+    int py = std::min(by * 4 + y, height - 1);
+    for (int x = 0; x < 4; ++x) {
+      int px = std::min(bx * 4 + x, width - 1);
+      const unsigned char * pixel = pixels + (py * width + px) * channels;
+      for (int c = 0; c < 4; ++c) {
+        float value;
+        if (c < channels)
+          value = pixel[c];
+        else if (c == 3)
+          value = 255.0f;
+        else
+          value = pixel[0];
+        block->_channels[c][y * 4 + x] = value;
+      }
+    }
+  }
+}
+
+// Finds the smallest and largest of 16 values
+static void MinMax(const float * values, float * min, float * max)
+{
+  __m128 a = _mm_load_ps(values);
+  __m128 b = _mm_load_ps(values + 4);
+  __m128 c = _mm_load_ps(values + 8);
+  __m128 d = _mm_load_ps(values + 12);
+  __m128 lo = _mm_min_ps(_mm_min_ps(a, b), _mm_min_ps(c, d));
+  __m128 hi = _mm_max_ps(_mm_max_ps(a, b), _mm_max_ps(c, d));
+  lo = _mm_min_ps(lo, _mm_shuffle_ps(lo, lo, _MM_SHUFFLE(2, 3, 0, 1)));
+  lo = _mm_min_ps(lo, _mm_shuffle_ps(lo, lo, _MM_SHUFFLE(1, 0, 3, 2)));
+  hi = _mm_max_ps(hi, _mm_shuffle_ps(hi, hi, _MM_SHUFFLE(2, 3, 0, 1)));
+  hi = _mm_max_ps(hi, _mm_shuffle_ps(hi, hi, _MM_SHUFFLE(1, 0, 3, 2)));
+  *min = _mm_cvtss_f32(lo);
+  *max = _mm_cvtss_f32(hi);
+}
+
+static float HorizontalSum(__m128 value)
+{
+  value = _mm_add_ps(value,
+    _mm_shuffle_ps(value, value, _MM_SHUFFLE(2, 3, 0, 1)));
+  value = _mm_add_ps(value,
+    _mm_shuffle_ps(value, value, _MM_SHUFFLE(1, 0, 3, 2)));
+  return _mm_cvtss_f32(value);
+}
+
+// Finds the sum of (a - mean_a) * (b - mean_b) over 16 values
+static float Covariance(const float * a, float mean_a, const float * b,
+  float mean_b)
+{
+  __m128 ma = _mm_set1_ps(mean_a);
+  __m128 mb = _mm_set1_ps(mean_b);
+  __m128 sum = _mm_setzero_ps();
+  for (int i = 0; i < 16; i += 4) {
+    __m128 da = _mm_sub_ps(_mm_load_ps(a + i), ma);
+    __m128 db = _mm_sub_ps(_mm_load_ps(b + i), mb);
+    sum = _mm_add_ps(sum, _mm_mul_ps(da, db));
+  }
+  return HorizontalSum(sum);
+}
+
+static unsigned short To565(const float * color)
+{
+  int r = (int)(color[0] * 31.0f / 255.0f + 0.5f);
+  int g = (int)(color[1] * 63.0f / 255.0f + 0.5f);
+  int b = (int)(color[2] * 31.0f / 255.0f + 0.5f);
+  return (unsigned short)((r << 11) | (g << 5) | b);
+}
+
+static void From565(unsigned short color, float * result)
+{
+  int r = (color >> 11) & 31;
+  int g = (color >> 5) & 63;
+  int b = color & 31;
+  result[0] = (float)((r << 3) | (r >> 2));
+  result[1] = (float)((g << 2) | (g >> 4));
+  result[2] = (float)((b << 3) | (b >> 2));
+}
+
+/*****************************************************************************/
+/*!
+\brief
+  Encodes the rgb of a block as a BC1 color block. The end points are the
+  corners of the block's bounding box, flipped along any channel that
+  decreases as green increases so the line between them follows the colors,
+  and inset slightly to reduce the error of the colors near the middle. Each
+  texel gets the palette entry closest to its projection onto that line.
+
+\param block
+  The block to encode.
+\param out
+  The 8 bytes of the encoded block.
+*/
+/*****************************************************************************/
+static void EncodeColor(const Block & block, unsigned char * out)
+{
+  float low[3], high[3], mean[3];
+  for (int c = 0; c < 3; ++c) {
+    MinMax(block._channels[c], &low[c], &high[c]);
+    __m128 sum = _mm_setzero_ps();
+    for (int i = 0; i < 16; i += 4)
+      sum = _mm_add_ps(sum, _mm_load_ps(block._channels[c] + i));
+    mean[c] = HorizontalSum(sum) / 16.0f;
+  }
+  // red and blue are compared against green since it has the most precision
+  for (int c = 0; c < 3; c += 2) {
+    float covariance = Covariance(block._channels[c], mean[c],
+      block._channels[1], mean[1]);
+    if (covariance < 0.0f)
+      std::swap(low[c], high[c]);
+  }
+  for (int c = 0; c < 3; ++c) {
+    float inset = (high[c] - low[c]) / 16.0f;
+    high[c] -= inset;
+    low[c] += inset;
+  }
+  unsigned short color0 = To565(high);
+  unsigned short color1 = To565(low);
+  // the first color must be larger to use the four color palette
+  if (color0 < color1)
+    std::swap(color0, color1);
+  unsigned int indices = 0;
+  if (color0 != color1) {
+    float end0[3], end1[3], axis[3];
+    From565(color0, end0);
+    From565(color1, end1);
+    float length2 = 0.0f;
+    for (int c = 0; c < 3; ++c) {
+      axis[c] = end0[c] - end1[c];
+      length2 += axis[c] * axis[c];
+    }
+    // t is 0 at color1 and 3 at color0 along the line
+    __m128 scale = _mm_set1_ps(3.0f / length2);
+    __m128 half = _mm_set1_ps(0.5f);
+    __m128 zero = _mm_setzero_ps();
+    __m128 three = _mm_set1_ps(3.0f);
+    // maps t to the palette entry with that position on the line
+    const unsigned int t_to_index[4] = { 1, 3, 2, 0 };
+    for (int i = 0; i < 16; i += 4) {
+      __m128 dot = _mm_setzero_ps();
+      for (int c = 0; c < 3; ++c) {
+        __m128 offset = _mm_sub_ps(_mm_load_ps(block._channels[c] + i),
+          _mm_set1_ps(end1[c]));
+        dot = _mm_add_ps(dot, _mm_mul_ps(offset, _mm_set1_ps(axis[c])));
+      }
+      __m128 t = _mm_add_ps(_mm_mul_ps(dot, scale), half);
+      t = _mm_min_ps(_mm_max_ps(t, zero), three);
+      alignas(16) int ts[4];
+      _mm_store_si128((__m128i *)ts, _mm_cvttps_epi32(t));
+      for (int j = 0; j < 4; ++j)
+        indices |= t_to_index[ts[j]] << (2 * (i + j));
+    }
+  }
+  out[0] = (unsigned char)(color0 & 0xff);
+  out[1] = (unsigned char)(color0 >> 8);
+  out[2] = (unsigned char)(color1 & 0xff);
+  out[3] = (unsigned char)(color1 >> 8);
+  for (int i = 0; i < 4; ++i)
+    out[4 + i] = (unsigned char)(indices >> (8 * i));
+}
+
+/*****************************************************************************/
+/*!
+\brief
+  Encodes one channel of a block as a BC4 block, which is the alpha block
+  of BC3 and each half of BC5. The end points are the smallest and largest
+  values so the eight value palette is used.
+
+\param values
+  The 16 values of the channel.
+\param out
+  The 8 bytes of the encoded block.
+*/
+/*****************************************************************************/
+static void EncodeChannel(const float * values, unsigned char * out)
+{
+  float low, high;
+  MinMax(values, &low, &high);
+  int value0 = (int)(high + 0.5f);
+  int value1 = (int)(low + 0.5f);
+  unsigned long long indices = 0;
+  if (value0 != value1) {
+    // t is 0 at value1 and 7 at value0
+    __m128 scale = _mm_set1_ps(7.0f / (float)(value0 - value1));
+    __m128 base = _mm_set1_ps((float)value1);
+    __m128 half = _mm_set1_ps(0.5f);
+    __m128 zero = _mm_setzero_ps();
+    __m128 seven = _mm_set1_ps(7.0f);
+    const unsigned long long t_to_index[8] = { 1, 7, 6, 5, 4, 3, 2, 0 };
+    for (int i = 0; i < 16; i += 4) {
+      __m128 t = _mm_sub_ps(_mm_load_ps(values + i), base);
+      t = _mm_add_ps(_mm_mul_ps(t, scale), half);
+      t = _mm_min_ps(_mm_max_ps(t, zero), seven);
+      alignas(16) int ts[4];
+      _mm_store_si128((__m128i *)ts, _mm_cvttps_epi32(t));
+      for (int j = 0; j < 4; ++j)
+        indices |= t_to_index[ts[j]] << (3 * (i + j));
+    }
+  }
+  out[0] = (unsigned char)value0;
+  out[1] = (unsigned char)value1;
+  for (int i = 0; i < 6; ++i)
+    out[2 + i] = (unsigned char)(indices >> (8 * i));
+}
+
+// Decodes a BC1 color block into the rgb of 16 texels
+static void DecodeColor(const unsigned char * in, unsigned char * texels)
+{
+  unsigned short color0 = (unsigned short)(in[0] | (in[1] << 8));
+  unsigned short color1 = (unsigned short)(in[2] | (in[3] << 8));
+  float palette[4][3];
+  From565(color0, palette[0]);
+  From565(color1, palette[1]);
+  for (int c = 0; c < 3; ++c) {
+    palette[2][c] = (2.0f * palette[0][c] + palette[1][c]) / 3.0f;
+    palette[3][c] = (palette[0][c] + 2.0f * palette[1][c]) / 3.0f;
+  }
+  unsigned int indices = in[4] | (in[5] << 8) | (in[6] << 16) |
+    ((unsigned int)in[7] << 24);
+  for (int i = 0; i < 16; ++i) {
+    unsigned int index = (indices >> (2 * i)) & 3;
+    for (int c = 0; c < 3; ++c)
+      texels[i * 3 + c] = (unsigned char)(palette[index][c] + 0.5f);
+  }
+}
+
+// Decodes a BC4 block into the values of 16 texels
+static void DecodeChannel(const unsigned char * in, unsigned char * values)
+{
+  float palette[8];
+  palette[0] = in[0];
+  palette[1] = in[1];
+  for (int i = 1; i < 7; ++i)
+    palette[i + 1] = ((7 - i) * palette[0] + i * palette[1]) / 7.0f;
+  unsigned long long indices = 0;
+  for (int i = 0; i < 6; ++i)
+    indices |= (unsigned long long)in[2 + i] << (8 * i);
+  for (int i = 0; i < 16; ++i)
+    values[i] = (unsigned char)(palette[(indices >> (3 * i)) & 7] + 0.5f);
+}
+
+static int BlockBytes(TextureCompressor::Format format)
+{
+  return format == TextureCompressor::BC1 ? 8 : 16;
+}
+
+// The bytes per pixel of the formats that are not compressed
+static int PixelBytes(TextureCompressor::Format format)
+{
+  return format == TextureCompressor::RGBA8 ? 4 : 3;
+}
+
+/*****************************************************************************/
+/*!
+\brief
+  Checks whether the driver supports the block formats. Call this after the
+  OpenGLContext is initialized.
+*/
+/*****************************************************************************/
+void TextureCompressor::Initialize()
+{
+  _supported = GLEW_EXT_texture_compression_s3tc != 0;
+}
+
+bool TextureCompressor::Supported()
+{
+  return _supported && _enabled;
+}
+
+bool TextureCompressor::Compressed(Format format)
+{
+  return format != RGB8 && format != RGBA8;
+}
+
+// The internal format of a texture with the format. The formats that are not
+// compressed also use this as the format of the uploaded pixels.
+GLenum TextureCompressor::GLFormat(Format format)
+{
+  switch (format)
+  {
+  case BC1: return GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+  case BC3: return GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+  case BC5: return GL_COMPRESSED_RG_RGTC2;
+  case RGB8: return GL_RGB;
+  default: return GL_RGBA;
+  }
+}
+
+// The number of bytes taken by a level of the given size
+int TextureCompressor::LevelBytes(Format format, int width, int height)
+{
+  if (!Compressed(format))
+    return width * height * PixelBytes(format);
+  int blocks_x = (width + 3) / 4;
+  int blocks_y = (height + 3) / 4;
+  return blocks_x * blocks_y * BlockBytes(format);
+}
+
+/*****************************************************************************/
+/*!
+\brief
+  Creates every mip level of an image with the MipGenerator and compresses
+  them. When the format is not compressed, the levels are kept as they are.
+
+\param pixels
+  The image data. The first row is the first row that is uploaded.
+\param width
+  The width of the image.
+\param height
+  The height of the image.
+\param channels
+  The number of bytes per pixel. It must match the format when the format
+  is not compressed.
+\param content
+  What the image contains, which decides how the levels are filtered.
+\param format
+  The format the image is stored in.
+\param image
+  The image is written here.
+*/
+/*****************************************************************************/
+void TextureCompressor::Compress(const unsigned char * pixels, int width,
+  int height, int channels, MipGenerator::Content content, Format format,
+  Image * image)
+{
+  image->_format = format;
+  image->_width = width;
+  image->_height = height;
+  MipGenerator::Generate(pixels, width, height, channels, content,
+    &image->_levels);
+  if (!Compressed(format)) {
+    std::lock_guard<std::mutex> lock(_statsMutex);
+    ++_misses;
+    return;
+  }
+  std::chrono::high_resolution_clock::time_point start =
+    std::chrono::high_resolution_clock::now();
+  int level_width = width;
+  int level_height = height;
+  long long pixel_count = 0;
+  for (std::vector<unsigned char> & level : image->_levels) {
+    // the level is replaced by its blocks
+    std::vector<unsigned char> blocks;
+    EncodeLevel(level.data(), level_width, level_height, channels, format,
+      &blocks);
+    level.swap(blocks);
+    pixel_count += level_width * level_height;
+    level_width = std::max(level_width / 2, 1);
+    level_height = std::max(level_height / 2, 1);
+  }
+  std::chrono::duration<float, std::milli> encode_time =
+    std::chrono::high_resolution_clock::now() - start;
+  MeasureError(pixels, width, height, channels, format, image->_levels[0]);
+  std::lock_guard<std::mutex> lock(_statsMutex);
+  _encodeMilliseconds += encode_time.count();
+  _encodedPixels += pixel_count;
+  ++_misses;
+}
+
+/*****************************************************************************/
+/*!
+\brief
+  Creates the cache key for a compressed image from the contents of the
+  file it comes from, so a changed file is compressed again.
+
+\param file
+  The image file.
+\param variant
+  Anything else that changes the compressed result, such as the format or
+  a rotation applied after the file is loaded.
+
+\return The key or 0 if the file could not be read.
+*/
+/*****************************************************************************/
+unsigned long long TextureCompressor::Key(const std::string & file,
+  unsigned int variant)
+{
+  std::ifstream stream(file.c_str(), std::ios::binary);
+  if (!stream.is_open())
+    return 0;
+  unsigned long long hash = FNV_OFFSET;
+  char buffer[4096];
+  while (stream) {
+    stream.read(buffer, sizeof(buffer));
+    std::streamsize count = stream.gcount();
+    for (std::streamsize i = 0; i < count; ++i) {
+      hash ^= (unsigned char)buffer[i];
+      hash *= FNV_PRIME;
+    }
+  }
+  for (int i = 0; i < 4; ++i) {
+    hash ^= (variant >> (8 * i)) & 0xff;
+    hash *= FNV_PRIME;
+  }
+  return hash;
+}
+
+/*****************************************************************************/
+/*!
+\brief
+  Reads a compressed image from the cache.
+
+\param key
+  The key of the image.
+\param image
+  The image is written here when it is found.
+
+\return True if the image was in the cache.
+*/
+/*****************************************************************************/
+bool TextureCompressor::Load(unsigned long long key, Image * image)
+{
+  std::ifstream file(Filename(key).c_str(), std::ios::binary);
+  if (!file.is_open())
+    return false;
+  unsigned int magic = 0;
+  unsigned int header[DDS_HEADER_DWORDS];
+  file.read((char *)&magic, sizeof(magic));
+  file.read((char *)header, sizeof(header));
+  if (!file || magic != DDS_MAGIC)
+    return false;
+  // the pixel format starts at 18. Its third dword is the fourcc and its
+  // fourth is the bits per pixel of a format that is not compressed.
+  if (header[19] & DDPF_RGB) {
+    if (header[21] == 24)
+      image->_format = RGB8;
+    else if (header[21] == 32)
+      image->_format = RGBA8;
+    else
+      return false;
+  }
+  else {
+    switch (header[20])
+    {
+    case FOURCC('D', 'X', 'T', '1'): image->_format = BC1; break;
+    case FOURCC('D', 'X', 'T', '5'): image->_format = BC3; break;
+    case FOURCC('A', 'T', 'I', '2'): image->_format = BC5; break;
+    default: return false;
+    }
+  }
+  image->_height = (int)header[2];
+  image->_width = (int)header[3];
+  int level_count = (int)std::max(header[6], 1u);
+  image->_levels.resize(level_count);
+  int level_width = image->_width;
+  int level_height = image->_height;
+  for (std::vector<unsigned char> & level : image->_levels) {
+    level.resize(LevelBytes(image->_format, level_width, level_height));
+    file.read((char *)level.data(), level.size());
+    level_width = std::max(level_width / 2, 1);
+    level_height = std::max(level_height / 2, 1);
+  }
+  if (!file)
+    return false;
+  std::lock_guard<std::mutex> lock(_statsMutex);
+  ++_hits;
+  return true;
+}
+
+// Writes a compressed image to the cache as a DDS file. Nothing is written
+// if the cache directory does not exist.
+void TextureCompressor::Save(unsigned long long key, const Image & image)
+{
+  std::ofstream file(Filename(key).c_str(), std::ios::binary);
+  if (!file.is_open())
+    return;
+  unsigned int header[DDS_HEADER_DWORDS] = { 0 };
+  header[0] = DDS_HEADER_DWORDS * 4;
+  header[1] = DDSD_CAPS | DDSD_HEIGHT | DDSD_WIDTH | DDSD_PIXELFORMAT |
+    DDSD_MIPMAPCOUNT;
+  header[2] = image._height;
+  header[3] = image._width;
+  header[6] = (unsigned int)image._levels.size();
+  // pixel format
+  header[18] = 32;
+  if (Compressed(image._format)) {
+    header[1] |= DDSD_LINEARSIZE;
+    header[4] = (unsigned int)image._levels[0].size();
+    header[19] = DDPF_FOURCC;
+  }
+  else {
+    // the pitch of a row and the bit masks of each channel
+    header[1] |= DDSD_PITCH;
+    header[4] = image._width * PixelBytes(image._format);
+    header[19] = DDPF_RGB;
+    header[21] = PixelBytes(image._format) * 8;
+    header[22] = 0xff;
+    header[23] = 0xff00;
+    header[24] = 0xff0000;
+    if (image._format == RGBA8) {
+      header[19] |= DDPF_ALPHAPIXELS;
+      header[25] = 0xff000000;
+    }
+  }
+  switch (image._format)
+  {
+  case BC1: header[20] = FOURCC('D', 'X', 'T', '1'); break;
+  case BC3: header[20] = FOURCC('D', 'X', 'T', '5'); break;
+  case BC5: header[20] = FOURCC('A', 'T', 'I', '2'); break;
+  default: break;
+  }
+  header[26] = DDSCAPS_TEXTURE | DDSCAPS_COMPLEX | DDSCAPS_MIPMAP;
+  unsigned int magic = DDS_MAGIC;
+  file.write((const char *)&magic, sizeof(magic));
+  file.write((const char *)header, sizeof(header));
+  for (const std::vector<unsigned char> & level : image._levels)
+    file.write((const char *)level.data(), level.size());
+}
+
+// The peak signal to noise ratio of every image encoded so far in decibels
+float TextureCompressor::PSNR()
+{
+  std::lock_guard<std::mutex> lock(_statsMutex);
+  if (_errorSamples == 0 || _squaredError == 0.0)
+    return 0.0f;
+  double mse = _squaredError / (double)_errorSamples;
+  return (float)(10.0 * std::log10(255.0 * 255.0 / mse));
+}
+
+// The number of millions of pixels encoded per second
+float TextureCompressor::Throughput()
+{
+  std::lock_guard<std::mutex> lock(_statsMutex);
+  if (_encodeMilliseconds == 0.0f)
+    return 0.0f;
+  return (float)_encodedPixels / (_encodeMilliseconds * 1000.0f);
+}
+
+// Encodes every block of a level. Rows of blocks are split across the pool.
+void TextureCompressor::EncodeLevel(const unsigned char * pixels, int width,
+  int height, int channels, Format format,
+  std::vector<unsigned char> * blocks)
+{
+  int blocks_x = (width + 3) / 4;
+  int blocks_y = (height + 3) / 4;
+  int block_bytes = BlockBytes(format);
+  blocks->resize(blocks_x * blocks_y * block_bytes);
+  unsigned char * out = blocks->data();
+  ThreadPool::ParallelFor(blocks_y, [=](unsigned int by)
+  {
+    Block block;
+    for (int bx = 0; bx < blocks_x; ++bx) {
+      LoadBlock(pixels, width, height, channels, bx, by, &block);
+      unsigned char * block_out = out + (by * blocks_x + bx) * block_bytes;
+      switch (format)
+      {
+      case BC1:
+        EncodeColor(block, block_out);
+        break;
+      case BC3:
+        EncodeChannel(block._channels[3], block_out);
+        EncodeColor(block, block_out + 8);
+        break;
+      case BC5:
+        EncodeChannel(block._channels[0], block_out);
+        EncodeChannel(block._channels[1], block_out + 8);
+        break;
+      default:
+        break;
+      }
+    }
+  });
+}
+
+// Decodes the first level of a compressed image and adds its error against
+// the original image to the totals used for the PSNR
+void TextureCompressor::MeasureError(const unsigned char * pixels, int width,
+  int height, int channels, Format format,
+  const std::vector<unsigned char> & blocks)
+{
+  int blocks_x = (width + 3) / 4;
+  int blocks_y = (height + 3) / 4;
+  int block_bytes = BlockBytes(format);
+  // the channels each format stores
+  int last = 3;
+  if (format == BC3)
+    last = 4;
+  else if (format == BC5)
+    last = 2;
+  last = std::min(last, channels);
+  double squared_error = 0.0;
+  long long samples = 0;
+  for (int by = 0; by < blocks_y; ++by) {
+    for (int bx = 0; bx < blocks_x; ++bx) {
+      const unsigned char * in = blocks.data() +
+        (by * blocks_x + bx) * block_bytes;
+      unsigned char texels[16][4];
+      unsigned char color[48];
+      unsigned char values[2][16];
+      switch (format)
+      {
+      case BC1:
+        DecodeColor(in, color);
+        break;
+      case BC3:
+        DecodeChannel(in, values[0]);
+        DecodeColor(in + 8, color);
+        break;
+      case BC5:
+        DecodeChannel(in, values[0]);
+        DecodeChannel(in + 8, values[1]);
+        break;
+      default:
+        break;
+      }
+      for (int i = 0; i < 16; ++i) {
+        if (format == BC5) {
+          texels[i][0] = values[0][i];
+          texels[i][1] = values[1][i];
+          continue;
+        }
+        for (int c = 0; c < 3; ++c)
+          texels[i][c] = color[i * 3 + c];
+        if (format == BC3)
+          texels[i][3] = values[0][i];
+      }
+      for (int y = 0; y < 4 && by * 4 + y < height; ++y) {
+        for (int x = 0; x < 4 && bx * 4 + x < width; ++x) {
+          const unsigned char * pixel =
+            pixels + ((by * 4 + y) * width + bx * 4 + x) * channels;
+          for (int c = 0; c < last; ++c) {
+            double difference = (double)pixel[c] - texels[y * 4 + x][c];
+            squared_error += difference * difference;
+            ++samples;
+          }
+        }
+      }
+    }
+  }
+  std::lock_guard<std::mutex> lock(_statsMutex);
+  _squaredError += squared_error;
+  _errorSamples += samples;
+}
+
+std::string TextureCompressor::Filename(unsigned long long key)
+{
+  std::stringstream filename;
+  filename << TEXTURECACHE_PATH << std::hex << key << ".dds";
+  return filename.str();
+}
@@ -0,0 +1,97 @@
+/* All content(c) 2017 - 2018 DigiPen(USA) Corporation, all rights reserved. */
+#ifndef TEXTURECOMPRESSOR_H
+#define TEXTURECOMPRESSOR_H
+
+#include <mutex>
+#include <string>
+#include <vector>
+#include <GL/glew.h>
+#include "MipGenerator.h"
+
+// The directory compressed textures are written to. It is shared with the
+// shader cache.
+#define TEXTURECACHE_PATH "Cache/"
+
+/*****************************************************************************/
+/*!
+\class TextureCompressor
+\brief
+  Encodes images into the BC1, BC3, and BC5 block formats on the cpu and
+  stores the results on disk as DDS files. An image contains every mip level
+  made by the MipGenerator, so it can be uploaded without generating mipmaps
+  on the gpu. Images that are not compressed are cached the same way with
+  the RGB8 and RGBA8 formats.
+
+\par Important Notes
+  - BC1 is used for rgb color, BC3 for rgba color, and BC5 for normal maps.
+    BC5 only stores the x and y of a normal, so shaders must rebuild z.
+  - Compress and the cache functions are safe to call from the ThreadPool.
+    The blocks of each level are split across the pool with ParallelFor.
+*/
+/*****************************************************************************/
+class TextureCompressor
+{
+public:
+  enum Format
+  {
+    BC1,
+    BC3,
+    BC5,
+    RGB8,
+    RGBA8
+  };
+  struct Image
+  {
+    Format _format;
+    int _width;
+    int _height;
+    // The blocks of every mip level, starting with the full size image
+    std::vector<std::vector<unsigned char> > _levels;
+  };
+  static void Initialize();
+  static bool Supported();
+  static bool Compressed(Format format);
+  static GLenum GLFormat(Format format);
+  static int LevelBytes(Format format, int width, int height);
+  static void Compress(const unsigned char * pixels, int width, int height,
+    int channels, MipGenerator::Content content, Format format,
+    Image * image);
+  static unsigned long long Key(const std::string & file,
+    unsigned int variant);
+  static bool Load(unsigned long long key, Image * image);
+  static void Save(unsigned long long key, const Image & image);
+  static float PSNR();
+  static float Throughput();
+  // When false, textures are uploaded without compression
+  static bool _enabled;
+  // The number of images that were found in and missing from the cache,
+  // compressed or not
+  static int _hits;
+  static int _misses;
+  // The time spent encoding and the number of pixels that were encoded
+  static float _encodeMilliseconds;
+  static long long _encodedPixels;
+  // The size the uploaded compressed images would have had uncompressed and
+  // the size they actually have
+  static long long _rawBytes;
+  static long long _compressedBytes;
+private:
+  TextureCompressor() {}
+  static void EncodeLevel(const unsigned char * pixels, int width,
+    int height, int channels, Format format,
+    std::vector<unsigned char> * blocks);
+  static void MeasureError(const unsigned char * pixels, int width,
+    int height, int channels, Format format,
+    const std::vector<unsigned char> & blocks);
+  static std::string Filename(unsigned long long key);
+  //! Whether the driver can use the s3tc formats BC1 and BC3 are part of
+  static bool _supported;
+  //! The sum of the squared errors of every encoded channel value and the
+  //! number of values, used for finding the PSNR
+  static double _squaredError;
+  static long long _errorSamples;
+  //! Guards the statistics, which are written by workers
+  static std::mutex _statsMutex;
+};
+
+#endif // !TEXTURECOMPRESSOR_H
@@ -1,26 +1,102 @@
 
 
+#include <vector>
+#include "../../Core/ThreadPool.h"
 #include "../../Utility/Error.h"
 #include "TexturePool.h"
 
 // byte depths
 #define RGB  3
 #define RGBA 4
+// Changes whenever the way cached images are made changes so older cache
+// files are no longer found
+#define TEXTURECACHE_VERSION 1
+
+/*****************************************************************************/
+/*!
+\class TextureRequest
+\brief
+  An image file or a set of cubemap faces that are being loaded for a
+  TextureObject. The worker that decodes the request only touches the
+  files, the images, and the errors. The object is only touched on the main
+  thread, so an unloaded object can be removed from a request in flight.
+*/
+/*****************************************************************************/
+struct TextureRequest
+{
+  //! The object that receives the images. Null when it was unloaded.
+  TextureObject * _object;
+  //! The image files. There are six for a cubemap.
+  std::vector<std::string> _files;
+  //! The quarter turns applied to each file after it is decoded. Positive
+  //! turns are clockwise. Empty when nothing is rotated.
+  std::vector<int> _rotations;
+  //! What the images are used for
+  TexturePool::Usage _usage;
+  //! Whether the images are block compressed
+  bool _compress;
+  //! The images with all of their mip levels
+  std::vector<TextureCompressor::Image> _images;
+  //! The total size of the images in bytes
+  int _bytes;
+  //! Errors from decoding that are written to the ErrorLog on upload
+  std::vector<Error> _errors;
+};
 
 // static initializations
 TextureObject * TexturePool::_boundTextures[MAXBOUNDTEXTURES] = { nullptr };
+int TexturePool::_uploadBudget = TEXTURE_UPLOAD_BUDGET;
+int TexturePool::_completedRequests = 0;
+float TexturePool::_uploadMilliseconds = 0.0f;
+float TexturePool::_loadMilliseconds = 0.0f;
+std::deque<TextureRequest *> TexturePool::_decoded;
+std::mutex TexturePool::_decodedMutex;
+std::condition_variable TexturePool::_decodedCondition;
+int TexturePool::_pendingRequests = 0;
+std::chrono::high_resolution_clock::time_point TexturePool::_loadStart;
+int TexturePool::_memoryBudget = TEXTURE_MEMORY_BUDGET;
+long long TexturePool::_residentBytes = 0;
+long long TexturePool::_unusedBytes = 0;
+int TexturePool::_residentTextures = 0;
+int TexturePool::_cacheHits = 0;
+int TexturePool::_evictions = 0;
+int TexturePool::_binds = 0;
+int TexturePool::_frameBinds = 0;
+ImageDecoder::BufferPool TexturePool::_imageBuffers;
+std::unordered_map<std::string, TextureObject *> TexturePool::_cache;
+std::list<TextureObject *> TexturePool::_unusedTextures;
+
+/*****************************************************************************/
+/*!
+\brief
+  Loads an image file into a texture. If the file was already loaded, the
+  texture that was created for it is returned instead.
 
+\param file
+  The image file that will be loaded.
+
+\return The TextureObject for the image or nullptr if it failed to load.
+*/
+/*****************************************************************************/
 TextureObject * TexturePool::Upload(const std::string & file)
 {
+  TextureObject * cached = FindCached(file);
+  if (cached)
+    return cached;
   try{
     Texture texture(file);
-    return Upload(texture);
+    TextureObject * new_texture_object = Upload(texture);
+    if (new_texture_object)
+      Cache(new_texture_object, file);
+    return new_texture_object;
   }
   catch (const Error & error) {
     ErrorLog::Write(error);
+    return nullptr;
   }
 }
 
+// Uploads an image and the mip levels the MipGenerator makes from it
 TextureObject * TexturePool::Upload(const Texture & texture)
 {
   TextureObject * new_texture_object = new TextureObject();
@@ -30,43 +106,254 @@ TextureObject * TexturePool::Upload(const Texture & texture)
   glBindTexture(GL_TEXTURE_2D, new_texture_object->_glID);
   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER,
+    GL_LINEAR_MIPMAP_LINEAR);
   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-  // for rgb or rgba
-  switch (texture._channels)
-  {
-  case RGB:
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, texture._width, texture._height, 0,
-      GL_RGB, GL_UNSIGNED_BYTE, texture._imageData);
-    break;
-  case RGBA:
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, texture._width, texture._height, 
-      0, GL_RGBA, GL_UNSIGNED_BYTE, texture._imageData);
-    break;
-  default:
+  if (texture._channels != RGB && texture._channels != RGBA) {
     Error error("TexturePool.cpp", "Upload");
     error.Add("Image file format not supported");
     error.Add("> Image file");
     error.Add(texture._imageFile.c_str());
     ErrorLog::Write(error);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glDeleteTextures(1, &new_texture_object->_glID);
+    delete new_texture_object;
     return nullptr;
   }
-  glGenerateMipmap(GL_TEXTURE_2D);
+  TextureCompressor::Image image;
+  image._format = texture._channels == RGBA ? TextureCompressor::RGBA8 :
+    TextureCompressor::RGB8;
+  image._width = texture._width;
+  image._height = texture._height;
+  MipGenerator::Generate(texture._imageData, texture._width,
+    texture._height, texture._channels, MipGenerator::COLOR, &image._levels);
+  UploadLevels(GL_TEXTURE_2D, image);
   glBindTexture(GL_TEXTURE_2D, 0); // need to make sure you rebind the texture that was bound here
+  ++_residentTextures;
+  Measure(new_texture_object);
   return new_texture_object;
 }
 
-TextureObject * TexturePool::Upload(GLuint glID)
+// Wraps a texture that was created elsewhere. The pool takes ownership of the
+// texture and deletes it when the object is unloaded.
+TextureObject * TexturePool::Upload(GLuint glID, GLenum target)
 {
   TextureObject * new_texture_object = new TextureObject();
   new_texture_object->_glID = glID;
+  new_texture_object->_target = target;
+  ++_residentTextures;
+  Measure(new_texture_object);
   return new_texture_object;
 }
 
+// faces are given in the order +x, -x, +y, -y, +z, -z
+TextureObject * TexturePool::UploadCubemap(const Texture * const * faces)
+{
+  TextureObject * new_texture_object = new TextureObject();
+  new_texture_object->_target = GL_TEXTURE_CUBE_MAP;
+  glGenTextures(1, &new_texture_object->_glID);
+  glActiveTexture(GL_TEXTURE0);
+  glBindTexture(GL_TEXTURE_CUBE_MAP, new_texture_object->_glID);
+  glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+  glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+  for (int i = 0; i < 6; ++i) {
+    GLenum face_target = GL_TEXTURE_CUBE_MAP_POSITIVE_X + i;
+    if (!UploadImage(face_target, *faces[i], "UploadCubemap")) {
+      glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
+      glDeleteTextures(1, &new_texture_object->_glID);
+      delete new_texture_object;
+      return nullptr;
+    }
+  }
+  glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
+  ++_residentTextures;
+  Measure(new_texture_object);
+  return new_texture_object;
+}
+
+/*****************************************************************************/
+/*!
+\brief
+  Requests an image file. The file is decoded on the ThreadPool and the
+  image replaces the placeholder during a later call to UpdateUploads. If the
+  file was already uploaded or requested, that texture is returned instead.
+
+\param file
+  The image file that will be loaded.
+\param placeholder
+  The color the texture has until the image is uploaded.
+\param usage
+  What the image is used for. Normal maps are compressed to BC5, which only
+  keeps the x and y of each normal. Height maps are neither compressed nor
+  given mip levels.
+
+\return The TextureObject for the image. It can be used right away.
+*/
+/*****************************************************************************/
+TextureObject * TexturePool::Request(const std::string & file,
+  const Color & placeholder, Usage usage)
+{
+  std::string name = CacheName(file, usage);
+  TextureObject * cached = FindCached(name);
+  if (cached)
+    return cached;
+  TextureRequest * request = new TextureRequest();
+  request->_object = CreatePlaceholder(GL_TEXTURE_2D, placeholder);
+  request->_files.push_back(file);
+  request->_usage = usage;
+  Cache(request->_object, name);
+  QueueRequest(request);
+  return request->_object;
+}
+
+/*****************************************************************************/
+/*!
+\brief
+  Requests the six faces of a cubemap. They are decoded on the ThreadPool and
+  uploaded together during a later call to UpdateUploads.
+
+\param faces
+  The six image files in the order +x, -x, +y, -y, +z, -z.
+\param rotations
+  When given, the number of quarter turns each face is rotated by after it
+  is decoded. Positive turns are clockwise.
+\param placeholder
+  The color of every face until the images are uploaded.
+
+\return The TextureObject for the cubemap. It can be used right away.
+*/
+/*****************************************************************************/
+TextureObject * TexturePool::RequestCubemap(const std::string * faces,
+  const int * rotations, const Color & placeholder)
+{
+  TextureRequest * request = new TextureRequest();
+  request->_object = CreatePlaceholder(GL_TEXTURE_CUBE_MAP, placeholder);
+  request->_files.assign(faces, faces + 6);
+  if (rotations)
+    request->_rotations.assign(rotations, rotations + 6);
+  request->_usage = COLOR;
+  QueueRequest(request);
+  return request->_object;
+}
+
+/*****************************************************************************/
+/*!
+\brief
+  Uploads the requests that finished decoding. Requests are uploaded in the
+  order they finished until the next one would go over _uploadBudget.
+*/
+/*****************************************************************************/
+void TexturePool::UpdateUploads()
+{
+  // this is called once a frame, so it closes the frame's bind count
+  _frameBinds = _binds;
+  _binds = 0;
+  std::chrono::high_resolution_clock::time_point start =
+    std::chrono::high_resolution_clock::now();
+  std::vector<TextureRequest *> uploads;
+  {
+    std::lock_guard<std::mutex> lock(_decodedMutex);
+    int bytes = 0;
+    while (!_decoded.empty()) {
+      TextureRequest * request = _decoded.front();
+      if (!uploads.empty() && bytes + request->_bytes > _uploadBudget)
+        break;
+      bytes += request->_bytes;
+      uploads.push_back(request);
+      _decoded.pop_front();
+    }
+  }
+  for (TextureRequest * request : uploads)
+    CompleteRequest(request);
+  std::chrono::duration<float, std::milli> upload_time =
+    std::chrono::high_resolution_clock::now() - start;
+  _uploadMilliseconds = upload_time.count();
+}
+
+/*****************************************************************************/
+/*!
+\brief
+  Waits for every request to be decoded and uploads all of them, ignoring
+  the upload budget.
+*/
+/*****************************************************************************/
+void TexturePool::FinishUploads()
+{
+  while (_pendingRequests > 0) {
+    TextureRequest * request;
+    {
+      std::unique_lock<std::mutex> lock(_decodedMutex);
+      _decodedCondition.wait(lock, []() { return !_decoded.empty(); });
+      request = _decoded.front();
+      _decoded.pop_front();
+    }
+    CompleteRequest(request);
+  }
+}
+
+// Checks whether a texture shows its image rather than a placeholder
+bool TexturePool::Loaded(const TextureObject * texture_object)
+{
+  return texture_object->_request == nullptr;
+}
+
+// The size of the first level of a texture
+void TexturePool::Size(const TextureObject * texture_object, int * width,
+  int * height)
+{
+  GLenum level_target = texture_object->_target;
+  if (level_target == GL_TEXTURE_CUBE_MAP)
+    level_target = GL_TEXTURE_CUBE_MAP_POSITIVE_X;
+  glActiveTexture(GL_TEXTURE0);
+  glBindTexture(texture_object->_target, texture_object->_glID);
+  glGetTexLevelParameteriv(level_target, 0, GL_TEXTURE_WIDTH, width);
+  glGetTexLevelParameteriv(level_target, 0, GL_TEXTURE_HEIGHT, height);
+  glBindTexture(texture_object->_target, 0);
+}
+
+int TexturePool::PendingRequests()
+{
+  return _pendingRequests;
+}
+
+/*****************************************************************************/
+/*!
+\brief
+  Removes a reference to a texture. A texture without references is deleted
+  unless it is cached, in which case it is kept for later uploads of the same
+  file until the memory budget is needed for other textures.
+
+\param texture_object
+  The texture that is no longer used by the caller.
+*/
+/*****************************************************************************/
 void TexturePool::Unload(TextureObject * texture_object)
 {
+  if (--texture_object->_references > 0)
+    return;
   Unbind(texture_object);
-  delete texture_object;
+  if (texture_object->_file.empty()) {
+    Destroy(texture_object);
+    return;
+  }
+  _unusedTextures.push_front(texture_object);
+  texture_object->_unused = _unusedTextures.begin();
+  _unusedBytes += texture_object->_bytes;
+  Evict();
+}
+
+// Deletes the cached textures that are no longer used. Every other texture
+// must have been unloaded.
+void TexturePool::Purge()
+{
+  // requests still being decoded are freed once they finish
+  FinishUploads();
+  while (!_unusedTextures.empty())
+    Destroy(_unusedTextures.back());
+  _imageBuffers.Clear();
 }
 
 bool TexturePool::Bind(TextureObject * texture_object, int location)
@@ -81,7 +368,8 @@ bool TexturePool::Bind(TextureObject * texture_object, int location)
   if (texture_object->_boundLocation != -1)
     return false;
   glActiveTexture(GL_TEXTURE0 + location);
-  glBindTexture(GL_TEXTURE_2D, texture_object->_glID);
+  glBindTexture(texture_object->_target, texture_object->_glID);
+  ++_binds;
   _boundTextures[location] = texture_object;
   texture_object->_boundLocation = location;
   return true;
@@ -92,8 +380,384 @@ bool TexturePool::Unbind(TextureObject * texture_object)
   if (texture_object->_boundLocation == -1)
     return false;
   glActiveTexture(GL_TEXTURE0 + texture_object->_boundLocation);
-  glBindTexture(GL_TEXTURE_2D, 0);
-  _boundTextures[texture_object->_boundLocation];
+  glBindTexture(texture_object->_target, 0);
+  ++_binds;
+  _boundTextures[texture_object->_boundLocation] = nullptr;
   texture_object->_boundLocation = -1;
   return true;
-}
\ No newline at end of file
+}
+
+// Creates a texture with a single pixel of the placeholder color in each
+// image the target has
+TextureObject * TexturePool::CreatePlaceholder(GLenum target,
+  const Color & placeholder)
+{
+  TextureObject * new_texture_object = new TextureObject();
+  new_texture_object->_target = target;
+  unsigned char pixel[RGB];
+  for (int i = 0; i < RGB; ++i)
+    pixel[i] = (unsigned char)(255.0f * placeholder._values[i]);
+  glGenTextures(1, &new_texture_object->_glID);
+  glActiveTexture(GL_TEXTURE0);
+  glBindTexture(target, new_texture_object->_glID);
+  glTexParameteri(target, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+  glTexParameteri(target, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+  glTexParameteri(target, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+  glTexParameteri(target, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+  if (target == GL_TEXTURE_CUBE_MAP) {
+    glTexParameteri(target, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+    for (int i = 0; i < 6; ++i) {
+      glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RGB, 1, 1, 0,
+        GL_RGB, GL_UNSIGNED_BYTE, pixel);
+    }
+  }
+  else {
+    glTexImage2D(target, 0, GL_RGB, 1, 1, 0, GL_RGB, GL_UNSIGNED_BYTE,
+      pixel);
+  }
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+  glBindTexture(target, 0);
+  ++_residentTextures;
+  Measure(new_texture_object);
+  return new_texture_object;
+}
+
+// Uploads an rgb or rgba image to the bound texture. Any other channel count
+// is written to the ErrorLog and false is returned.
+bool TexturePool::UploadImage(GLenum target, const Texture & texture,
+  const char * function)
+{
+  // for rgb or rgba
+  switch (texture._channels)
+  {
+  case RGB:
+    glTexImage2D(target, 0, GL_RGB, texture._width, texture._height, 0,
+      GL_RGB, GL_UNSIGNED_BYTE, texture._imageData);
+    return true;
+  case RGBA:
+    glTexImage2D(target, 0, GL_RGBA, texture._width, texture._height, 0,
+      GL_RGBA, GL_UNSIGNED_BYTE, texture._imageData);
+    return true;
+  default:
+    Error error("TexturePool.cpp", function);
+    error.Add("Image file format not supported");
+    error.Add("> Image file");
+    error.Add(texture._imageFile.c_str());
+    ErrorLog::Write(error);
+    return false;
+  }
+}
+
+/*****************************************************************************/
+/*!
+\brief
+  Finds the mip levels of a file in the cache or decodes the file, makes its
+  levels, and caches them. Runs on a worker.
+
+\param file
+  The image file.
+\param usage
+  What the image is used for.
+\param rotation
+  The quarter turns applied to the image before its levels are made.
+\param compress
+  Whether the levels are block compressed.
+\param image
+  The image is written here.
+*/
+/*****************************************************************************/
+void TexturePool::LoadImage(const std::string & file, Usage usage,
+  int rotation, bool compress, TextureCompressor::Image * image)
+{
+  // everything that changes the result is part of the key
+  unsigned int variant = (TEXTURECACHE_VERSION << 16) |
+    ((unsigned int)MipGenerator::_filter << 8) |
+    ((unsigned int)compress << 6) | ((unsigned int)usage << 4) |
+    (rotation & 3);
+  unsigned long long key = TextureCompressor::Key(file, variant);
+  if (key && TextureCompressor::Load(key, image))
+    return;
+  Texture texture(file, false, &_imageBuffers);
+  for (int i = 0; i < rotation; ++i)
+    texture.Rotate(true);
+  for (int i = 0; i > rotation; --i)
+    texture.Rotate(false);
+  if (texture._channels != RGB && texture._channels != RGBA) {
+    Error error("TexturePool.cpp", "LoadImage");
+    error.Add("Image file format not supported");
+    error.Add("> Image file");
+    error.Add(file.c_str());
+    throw(error);
+  }
+  if (usage == HEIGHT_MAP) {
+    image->_format = texture._channels == RGBA ? TextureCompressor::RGBA8 :
+      TextureCompressor::RGB8;
+    image->_width = texture._width;
+    image->_height = texture._height;
+    const unsigned char * pixels = texture._imageData;
+    image->_levels.assign(1, std::vector<unsigned char>(pixels,
+      pixels + texture._width * texture._height * texture._channels));
+    if (key)
+      TextureCompressor::Save(key, *image);
+    return;
+  }
+  TextureCompressor::Format format;
+  if (!compress)
+    format = texture._channels == RGBA ? TextureCompressor::RGBA8 :
+      TextureCompressor::RGB8;
+  else if (usage == NORMAL_MAP)
+    format = TextureCompressor::BC5;
+  else if (texture._channels == RGBA)
+    format = TextureCompressor::BC3;
+  else
+    format = TextureCompressor::BC1;
+  MipGenerator::Content content = MipGenerator::COLOR;
+  if (usage == NORMAL_MAP)
+    content = MipGenerator::NORMAL_MAP;
+  TextureCompressor::Compress(texture._imageData, texture._width,
+    texture._height, texture._channels, content, format, image);
+  if (key)
+    TextureCompressor::Save(key, *image);
+}
+
+// Uploads every level of an image to the bound texture
+void TexturePool::UploadLevels(GLenum target,
+  const TextureCompressor::Image & image)
+{
+  GLenum format = TextureCompressor::GLFormat(image._format);
+  bool compressed = TextureCompressor::Compressed(image._format);
+  // the size the levels would have uncompressed
+  int channels = image._format == TextureCompressor::BC3 ? RGBA : RGB;
+  int width = image._width;
+  int height = image._height;
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+  for (unsigned int level = 0; level < image._levels.size(); ++level) {
+    const std::vector<unsigned char> & data = image._levels[level];
+    if (compressed) {
+      glCompressedTexImage2D(target, level, format, width, height, 0,
+        (GLsizei)data.size(), data.data());
+      TextureCompressor::_rawBytes += width * height * channels;
+      TextureCompressor::_compressedBytes += data.size();
+    }
+    else {
+      glTexImage2D(target, level, format, width, height, 0, format,
+        GL_UNSIGNED_BYTE, data.data());
+    }
+    width = width > 1 ? width / 2 : 1;
+    height = height > 1 ? height / 2 : 1;
+  }
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+}
+
+void TexturePool::QueueRequest(TextureRequest * request)
+{
+  request->_object->_request = request;
+  request->_bytes = 0;
+  request->_compress = TextureCompressor::Supported() &&
+    request->_usage != HEIGHT_MAP;
+  if (_pendingRequests == 0)
+    _loadStart = std::chrono::high_resolution_clock::now();
+  ++_pendingRequests;
+  ThreadPool::Submit([request]() { Decode(request); });
+}
+
+// Runs on a worker. Decodes the files of a request and queues it for upload.
+void TexturePool::Decode(TextureRequest * request)
+{
+  try {
+    for (unsigned int i = 0; i < request->_files.size(); ++i) {
+      const std::string & file = request->_files[i];
+      int rotation = request->_rotations.empty() ? 0 : request->_rotations[i];
+      request->_images.push_back(TextureCompressor::Image());
+      LoadImage(file, request->_usage, rotation, request->_compress,
+        &request->_images.back());
+      for (const std::vector<unsigned char> & level :
+        request->_images.back()._levels)
+        request->_bytes += (int)level.size();
+    }
+  }
+  catch (const Error & error) {
+    request->_errors.push_back(error);
+  }
+  {
+    std::lock_guard<std::mutex> lock(_decodedMutex);
+    _decoded.push_back(request);
+  }
+  _decodedCondition.notify_all();
+}
+
+// Replaces the placeholder of a decoded request with its images and frees
+// the request. A request that failed keeps its placeholder and is removed
+// from the cache.
+void TexturePool::CompleteRequest(TextureRequest * request)
+{
+  for (const Error & error : request->_errors)
+    ErrorLog::Write(error);
+  TextureObject * object = request->_object;
+  if (object)
+    object->_request = nullptr;
+  if (object && request->_errors.empty()) {
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(object->_target, object->_glID);
+    for (unsigned int i = 0; i < request->_images.size(); ++i) {
+      GLenum image_target = object->_target;
+      if (image_target == GL_TEXTURE_CUBE_MAP)
+        image_target = GL_TEXTURE_CUBE_MAP_POSITIVE_X + i;
+      UploadLevels(image_target, request->_images[i]);
+    }
+    GLint max_level = (GLint)request->_images[0]._levels.size() - 1;
+    glTexParameteri(object->_target, GL_TEXTURE_MAX_LEVEL, max_level);
+    if (max_level > 0) {
+      glTexParameteri(object->_target, GL_TEXTURE_MIN_FILTER,
+        GL_LINEAR_MIPMAP_LINEAR);
+    }
+    glBindTexture(object->_target, 0);
+    Measure(object);
+  }
+  else if (object && !object->_file.empty()) {
+    // the file is tried again by the next upload or request for it
+    if (object->_references == 0) {
+      Destroy(object);
+    }
+    else {
+      _cache.erase(object->_file);
+      object->_file.clear();
+    }
+  }
+  delete request;
+  ++_completedRequests;
+  if (--_pendingRequests == 0) {
+    std::chrono::duration<float, std::milli> load_time =
+      std::chrono::high_resolution_clock::now() - _loadStart;
+    _loadMilliseconds = load_time.count();
+  }
+}
+
+// The name a requested file is cached under. A file requested for something
+// other than color is a different texture, so the usage is added to it.
+std::string TexturePool::CacheName(const std::string & file, Usage usage)
+{
+  if (usage == COLOR)
+    return file;
+  return file + "#" + std::to_string((int)usage);
+}
+
+// Finds the texture cached for a file and adds a reference to it
+TextureObject * TexturePool::FindCached(const std::string & file)
+{
+  std::unordered_map<std::string, TextureObject *>::iterator it =
+    _cache.find(file);
+  if (it == _cache.end())
+    return nullptr;
+  TextureObject * texture_object = it->second;
+  if (texture_object->_references == 0) {
+    _unusedTextures.erase(texture_object->_unused);
+    _unusedBytes -= texture_object->_bytes;
+  }
+  ++texture_object->_references;
+  ++_cacheHits;
+  return texture_object;
+}
+
+void TexturePool::Cache(TextureObject * texture_object,
+  const std::string & file)
+{
+  texture_object->_file = file;
+  _cache[file] = texture_object;
+}
+
+// Deletes the least recently used unused textures until the resident
+// textures fit in the memory budget or there are no unused textures left
+void TexturePool::Evict()
+{
+  while (_residentBytes > _memoryBudget && !_unusedTextures.empty()) {
+    Destroy(_unusedTextures.back());
+    ++_evictions;
+  }
+}
+
+// Deletes a texture without references and its gl texture
+void TexturePool::Destroy(TextureObject * texture_object)
+{
+  // a request that is still loading finishes without anything to upload to
+  if (texture_object->_request)
+    texture_object->_request->_object = nullptr;
+  if (!texture_object->_file.empty()) {
+    _cache.erase(texture_object->_file);
+    _unusedTextures.erase(texture_object->_unused);
+    _unusedBytes -= texture_object->_bytes;
+  }
+  glDeleteTextures(1, &texture_object->_glID);
+  _residentBytes -= texture_object->_bytes;
+  --_residentTextures;
+  delete texture_object;
+}
+
+/*****************************************************************************/
+/*!
+\brief
+  Estimates the video memory a texture uses from the size and format of each
+  of its mip levels and updates the resident totals. Buffer textures are not
+  counted because their memory belongs to a buffer.
+
+\param texture_object
+  The texture to measure after its images changed.
+*/
+/*****************************************************************************/
+void TexturePool::Measure(TextureObject * texture_object)
+{
+  GLenum target = texture_object->_target;
+  if (target != GL_TEXTURE_2D && target != GL_TEXTURE_CUBE_MAP &&
+    target != GL_TEXTURE_2D_ARRAY)
+    return;
+  GLenum level_target = target;
+  int faces = 1;
+  if (target == GL_TEXTURE_CUBE_MAP) {
+    level_target = GL_TEXTURE_CUBE_MAP_POSITIVE_X;
+    faces = 6;
+  }
+  glActiveTexture(GL_TEXTURE0);
+  glBindTexture(target, texture_object->_glID);
+  // every layer of an array has the size of the first level
+  if (target == GL_TEXTURE_2D_ARRAY)
+    glGetTexLevelParameteriv(target, 0, GL_TEXTURE_DEPTH, &faces);
+  int bytes = 0;
+  for (GLint level = 0; level < 16; ++level) {
+    GLint width = 0, height = 0, format = 0;
+    glGetTexLevelParameteriv(level_target, level, GL_TEXTURE_WIDTH, &width);
+    if (width == 0)
+      break;
+    glGetTexLevelParameteriv(level_target, level, GL_TEXTURE_HEIGHT,
+      &height);
+    GLint compressed = GL_FALSE;
+    glGetTexLevelParameteriv(level_target, level, GL_TEXTURE_COMPRESSED,
+      &compressed);
+    if (compressed) {
+      GLint compressed_size = 0;
+      glGetTexLevelParameteriv(level_target, level,
+        GL_TEXTURE_COMPRESSED_IMAGE_SIZE, &compressed_size);
+      bytes += compressed_size * faces;
+      continue;
+    }
+    glGetTexLevelParameteriv(level_target, level,
+      GL_TEXTURE_INTERNAL_FORMAT, &format);
+    int pixel_bytes;
+    switch (format)
+    {
+    case GL_RGB: case GL_RGB8: pixel_bytes = RGB; break;
+    case GL_RGB16F: pixel_bytes = 6; break;
+    case GL_RGBA16: case GL_RGBA16F: pixel_bytes = 8; break;
+    case GL_RGB32F: pixel_bytes = 12; break;
+    case GL_RGBA32F: pixel_bytes = 16; break;
+    default: pixel_bytes = RGBA; break;
+    }
+    bytes += width * height * pixel_bytes * faces;
+  }
+  glBindTexture(target, 0);
+  _residentBytes += bytes - texture_object->_bytes;
+  if (!texture_object->_file.empty() && texture_object->_references == 0)
+    _unusedBytes += bytes - texture_object->_bytes;
+  texture_object->_bytes = bytes;
+  Evict();
+}
@@ -2,31 +2,172 @@
 #ifndef TEXTUREMANAGER_H
 #define TEXTUREMANAGER_H
 
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
 #include <GL/glew.h>
 #include "Texture.h"
+#include "TextureCompressor.h"
 
 #define MAXBOUNDTEXTURES 16
+// The default number of bytes of decoded image data uploaded each frame
+#define TEXTURE_UPLOAD_BUDGET (8 * 1024 * 1024)
+// The default number of bytes of video memory that textures can use before
+// cached textures that are no longer used are deleted
+#define TEXTURE_MEMORY_BUDGET (256 * 1024 * 1024)
 
 class TexturePool;
+class Framebuffer;
+struct TextureRequest;
 
 class TextureObject {
 private:
-  TextureObject() : _boundLocation(-1) {}
+  TextureObject() : _target(GL_TEXTURE_2D), _boundLocation(-1),
+    _request(nullptr), _references(1), _bytes(0) {}
   GLuint _glID;
+  GLenum _target;
   int _boundLocation;
+  // The load that will replace the placeholder image. Null once it is done.
+  TextureRequest * _request;
+  // The number of Upload and Request calls that returned this object and
+  // have not been matched by an Unload
+  int _references;
+  // The file the texture is cached under. Empty when it is not cached.
+  std::string _file;
+  // The estimated video memory used by all of the texture's images
+  int _bytes;
+  // The position in the list of unused textures when there are no references
+  std::list<TextureObject *>::iterator _unused;
   friend TexturePool;
+  friend Framebuffer;
 };
 
+/*****************************************************************************/
+/*!
+\class TexturePool
+\brief
+  Creates and binds the gl textures used by the renderer. Image files can be
+  loaded synchronously or they can be requested. A requested file is decoded
+  on the ThreadPool and the TextureObject that is returned right away shows a
+  one pixel placeholder until UpdateUploads uploads the decoded image.
+
+\par Important Notes
+  - UpdateUploads must be called once a frame on the main thread. Only
+    _uploadBudget bytes are uploaded each frame so a burst of finished
+    images does not cause a long frame.
+  - Textures loaded from a single file are cached by the file's path, so
+    every Upload or Request for the same file returns the same object. Each
+    of those calls must be matched by an Unload. A cached texture without
+    references is kept until the memory used by all textures goes over
+    _memoryBudget, and the least recently used ones are deleted first.
+  - The pool owns every gl texture it hands out, including the ones given to
+    Upload(GLuint), and deletes them once they are no longer used.
+  - Every mip level is made on the cpu by the MipGenerator so color is
+    filtered in linear space. Requested images are also block compressed
+    when the TextureCompressor is supported. The levels of requested images
+    are cached on disk, so only the first request of a file pays for
+    filtering and compressing it.
+*/
+/*****************************************************************************/
 class TexturePool
 {
 public:
+  // What a requested image is used for, which decides how it is compressed.
+  // Height maps are only read at full size, so they keep every bit and get
+  // no mip levels.
+  enum Usage
+  {
+    COLOR,
+    NORMAL_MAP,
+    HEIGHT_MAP
+  };
   static TextureObject * TexturePool::Upload(const std::string & file);
   static TextureObject * Upload(const Texture & texture);
-  static TextureObject * Upload(GLuint glID);
+  static TextureObject * Upload(GLuint glID, GLenum target = GL_TEXTURE_2D);
+  static TextureObject * UploadCubemap(const Texture * const * faces);
+  static TextureObject * Request(const std::string & file,
+    const Color & placeholder = Color(0.5f, 0.5f, 0.5f),
+    Usage usage = COLOR);
+  static TextureObject * RequestCubemap(const std::string * faces,
+    const int * rotations = nullptr,
+    const Color & placeholder = Color(0.5f, 0.5f, 0.5f));
+  static void UpdateUploads();
+  static void FinishUploads();
+  static bool Loaded(const TextureObject * texture_object);
+  static void Size(const TextureObject * texture_object, int * width,
+    int * height);
+  static int PendingRequests();
   static void Unload(TextureObject * texture_object);
+  static void Purge();
   static bool Bind(TextureObject * texture_object, int location);
   static bool Unbind(TextureObject * texture_object);
   static TextureObject * _boundTextures[MAXBOUNDTEXTURES];
+  // The most bytes of image data that UpdateUploads uploads in a frame.
+  // At least one request is always uploaded so large images still finish.
+  static int _uploadBudget;
+  // The number of requests that have been uploaded. This changes whenever a
+  // placeholder is replaced.
+  static int _completedRequests;
+  // The main thread time UpdateUploads spent uploading during the last frame
+  static float _uploadMilliseconds;
+  // The time from a request being made while no others were pending to the
+  // point where every request was uploaded
+  static float _loadMilliseconds;
+  // The video memory that unused cached textures are kept within
+  static int _memoryBudget;
+  // The estimated video memory used by every texture and by the cached
+  // textures without references
+  static long long _residentBytes;
+  static long long _unusedBytes;
+  static int _residentTextures;
+  // Uploads and requests that found their file in the cache, and the number
+  // of unused textures deleted to stay within the memory budget
+  static int _cacheHits;
+  static int _evictions;
+  // The binds and unbinds made since the last UpdateUploads, and the number
+  // made during the last full frame
+  static int _binds;
+  static int _frameBinds;
+  // The buffers requested images are decoded into. Buffers freed after an
+  // image is compressed are reused by the next image of the same size.
+  static ImageDecoder::BufferPool _imageBuffers;
+private:
+  static std::string CacheName(const std::string & file, Usage usage);
+  static TextureObject * FindCached(const std::string & file);
+  static void Cache(TextureObject * texture_object, const std::string & file);
+  static void Evict();
+  static void Destroy(TextureObject * texture_object);
+  static void Measure(TextureObject * texture_object);
+  static TextureObject * CreatePlaceholder(GLenum target,
+    const Color & placeholder);
+  static bool UploadImage(GLenum target, const Texture & texture,
+    const char * function);
+  static void UploadLevels(GLenum target,
+    const TextureCompressor::Image & image);
+  static void LoadImage(const std::string & file, Usage usage, int rotation,
+    bool compress, TextureCompressor::Image * image);
+  static void QueueRequest(TextureRequest * request);
+  static void Decode(TextureRequest * request);
+  static void CompleteRequest(TextureRequest * request);
+  //! Requests that were decoded and are waiting to be uploaded
+  static std::deque<TextureRequest *> _decoded;
+  //! Guards the decoded requests
+  static std::mutex _decodedMutex;
+  //! Signaled when a request finishes decoding
+  static std::condition_variable _decodedCondition;
+  //! The requests that have not been uploaded yet
+  static int _pendingRequests;
+  //! When the current set of requests started loading
+  static std::chrono::high_resolution_clock::time_point _loadStart;
+  //! The textures loaded from files, keyed by path
+  static std::unordered_map<std::string, TextureObject *> _cache;
+  //! Cached textures without references. The most recently used is first.
+  static std::list<TextureObject *> _unusedTextures;
 };
 
 #endif // !TEXTUREMANAGER_H
\ No newline at end of file
@@ -0,0 +1,620 @@
+/* All content(c) 2017 - 2018 DigiPen(USA) Corporation, all rights reserved. */
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+#include "../../Core/ThreadPool.h"
+#include "../../Utility/Error.h"
+#include "../../Utility/OpenGLError.h"
+#include "FeedbackBuffer.h"
+#include "Texture.h"
+#include "TextureCompressor.h"
+#include "VirtualTexture.h"
+
+// Identifies page files and the layout of their contents
+#define VIRTUALPAGE_MAGIC 0x50545656
+#define VIRTUALPAGE_VERSION 1
+#define VIRTUALPAGE_HEADER_INTS 7
+#define VIRTUALPAGE_BYTES (VIRTUALPAGE_STORED * VIRTUALPAGE_STORED * 4)
+// The most pages that are read on the ThreadPool at once
+#define VIRTUALPAGE_READS 32
+
+// static initializations
+float VirtualTexture::_buildMilliseconds = 0.0f;
+
+VirtualTexture::VirtualTexture() : _residentPages(0), _queuedPages(0),
+  _loadedPages(0), _totalPages(0), _uploads(0), _evictions(0),
+  _uploadsPerFrame(VIRTUALPAGE_UPLOADS), _width(0), _height(0),
+  _cache(nullptr), _indirection(nullptr), _cacheID(0), _indirectionID(0),
+  _cachePages(0), _reading(0), _initialized(false), _opened(false),
+  _openBuildMilliseconds(0.0f), _feedbackFrame(0), _indirectionDirty(false)
+{}
+
+/*****************************************************************************/
+/*!
+\brief
+  Starts opening the page file of an image on the ThreadPool, cutting the
+  image into pages first when there is no page file for it yet. The cache
+  and indirection textures are made by the first Update after that is done.
+  Nothing happens if the texture was already initialized.
+
+\param file
+  The image file.
+\param content
+  What the image contains, which decides how the levels are filtered.
+\param cache_pages
+  The number of pages along each side of the physical cache.
+*/
+/*****************************************************************************/
+void VirtualTexture::Initialize(const std::string & file,
+  MipGenerator::Content content, int cache_pages)
+{
+  if (_initialized)
+    return;
+  _initialized = true;
+  _cachePages = cache_pages;
+  {
+    std::lock_guard<std::mutex> lock(_loadedMutex);
+    ++_reading;
+  }
+  ThreadPool::Submit([this, file, content]() { OpenPages(file, content); });
+}
+
+/*****************************************************************************/
+/*!
+\brief
+  Opens the page file of an image and makes it first when it is missing.
+  Runs on a worker, so errors are kept for the main thread to write.
+
+\param file
+  The image file.
+\param content
+  What the image contains, which decides how the levels are filtered.
+*/
+/*****************************************************************************/
+void VirtualTexture::OpenPages(const std::string & file,
+  MipGenerator::Content content)
+{
+  // everything that changes the pages is part of the key
+  unsigned int variant = (VIRTUALPAGE_VERSION << 16) |
+    ((unsigned int)MipGenerator::_filter << 8) | (unsigned int)content;
+  std::stringstream page_file;
+  page_file << TEXTURECACHE_PATH << std::hex <<
+    TextureCompressor::Key(file, variant) << ".vtp";
+  _pageFile = page_file.str();
+  std::vector<Error> errors;
+  float build_milliseconds = 0.0f;
+  try {
+    if (!Open(_pageFile)) {
+      build_milliseconds = Build(file, content);
+      if (!Open(_pageFile)) {
+        Error error("VirtualTexture.cpp", "OpenPages");
+        error.Add("The page file could not be written or read");
+        error.Add("> Page file");
+        error.Add(_pageFile.c_str());
+        throw(error);
+      }
+    }
+  }
+  catch (const Error & error) {
+    errors.push_back(error);
+  }
+  {
+    std::lock_guard<std::mutex> lock(_loadedMutex);
+    _opened = true;
+    _openErrors = errors;
+    _openBuildMilliseconds = build_milliseconds;
+    --_reading;
+  }
+  _loadedCondition.notify_all();
+}
+
+/*****************************************************************************/
+/*!
+\brief
+  Creates the cache and indirection textures once the page file is open.
+  The coarsest page is read right away so the texture can be sampled before
+  any feedback has been given.
+*/
+/*****************************************************************************/
+void VirtualTexture::CreateTextures()
+{
+  // the physical cache
+  int cache_size = _cachePages * VIRTUALPAGE_STORED;
+  glGenTextures(1, &_cacheID);
+  glBindTexture(GL_TEXTURE_2D, _cacheID);
+  glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, cache_size, cache_size, 0,
+    GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+  // the indirection table has a texel per page and a mip per page level
+  int table_width = 1;
+  int table_height = 1;
+  while (table_width < _levels[0]._pagesX)
+    table_width *= 2;
+  while (table_height < _levels[0]._pagesY)
+    table_height *= 2;
+  int table_levels = (int)_levels.size();
+  glGenTextures(1, &_indirectionID);
+  glBindTexture(GL_TEXTURE_2D, _indirectionID);
+  for (int level = 0; level < table_levels; ++level) {
+    glTexImage2D(GL_TEXTURE_2D, level, GL_RGBA8,
+      std::max(table_width >> level, 1), std::max(table_height >> level, 1),
+      0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+  }
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER,
+    GL_NEAREST_MIPMAP_NEAREST);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, 0);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, table_levels - 1);
+  glBindTexture(GL_TEXTURE_2D, 0);
+  _cache = TexturePool::Upload(_cacheID);
+  _indirection = TexturePool::Upload(_indirectionID);
+  Slot empty_slot;
+  empty_slot._page = -1;
+  empty_slot._lastUsed = 0;
+  _slots.assign(_cachePages * _cachePages, empty_slot);
+  // the coarsest page is never evicted
+  LoadedPage top;
+  top._page = _totalPages - 1;
+  ReadPage(top._page, &top._texels);
+  UploadPage(top);
+  UpdateIndirection();
+  try {
+    GLenum gl_error = glGetError();
+    OPENGLERRORCHECK("VirtualTexture.cpp", "CreateTextures", "During virtual texture creation", gl_error);
+  }
+  catch (const Error & error) {
+    ErrorLog::Write(error);
+  }
+}
+
+/*****************************************************************************/
+/*!
+\brief
+  Waits for the pages being read on the ThreadPool and deletes the cache and
+  indirection textures.
+*/
+/*****************************************************************************/
+void VirtualTexture::Purge()
+{
+  std::unique_lock<std::mutex> lock(_loadedMutex);
+  _loadedCondition.wait(lock, [this]() { return _reading == 0; });
+  _loaded.clear();
+  lock.unlock();
+  if (_cache)
+    TexturePool::Unload(_cache);
+  if (_indirection)
+    TexturePool::Unload(_indirection);
+  _cache = nullptr;
+  _indirection = nullptr;
+  _initialized = false;
+  _opened = false;
+  _openErrors.clear();
+  _levels.clear();
+  _slots.clear();
+  _residentSlots.clear();
+  _pending.clear();
+  _residentPages = 0;
+  _queuedPages = 0;
+  _loadedPages = 0;
+}
+
+/*****************************************************************************/
+/*!
+\brief
+  Finds the pages that a feedback pass saw. The pages that are resident are
+  marked as used so they are not evicted, and the ones that are not are read
+  on the ThreadPool, coarsest first. Coarser pages under a seen page are
+  kept resident too so there is always something close to show.
+
+\param feedback
+  The RGBA values read back from a FeedbackBuffer.
+*/
+/*****************************************************************************/
+void VirtualTexture::RequestPages(const std::vector<unsigned short> & feedback)
+{
+  if (!Ready())
+    return;
+  ++_feedbackFrame;
+  std::unordered_set<int> seen;
+  std::vector<int> requests;
+  int levels = (int)_levels.size();
+  float size_lod = std::log2((float)std::max(_width, _height));
+  for (unsigned int i = 0; i + 3 < feedback.size(); i += 4) {
+    // nothing was drawn here
+    if (feedback[i + 3] == 0)
+      continue;
+    float u = (float)feedback[i] / 65535.0f;
+    float v = (float)feedback[i + 1] / 65535.0f;
+    float footprint_lod =
+      ((float)feedback[i + 2] / 65535.0f - 1.0f) * FEEDBACK_LOD_RANGE;
+    int level = (int)std::floor(footprint_lod + size_lod);
+    level = std::min(std::max(level, 0), levels - 1);
+    const Level & first_level = _levels[level];
+    int x = std::min((int)(u * (float)first_level._width) / VIRTUALPAGE_SIZE,
+      first_level._pagesX - 1);
+    int y = std::min((int)(v * (float)first_level._height) / VIRTUALPAGE_SIZE,
+      first_level._pagesY - 1);
+    for (; level < levels; ++level) {
+      const Level & page_level = _levels[level];
+      x = std::min(x, page_level._pagesX - 1);
+      y = std::min(y, page_level._pagesY - 1);
+      int page = PageIndex(level, x, y);
+      // the coarser pages were handled when this page was first seen
+      if (!seen.insert(page).second)
+        break;
+      std::unordered_map<int, int>::iterator resident =
+        _residentSlots.find(page);
+      if (resident != _residentSlots.end())
+        _slots[resident->second]._lastUsed = _feedbackFrame;
+      else if (_pending.find(page) == _pending.end())
+        requests.push_back(page);
+      x /= 2;
+      y /= 2;
+    }
+  }
+  // coarser levels are further along in the page file
+  std::sort(requests.begin(), requests.end(), std::greater<int>());
+  std::lock_guard<std::mutex> lock(_loadedMutex);
+  for (int page : requests) {
+    if (_reading >= VIRTUALPAGE_READS)
+      break;
+    _pending.insert(page);
+    ++_reading;
+    ThreadPool::Submit([this, page]() { LoadPage(page); });
+  }
+  _queuedPages = _reading;
+}
+
+/*****************************************************************************/
+/*!
+\brief
+  Creates the textures once the page file is open. After that, uploads
+  pages that finished reading into the cache and updates the indirection
+  texture. Only _uploadsPerFrame pages are uploaded in a call.
+*/
+/*****************************************************************************/
+void VirtualTexture::Update()
+{
+  if (!Ready()) {
+    std::vector<Error> errors;
+    {
+      std::lock_guard<std::mutex> lock(_loadedMutex);
+      if (!_opened)
+        return;
+      _opened = false;
+      errors.swap(_openErrors);
+      _buildMilliseconds += _openBuildMilliseconds;
+    }
+    for (const Error & error : errors)
+      ErrorLog::Write(error);
+    // a failed texture can be initialized again
+    if (!errors.empty()) {
+      _levels.clear();
+      _initialized = false;
+      return;
+    }
+    CreateTextures();
+    return;
+  }
+  std::deque<LoadedPage> uploads;
+  {
+    std::lock_guard<std::mutex> lock(_loadedMutex);
+    while (!_loaded.empty() && (int)uploads.size() < _uploadsPerFrame) {
+      uploads.push_back(std::move(_loaded.front()));
+      _loaded.pop_front();
+    }
+    _loadedPages = (int)_loaded.size();
+    _queuedPages = _reading;
+  }
+  for (const LoadedPage & loaded : uploads) {
+    _pending.erase(loaded._page);
+    if (!loaded._texels.empty())
+      UploadPage(loaded);
+  }
+  if (_indirectionDirty)
+    UpdateIndirection();
+}
+
+void VirtualTexture::Bind(int location)
+{
+  TexturePool::Bind(_cache, location);
+  TexturePool::Bind(_indirection, location + 1);
+}
+
+void VirtualTexture::Unbind()
+{
+  TexturePool::Unbind(_cache);
+  TexturePool::Unbind(_indirection);
+}
+
+/*****************************************************************************/
+/*!
+\brief
+  Sets the members of a VirtualTexture struct uniform in virtual.glsl. The
+  shader must be in use.
+
+\param shader
+  The shader the uniforms are set on.
+\param name
+  The name of the struct uniform.
+\param location
+  The texture unit the cache is bound to. The indirection texture is bound
+  to the unit after it.
+*/
+/*****************************************************************************/
+void VirtualTexture::SetUniforms(Shader * shader, const std::string & name,
+  int location)
+{
+  shader->SetUniform1i((name + ".UCache").c_str(), location);
+  shader->SetUniform1i((name + ".UIndirection").c_str(), location + 1);
+  shader->SetUniform2f((name + ".USize").c_str(), (float)_width,
+    (float)_height);
+  shader->SetUniform1f((name + ".ULevels").c_str(), (float)_levels.size());
+  shader->SetUniform1f((name + ".UCachePages").c_str(), (float)_cachePages);
+}
+
+bool VirtualTexture::Ready() const
+{
+  return _cache != nullptr;
+}
+
+// True from Initialize until the texture is ready or its page file failed
+bool VirtualTexture::Loading() const
+{
+  return _initialized && !Ready();
+}
+
+// The video memory used by the cache and indirection textures
+long long VirtualTexture::CacheBytes() const
+{
+  if (!Ready())
+    return 0;
+  long long cache_size = (long long)_cachePages * VIRTUALPAGE_STORED;
+  long long bytes = cache_size * cache_size * 4;
+  for (const Level & level : _levels)
+    bytes += (long long)level._pagesX * level._pagesY * 4;
+  return bytes;
+}
+
+// Reads the header of a page file and creates the levels it describes.
+// Returns false when the file is missing or does not match this version.
+bool VirtualTexture::Open(const std::string & page_file)
+{
+  std::ifstream stream(page_file.c_str(), std::ios::binary);
+  if (!stream.is_open())
+    return false;
+  int header[VIRTUALPAGE_HEADER_INTS];
+  stream.read((char *)header, sizeof(header));
+  if (!stream || header[0] != VIRTUALPAGE_MAGIC ||
+    header[1] != VIRTUALPAGE_VERSION || header[5] != VIRTUALPAGE_SIZE ||
+    header[6] != VIRTUALPAGE_BORDER)
+    return false;
+  CreateLevels(header[2], header[3]);
+  if ((int)_levels.size() != header[4])
+    return false;
+  stream.seekg(0, std::ios::end);
+  long long expected = sizeof(header) + (long long)_totalPages *
+    VIRTUALPAGE_BYTES;
+  return (long long)stream.tellg() == expected;
+}
+
+// Creates the page levels of an image. Levels halve like mip levels until
+// the level fits in a single page.
+void VirtualTexture::CreateLevels(int width, int height)
+{
+  _width = width;
+  _height = height;
+  _levels.clear();
+  _totalPages = 0;
+  while (true) {
+    Level level;
+    level._width = std::max(width >> _levels.size(), 1);
+    level._height = std::max(height >> _levels.size(), 1);
+    level._pagesX = (level._width + VIRTUALPAGE_SIZE - 1) / VIRTUALPAGE_SIZE;
+    level._pagesY = (level._height + VIRTUALPAGE_SIZE - 1) / VIRTUALPAGE_SIZE;
+    level._firstPage = _totalPages;
+    level._entries.resize(level._pagesX * level._pagesY);
+    _totalPages += level._pagesX * level._pagesY;
+    _levels.push_back(level);
+    if (level._pagesX == 1 && level._pagesY == 1)
+      break;
+  }
+}
+
+/*****************************************************************************/
+/*!
+\brief
+  Creates the mip levels of an image and writes every level to the page file
+  as pages. Each page has a border of texels copied from its neighbours, and
+  texels past the edges of a level repeat the edge texel.
+
+\param file
+  The image file.
+\param content
+  What the image contains, which decides how the levels are filtered.
+
+\return The time it took in milliseconds.
+*/
+/*****************************************************************************/
+float VirtualTexture::Build(const std::string & file,
+  MipGenerator::Content content)
+{
+  std::chrono::high_resolution_clock::time_point start =
+    std::chrono::high_resolution_clock::now();
+  Texture texture(file);
+  int width = texture.Width();
+  int height = texture.Height();
+  int channels = texture.Channels();
+  const unsigned char * image_data = texture.ImageData();
+  // pages are always RGBA
+  std::vector<unsigned char> pixels(width * height * 4);
+  for (int p = 0; p < width * height; ++p) {
+    const unsigned char * in = image_data + p * channels;
+    unsigned char * out = pixels.data() + p * 4;
+    for (int c = 0; c < 3; ++c)
+      out[c] = in[std::min(c, channels - 1)];
+    out[3] = channels == 4 ? in[3] : 255;
+  }
+  CreateLevels(width, height);
+  std::vector<std::vector<unsigned char> > mips;
+  MipGenerator::Generate(pixels.data(), width, height, 4, content, &mips);
+  std::ofstream stream(_pageFile.c_str(), std::ios::binary);
+  if (!stream.is_open())
+    return 0.0f;
+  int header[VIRTUALPAGE_HEADER_INTS] = { VIRTUALPAGE_MAGIC,
+    VIRTUALPAGE_VERSION, width, height, (int)_levels.size(),
+    VIRTUALPAGE_SIZE, VIRTUALPAGE_BORDER };
+  stream.write((const char *)header, sizeof(header));
+  std::vector<unsigned char> page(VIRTUALPAGE_BYTES);
+  for (unsigned int l = 0; l < _levels.size(); ++l) {
+    const Level & level = _levels[l];
+    const unsigned char * level_data = mips[l].data();
+    for (int page_y = 0; page_y < level._pagesY; ++page_y) {
+      for (int page_x = 0; page_x < level._pagesX; ++page_x) {
+        for (int y = 0; y < VIRTUALPAGE_STORED; ++y) {
+          int source_y = page_y * VIRTUALPAGE_SIZE - VIRTUALPAGE_BORDER + y;
+          source_y = std::min(std::max(source_y, 0), level._height - 1);
+          unsigned char * row = page.data() + y * VIRTUALPAGE_STORED * 4;
+          for (int x = 0; x < VIRTUALPAGE_STORED; ++x) {
+            int source_x = page_x * VIRTUALPAGE_SIZE - VIRTUALPAGE_BORDER + x;
+            source_x = std::min(std::max(source_x, 0), level._width - 1);
+            std::memcpy(row + x * 4,
+              level_data + (source_y * level._width + source_x) * 4, 4);
+          }
+        }
+        stream.write((const char *)page.data(), page.size());
+      }
+    }
+  }
+  std::chrono::duration<float, std::milli> time =
+    std::chrono::high_resolution_clock::now() - start;
+  return time.count();
+}
+
+// Reads the texels of a page from the page file. This is called by the
+// ThreadPool workers, so it only reads members that do not change.
+bool VirtualTexture::ReadPage(int page, std::vector<unsigned char> * texels)
+  const
+{
+  std::ifstream stream(_pageFile.c_str(), std::ios::binary);
+  if (!stream.is_open())
+    return false;
+  long long offset = VIRTUALPAGE_HEADER_INTS * sizeof(int) +
+    (long long)page * VIRTUALPAGE_BYTES;
+  stream.seekg(offset);
+  texels->resize(VIRTUALPAGE_BYTES);
+  stream.read((char *)texels->data(), VIRTUALPAGE_BYTES);
+  if (!stream) {
+    texels->clear();
+    return false;
+  }
+  return true;
+}
+
+// Reads a page on a ThreadPool worker and queues it for uploading. A page
+// that could not be read is queued without texels so it stops being pending.
+void VirtualTexture::LoadPage(int page)
+{
+  LoadedPage loaded;
+  loaded._page = page;
+  ReadPage(page, &loaded._texels);
+  {
+    std::lock_guard<std::mutex> lock(_loadedMutex);
+    _loaded.push_back(std::move(loaded));
+    --_reading;
+  }
+  _loadedCondition.notify_all();
+}
+
+// Copies a page into an empty cache slot, or into the least recently used
+// slot that the latest feedback did not see. When every slot was seen the
+// page is dropped and will be requested again by later feedback.
+void VirtualTexture::UploadPage(const LoadedPage & loaded)
+{
+  int top_page = _totalPages - 1;
+  int slot_index = -1;
+  for (unsigned int i = 0; i < _slots.size(); ++i) {
+    const Slot & slot = _slots[i];
+    if (slot._page == -1) {
+      slot_index = i;
+      break;
+    }
+    if (slot._page == top_page || slot._lastUsed >= _feedbackFrame)
+      continue;
+    if (slot_index == -1 || slot._lastUsed < _slots[slot_index]._lastUsed)
+      slot_index = i;
+  }
+  if (slot_index == -1)
+    return;
+  Slot & slot = _slots[slot_index];
+  if (slot._page != -1) {
+    _residentSlots.erase(slot._page);
+    ++_evictions;
+  }
+  int slot_x = slot_index % _cachePages;
+  int slot_y = slot_index / _cachePages;
+  glBindTexture(GL_TEXTURE_2D, _cacheID);
+  glTexSubImage2D(GL_TEXTURE_2D, 0, slot_x * VIRTUALPAGE_STORED,
+    slot_y * VIRTUALPAGE_STORED, VIRTUALPAGE_STORED, VIRTUALPAGE_STORED,
+    GL_RGBA, GL_UNSIGNED_BYTE, loaded._texels.data());
+  glBindTexture(GL_TEXTURE_2D, 0);
+  slot._page = loaded._page;
+  slot._lastUsed = _feedbackFrame;
+  _residentSlots[loaded._page] = slot_index;
+  _residentPages = (int)_residentSlots.size();
+  ++_uploads;
+  _indirectionDirty = true;
+}
+
+// Rebuilds every level of the indirection texture from the coarsest level
+// down. A page that is not resident uses the entry of the page above it.
+void VirtualTexture::UpdateIndirection()
+{
+  glBindTexture(GL_TEXTURE_2D, _indirectionID);
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+  for (int l = (int)_levels.size() - 1; l >= 0; --l) {
+    Level & level = _levels[l];
+    for (int y = 0; y < level._pagesY; ++y) {
+      for (int x = 0; x < level._pagesX; ++x) {
+        unsigned int & entry = level._entries[y * level._pagesX + x];
+        std::unordered_map<int, int>::iterator resident =
+          _residentSlots.find(PageIndex(l, x, y));
+        if (resident != _residentSlots.end()) {
+          // r and g are the slot, b is the level the slot holds
+          unsigned int slot_x = resident->second % _cachePages;
+          unsigned int slot_y = resident->second / _cachePages;
+          entry = slot_x | slot_y << 8 | (unsigned int)l << 16 | 0xffu << 24;
+        }
+        else if (l + 1 < (int)_levels.size()) {
+          const Level & parent = _levels[l + 1];
+          int parent_x = std::min(x / 2, parent._pagesX - 1);
+          int parent_y = std::min(y / 2, parent._pagesY - 1);
+          entry = parent._entries[parent_y * parent._pagesX + parent_x];
+        }
+        else {
+          entry = 0;
+        }
+      }
+    }
+    glTexSubImage2D(GL_TEXTURE_2D, l, 0, 0, level._pagesX, level._pagesY,
+      GL_RGBA, GL_UNSIGNED_BYTE, level._entries.data());
+  }
+  glBindTexture(GL_TEXTURE_2D, 0);
+  _indirectionDirty = false;
+}
+
+int VirtualTexture::PageIndex(int level, int x, int y) const
+{
+  const Level & page_level = _levels[level];
+  return page_level._firstPage + y * page_level._pagesX + x;
+}
@@ -0,0 +1,155 @@
+/* All content(c) 2017 - 2018 DigiPen(USA) Corporation, all rights reserved. */
+#ifndef VIRTUALTEXTURE_H
+#define VIRTUALTEXTURE_H
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include <GL/glew.h>
+#include "../../Utility/Error.h"
+#include "../Shader/Shader.h"
+#include "MipGenerator.h"
+#include "TexturePool.h"
+
+// The texels along a side of a page and the texels copied from neighbouring
+// pages around each side so bilinear filtering works across page edges. The
+// shaders in virtual.glsl use the same values.
+#define VIRTUALPAGE_SIZE 128
+#define VIRTUALPAGE_BORDER 4
+#define VIRTUALPAGE_STORED (VIRTUALPAGE_SIZE + 2 * VIRTUALPAGE_BORDER)
+// The default number of pages along each side of the physical cache
+#define VIRTUALCACHE_PAGES 16
+// The default number of pages uploaded to the cache each frame
+#define VIRTUALPAGE_UPLOADS 8
+
+/*****************************************************************************/
+/*!
+\class VirtualTexture
+\brief
+  An image that is split into pages and only keeps the pages that are seen
+  in video memory. Every mip level of the image is cut into pages once and
+  saved as a page file in the texture cache. The page file is opened, and
+  made when it does not exist, on the ThreadPool. Pages are read from the page
+  file on the ThreadPool when the feedback pass asks for them and are
+  uploaded into a fixed size physical cache texture. An indirection texture
+  tells the shader where each page is, or where the closest coarser page is
+  when a page is not resident.
+
+\par Important Notes
+  - The video memory used does not depend on the size of the image. It is
+    the cache texture plus an indirection table with a texel per page.
+  - The single page of the coarsest level is always resident so every
+    lookup finds something to show.
+  - Update must be called once a frame on the main thread after the pages
+    that were seen are given to RequestPages. The texture becomes ready
+    during the first Update after its page file was opened.
+*/
+/*****************************************************************************/
+class VirtualTexture
+{
+public:
+  VirtualTexture();
+  void Initialize(const std::string & file, MipGenerator::Content content,
+    int cache_pages = VIRTUALCACHE_PAGES);
+  void Purge();
+  void RequestPages(const std::vector<unsigned short> & feedback);
+  void Update();
+  void Bind(int location);
+  void Unbind();
+  void SetUniforms(Shader * shader, const std::string & name, int location);
+  bool Ready() const;
+  bool Loading() const;
+  long long CacheBytes() const;
+  // The pages that are resident, waiting to be read, and read but not yet
+  // uploaded, and the total number of pages the image has
+  int _residentPages;
+  int _queuedPages;
+  int _loadedPages;
+  int _totalPages;
+  // The number of pages uploaded and evicted since the texture was made
+  int _uploads;
+  int _evictions;
+  // The most pages uploaded in a single Update
+  int _uploadsPerFrame;
+  // The time workers spent cutting images into pages when no page file
+  // existed
+  static float _buildMilliseconds;
+private:
+  struct Level
+  {
+    int _width;
+    int _height;
+    int _pagesX;
+    int _pagesY;
+    // The index of the first page of the level in the page file
+    int _firstPage;
+    // The indirection entry of every page
+    std::vector<unsigned int> _entries;
+  };
+  struct Slot
+  {
+    // The page held by the slot or -1 when it is empty
+    int _page;
+    // The last feedback that saw the page
+    unsigned int _lastUsed;
+  };
+  struct LoadedPage
+  {
+    int _page;
+    std::vector<unsigned char> _texels;
+  };
+  void OpenPages(const std::string & file, MipGenerator::Content content);
+  void CreateTextures();
+  bool Open(const std::string & page_file);
+  void CreateLevels(int width, int height);
+  float Build(const std::string & file, MipGenerator::Content content);
+  bool ReadPage(int page, std::vector<unsigned char> * texels) const;
+  void LoadPage(int page);
+  void UploadPage(const LoadedPage & loaded);
+  void UpdateIndirection();
+  int PageIndex(int level, int x, int y) const;
+  //! The file the pages are read from
+  std::string _pageFile;
+  //! The size of the full resolution image
+  int _width;
+  int _height;
+  //! The page levels. The last level is a single page.
+  std::vector<Level> _levels;
+  //! The physical cache and the page table
+  TextureObject * _cache;
+  TextureObject * _indirection;
+  GLuint _cacheID;
+  GLuint _indirectionID;
+  int _cachePages;
+  //! Where each page is resident, keyed by page index
+  std::unordered_map<int, int> _residentSlots;
+  std::vector<Slot> _slots;
+  //! Pages that are requested or being read, so they are not asked for twice
+  std::unordered_set<int> _pending;
+  //! Pages read by workers waiting to be uploaded
+  std::deque<LoadedPage> _loaded;
+  //! Guards the loaded pages and the pages still being read
+  std::mutex _loadedMutex;
+  //! Signaled when a worker finishes reading a page
+  std::condition_variable _loadedCondition;
+  //! Pages that are being read on the ThreadPool, and the page file while
+  //! it is being opened
+  int _reading;
+  //! Set by Initialize and cleared when the page file could not be opened
+  bool _initialized;
+  //! Set by the worker once it is done with the page file, along with the
+  //! errors it found and the time it spent making the page file
+  bool _opened;
+  std::vector<Error> _openErrors;
+  float _openBuildMilliseconds;
+  //! Counts the feedback that has been given to RequestPages
+  unsigned int _feedbackFrame;
+  //! When true, the indirection texture does not match the resident pages
+  bool _indirectionDirty;
+};
+
+#endif // !VIRTUALTEXTURE_H
@@ -0,0 +1,50 @@
+/* All content(c) 2017 - 2018 DigiPen(USA) Corporation, all rights reserved. */
+#include "VertexFormat.h"
+
+// static initializations
+const VertexFormat VertexFormat::_mesh({
+  { ATTRIB_POSITION, 3, 0 },
+  { ATTRIB_NORMAL, 3, 3 },
+  { ATTRIB_TANGENT, 3, 6 },
+  { ATTRIB_BITANGENT, 3, 9 },
+  { ATTRIB_UV, 2, 12 } }, 14);
+const VertexFormat VertexFormat::_line({
+  { ATTRIB_POSITION, 3, 0 } }, 3);
+// The model matrix is row major and each row is read in as a column
+const VertexFormat VertexFormat::_instance({
+  { ATTRIB_INSTANCE_MODEL, 4, 0 },
+  { ATTRIB_INSTANCE_MODEL + 1, 4, 4 },
+  { ATTRIB_INSTANCE_MODEL + 2, 4, 8 },
+  { ATTRIB_INSTANCE_MODEL + 3, 4, 12 },
+  { ATTRIB_INSTANCE_COLOR, 3, 16 } }, 19, 1);
+
+VertexFormat::VertexFormat(std::initializer_list<Attribute> attributes,
+  unsigned int stride, GLuint divisor) :
+  _attributes(attributes), _stride(stride), _divisor(divisor)
+{}
+
+/*****************************************************************************/
+/*!
+\brief
+  Sets up the attributes of the bound vertex array to read from the buffer
+  bound to GL_ARRAY_BUFFER.
+*/
+/*****************************************************************************/
+void VertexFormat::Enable() const
+{
+  GLsizei stride = _stride * sizeof(GLfloat);
+  for (const Attribute & attribute : _attributes) {
+    glVertexAttribPointer(attribute._location, attribute._components,
+      GL_FLOAT, GL_FALSE, stride,
+      (void *)(attribute._offset * sizeof(GLfloat)));
+    glEnableVertexAttribArray(attribute._location);
+    if (_divisor)
+      glVertexAttribDivisor(attribute._location, _divisor);
+  }
+}
+
+void VertexFormat::Disable() const
+{
+  for (const Attribute & attribute : _attributes)
+    glDisableVertexAttribArray(attribute._location);
+}
@@ -0,0 +1,58 @@
+/* All content(c) 2017 - 2018 DigiPen(USA) Corporation, all rights reserved. */
+#ifndef VERTEXFORMAT_H
+#define VERTEXFORMAT_H
+
+#include <initializer_list>
+#include <vector>
+#include <GL/glew.h>
+
+// The attribute locations used by every vertex shader. A shader declares its
+// inputs with layout(location = N) using these numbers, so any shader can
+// read any vertex array that provides the inputs it needs.
+#define ATTRIB_POSITION 0
+#define ATTRIB_NORMAL 1
+#define ATTRIB_TANGENT 2
+#define ATTRIB_BITANGENT 3
+#define ATTRIB_UV 4
+// The instance model matrix takes up four locations, one for each row
+#define ATTRIB_INSTANCE_MODEL 5
+#define ATTRIB_INSTANCE_COLOR 9
+
+/*****************************************************************************/
+/*!
+\class VertexFormat
+\brief
+  Describes how the attributes of a vertex buffer are laid out. A vertex
+  array is set up from a format once when its buffers are uploaded and it
+  does not depend on the shaders that will draw it.
+*/
+/*****************************************************************************/
+class VertexFormat
+{
+public:
+  struct Attribute
+  {
+    GLuint _location;
+    GLint _components;
+    // The offset from the start of a vertex in floats
+    unsigned int _offset;
+  };
+  VertexFormat(std::initializer_list<Attribute> attributes,
+    unsigned int stride, GLuint divisor = 0);
+  void Enable() const;
+  void Disable() const;
+  // The layout of Mesh::Vertex
+  static const VertexFormat _mesh;
+  // A position for each line end point
+  static const VertexFormat _line;
+  // The layout of MeshRenderer::Instance
+  static const VertexFormat _instance;
+private:
+  std::vector<Attribute> _attributes;
+  // The size of a vertex in floats
+  unsigned int _stride;
+  // Zero for vertex data and one for instance data
+  GLuint _divisor;
+};
+
+#endif // !VERTEXFORMAT_H
@@ -833,6 +833,54 @@ namespace Math
     return matrix.m00 + matrix.m11 + matrix.m22 + matrix.m33;
   }
 
+  void ExtractFrustumPlanes(Mat4Param matrix, Vector4 planes[6])
+  {
+    // each plane is the last row plus or minus one of the other rows
+    for (unsigned i = 0; i < 3; ++i)
+    {
+      for (unsigned c = 0; c < 4; ++c)
+      {
+        planes[i * 2][c] = matrix(3, c) + matrix(i, c);
+        planes[i * 2 + 1][c] = matrix(3, c) - matrix(i, c);
+      }
+    }
+    for (unsigned i = 0; i < 6; ++i)
+    {
+      Vector4 & plane = planes[i];
+      float length = Sqrt(plane.x * plane.x + plane.y * plane.y +
+        plane.z * plane.z);
+      plane /= length;
+    }
+  }
+
+  bool SphereInFrustum(const Vector4 planes[6], Vec3Param center, float radius)
+  {
+    for (unsigned i = 0; i < 6; ++i)
+    {
+      const Vector4 & plane = planes[i];
+      float distance = plane.x * center.x + plane.y * center.y +
+        plane.z * center.z + plane.w;
+      if (distance < -radius)
+        return false;
+    }
+    return true;
+  }
+
+  bool AabbInFrustum(const Vector4 planes[6], Vec3Param min, Vec3Param max)
+  {
+    for (unsigned i = 0; i < 6; ++i)
+    {
+      // only the corner farthest along the plane normal needs to be tested
+      const Vector4 & plane = planes[i];
+      float x = plane.x > 0.0f ? max.x : min.x;
+      float y = plane.y > 0.0f ? max.y : min.y;
+      float z = plane.z > 0.0f ? max.z : min.z;
+      if (plane.x * x + plane.y * y + plane.z * z + plane.w < 0.0f)
+        return false;
+    }
+    return true;
+  }
+
   Matrix4 Matrix4::Perspective(float fov, float aspect, float near_d, float far_d)
   {
     Matrix4 p_proj;
@@ -247,4 +247,16 @@ Vector3 TransformPointProjectedCol(Mat4Param matrix, Vec3Param point, float* w);
 
 float Trace(Mat4Param matrix);
 
+///Extracts the planes of the frustum described by a projection * view matrix.
+///Each plane is (a, b, c, d) with a unit normal that points into the frustum,
+///so points inside have a*x + b*y + c*z + d >= 0. The planes are ordered
+///left, right, bottom, top, near, far.
+void ExtractFrustumPlanes(Mat4Param matrix, Vector4 planes[6]);
+
+///Returns false when the sphere is entirely behind one of the frustum planes.
+bool SphereInFrustum(const Vector4 planes[6], Vec3Param center, float radius);
+
+///Returns false when the box is entirely behind one of the frustum planes.
+bool AabbInFrustum(const Vector4 planes[6], Vec3Param min, Vec3Param max);
+
 }// namespace Math
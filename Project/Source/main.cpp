@@ -17,14 +17,17 @@
 #include "Graphics\Light.h"
 #include "Graphics\Material.h"
 #include "Graphics\Renderer.h"
+#include "Graphics\RenderTargetPool.h"
 #include "Graphics\Skybox.h"
 #include "Graphics\Texture\TexturePool.h"
+#include "Graphics\Texture\TextureCompressor.h"
 
 #include <GL\glew.h>
 #include "Utility\OpenGLError.h"
 
 #include "Graphics\OpenGLContext.h"
 #include "Core\Time.h"
+#include "Core\ThreadPool.h"
 #include "Math\Matrix4.h"
 #include "Math\Vector3.h"
 #include "Math\EulerAngles.h"
@@ -34,6 +37,7 @@
 #include "Graphics\Mesh\MeshRenderer.h"
 #include "Graphics\Shader\ShaderLibrary.h"
 #include "Graphics\Shader\ShaderManager.h"
+#include "Graphics\Shader\ShaderCache.h"
 #include "Graphics\Camera.h"
 
 #include "Core\Input.h"
@@ -108,8 +112,11 @@ inline void InitialUpdate()
 int main(int argc, char * argv[])
 {
   ErrorLog::Clean();
+  ThreadPool::Initialize();
   SDLContext::Create("CS 300 - Assignment 4", true, OpenGLContext::AdjustViewport);
   OpenGLContext::Initialize();
+  ShaderCache::Initialize();
+  TextureCompressor::Initialize();
   ShaderManager::Initialize();
   MeshRenderer::Initialize();
   Editor::Initialize();
@@ -120,21 +127,21 @@ int main(int argc, char * argv[])
 
   camera.MoveBack(2.0f);
 
-  // loading normal map from specular bump map
-  Texture bump_map("Resource/Texture/specular.tga");
-  bump_map.CreateNormalMap("Resource/Texture/normal_map.png", 2.0f / 255.0f);
-
   // starting main program
   glEnable(GL_DEPTH_TEST);
+  glEnable(GL_TEXTURE_CUBE_MAP_SEAMLESS);
   Framer::Lock(FPS);
   while (SDLContext::KeepOpen())
   {
     // frame start
     Framer::Start();
+    MeshRenderer::UpdateReloads();
+    TexturePool::UpdateUploads();
     InitialUpdate();
     Editor::Update(mesh, Renderer::_meshObject, LoadMesh);
     Update();
     Draw();
+    RenderTargetPool::Update();
     Editor::Render();
     OpenGLContext::Swap();
     // frame end
@@ -143,10 +150,13 @@ int main(int argc, char * argv[])
 
   Mesh::Purge(mesh);
   Renderer::Purge();
+  RenderTargetPool::Purge();
+  TexturePool::Purge();
   MeshRenderer::Purge();
   ShaderManager::Purge();
   OpenGLContext::Purge();
   SDLContext::Purge();
+  ThreadPool::Purge();
 }
 
 //--------------------// Other //--------------------//
@@ -1,111 +1,41 @@
 /* All content(c) 2017 DigiPen(USA) Corporation, all rights reserved. */
 #version 330 core
 
-#define POINT 0
-#define DIRECTIONAL 1
-#define SPOT 2
+#include "material.glsl"
+#include "cluster.glsl"
+#include "fog.glsl"
 
 in vec3 SNormal;
 in vec3 SFragPos;
+in float SViewDepth;
 
 out vec4 OFragColor;
 
 // The cameras world position
 uniform vec3 UCameraPosition;
 
-// Material values
-struct Material
-{
-  vec3 UColor;
-  // Material factors
-  float UAmbientFactor;
-  float UDiffuseFactor;
-  float USpecularFactor;
-  float USpecularExponent;
-};
-
-// Light values
-struct Light
-{
-  // The type of the type: 0 - Point, 1 - Directional, 2 - Spot
-  int UType;
-  // The position of the light
-  vec3 UPosition;
-  // The direction of the light
-  vec3 UDirection;
-  // The inner and outer angles for a spotlight
-  float UInnerAngle;
-  float UOuterAngle;
-  float USpotExponent;
-  // The light colors
-  vec3 UAmbientColor;
-  vec3 UDiffuseColor;
-  vec3 USpecularColor;
-  // Attenuation coefficients
-  float UAttenuationC0;
-  float UAttenuationC1;
-  float UAttenuationC2;
-};
-
-const int MaxLights = 10;
-uniform int UActiveLights = 1;
-uniform Material UMaterial;
-uniform Light ULights[MaxLights];
-
-uniform vec3 UFogColor;
-uniform float UNearPlane;
-uniform float UFarPlane;
-
 uniform vec3 UEmissiveColor;
 uniform vec3 UGlobalAmbientColor;
 
-vec3 ComputeLight(int light, vec3 normal, vec3 view_dir)
+vec3 ComputeLight(Light light, vec3 normal, vec3 view_dir)
 {
   // ambient term
-  vec3 ambient_color = UMaterial.UAmbientFactor * ULights[light].UAmbientColor;
+  vec3 ambient_color = UMaterial.UAmbientFactor * light.UAmbientColor;
   // finding light direction
-  vec3 light_vec;
-  vec3 light_dir;
-  if(ULights[light].UType == DIRECTIONAL)
-    light_vec = -normalize(ULights[light].UDirection);
-  else
-    light_vec = ULights[light].UPosition - SFragPos;
-  light_dir = normalize(light_vec);
+  vec3 light_vec = LightVector(light, SFragPos);
+  vec3 light_dir = normalize(light_vec);
   // diffuse term
   float ndotl = max(dot(normal, light_dir), 0.0);
-  vec3 diffuse_color = UMaterial.UDiffuseFactor * ndotl * ULights[light].UDiffuseColor;
+  vec3 diffuse_color = UMaterial.UDiffuseFactor * ndotl * light.UDiffuseColor;
   // specular term
   vec3 half_dir = light_dir + view_dir;
   half_dir = normalize(half_dir);
   float ndoth = max(dot(normal, half_dir), 0.0);
   float specular_spread = pow(ndoth, UMaterial.USpecularExponent);
-  vec3 specular_color = UMaterial.USpecularFactor * ULights[light].USpecularColor * specular_spread;
-  // find spotlight effect
-  float spotlight_factor;
-  if(ULights[light].UType == SPOT){
-    float cos_inner = cos(ULights[light].UInnerAngle);
-    float cos_outer = cos(ULights[light].UOuterAngle);
-    vec3 spot_dir = -normalize(ULights[light].UDirection);
-    float ldots = dot(light_dir, spot_dir);
-    spotlight_factor = (ldots - cos_outer) / (cos_inner - cos_outer);
-    spotlight_factor = pow(spotlight_factor, ULights[light].USpotExponent);
-    spotlight_factor = max(0.0, spotlight_factor);
-    spotlight_factor = min(1.0, spotlight_factor);
-  }
-  else{
-    spotlight_factor = 1.0f;
-  }
-  // find attenuation
-  float attenuation;
-  if(ULights[light].UType == DIRECTIONAL)
-    attenuation = 1.0;
-  else{
-    float light_dist = length(light_vec);
-    attenuation = ULights[light].UAttenuationC0 +
-      ULights[light].UAttenuationC1 * light_dist +
-      ULights[light].UAttenuationC2 * light_dist * light_dist;
-    attenuation = min(1.0 / attenuation, 1.0);
-  }
+  vec3 specular_color = UMaterial.USpecularFactor * light.USpecularColor * specular_spread;
+  // spotlight and attenuation
+  float spotlight_factor = SpotlightFactor(light, light_dir);
+  float attenuation = Attenuation(light, light_vec);
   // final color
   vec3 spot_color = spotlight_factor * (diffuse_color + specular_color);
   vec3 light_color = (ambient_color + spot_color);
@@ -121,18 +51,19 @@ void main()
   vec3 view_dir = normalize(view_vec);
   // summing all light results
   vec3 final_color = vec3(0.0, 0.0, 0.0);
-  for (int i = 0; i < UActiveLights; ++i)
-    final_color += ComputeLight(i, normal, view_dir);
+  // only the lights that reach this fragment's cluster are evaluated
+  uvec2 cluster = texelFetch(UClusterGrid, FindCluster(SViewDepth)).xy;
+  for (uint i = 0u; i < cluster.y; ++i){
+    int light = int(texelFetch(ULightIndices, int(cluster.x + i)).x);
+    final_color += ComputeLight(FetchLight(light), normal, view_dir);
+  }
   // accounting for object color
   final_color *= UMaterial.UColor;
   // accounting for emissive and global ambient
   final_color += UMaterial.UAmbientFactor * UGlobalAmbientColor;
   final_color += UEmissiveColor;
   // accounting for fog
-  float dist = length(view_vec);
-  float fog_factor = (dist - UNearPlane) / (UFarPlane - UNearPlane);
-  fog_factor = min(1.0, max(0.0, fog_factor));
-  final_color = mix(final_color, UFogColor, fog_factor);
+  final_color = ApplyFog(final_color, length(view_vec));
   // final color
   OFragColor = vec4(final_color, 1.0);
 }
@@ -1,11 +1,13 @@
 /* All content(c) 2017 DigiPen(USA) Corporation, all rights reserved. */
 #version 330 core
 
-in vec3 APosition;
-in vec3 ANormal;
+// The locations match the ATTRIB defines in VertexFormat.h
+layout(location = 0) in vec3 APosition;
+layout(location = 1) in vec3 ANormal;
 
 out vec3 SNormal;
 out vec3 SFragPos;
+out float SViewDepth;
 
 uniform mat4 UProjection = mat4(1,0,0,0,
                                 0,1,0,0,
@@ -27,4 +29,5 @@ void main()
   gl_Position = UProjection * UView * UModel * vec4(APosition.xyz, 1.0);
   SNormal = mat3(transpose(inverse(UModel))) * ANormal;
   SFragPos = vec3(UModel * vec4(APosition, 1.0));
+  SViewDepth = -(UView * vec4(SFragPos, 1.0)).z;
 }
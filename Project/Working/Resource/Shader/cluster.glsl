@@ -0,0 +1,53 @@
+/* All content(c) 2017 - 2018 DigiPen(USA) Corporation, all rights reserved. */
+// Finds the lights that affect a fragment through the light clusters
+
+#include "light.glsl"
+
+// Lights are stored in texture buffers. Each light takes six texels.
+uniform samplerBuffer ULightData;     // location 4
+// The offset and count of each cluster's lights in the index list
+uniform usamplerBuffer UClusterGrid;  // location 5
+uniform usamplerBuffer ULightIndices; // location 6
+// Values used to find the cluster of a fragment. These must match
+// LightCluster.h.
+const ivec3 ClusterCount = ivec3(16, 9, 24);
+uniform vec2 UClusterTileSize;
+uniform float UClusterDepthScale;
+uniform float UClusterDepthBias;
+
+// Reads a light from the light data buffer
+Light FetchLight(int index)
+{
+  int texel = index * 6;
+  vec4 t0 = texelFetch(ULightData, texel);
+  vec4 t1 = texelFetch(ULightData, texel + 1);
+  vec4 t2 = texelFetch(ULightData, texel + 2);
+  vec4 t3 = texelFetch(ULightData, texel + 3);
+  vec4 t4 = texelFetch(ULightData, texel + 4);
+  vec4 t5 = texelFetch(ULightData, texel + 5);
+  Light light;
+  light.UPosition = t0.xyz;
+  light.UType = int(t0.w);
+  light.UDirection = t1.xyz;
+  light.USpotExponent = t1.w;
+  light.UAmbientColor = t2.xyz;
+  light.UInnerAngle = t2.w;
+  light.UDiffuseColor = t3.xyz;
+  light.UOuterAngle = t3.w;
+  light.USpecularColor = t4.xyz;
+  light.UAttenuationC0 = t4.w;
+  light.UAttenuationC1 = t5.x;
+  light.UAttenuationC2 = t5.y;
+  return light;
+}
+
+// Finds the index of the cluster a fragment is in given the fragment's
+// distance along the view direction
+int FindCluster(float view_depth)
+{
+  int slice = int(log(view_depth) * UClusterDepthScale - UClusterDepthBias);
+  slice = clamp(slice, 0, ClusterCount.z - 1);
+  ivec2 tile = ivec2(gl_FragCoord.xy / UClusterTileSize);
+  tile = clamp(tile, ivec2(0), ClusterCount.xy - 1);
+  return tile.x + ClusterCount.x * (tile.y + ClusterCount.y * slice);
+}
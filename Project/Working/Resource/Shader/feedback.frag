@@ -0,0 +1,26 @@
+/* All content(c) 2017 - 2018 DigiPen(USA) Corporation, all rights reserved. */
+#version 330 core
+
+#include "mapping.glsl"
+
+// The log2 footprints are stored from -FEEDBACK_LOD_RANGE to 0 like
+// FeedbackBuffer.h expects
+#define FEEDBACK_LOD_RANGE 32.0
+
+in vec3 SModelPos;
+
+out vec4 OFeedback;
+
+uniform int UMappingType;
+// log2 of the screen pixels along a side of a feedback pixel
+uniform float UFeedbackScale;
+
+void main()
+{
+  vec2 uv = clamp(ComputeMappingUV(UMappingType, SModelPos), 0.0, 1.0);
+  // the feedback is smaller than the screen, so its footprints are larger
+  // than the ones the screen will see
+  float footprint = max(length(dFdx(uv)), length(dFdy(uv)));
+  float lod = log2(max(footprint, 1e-9)) - UFeedbackScale;
+  OFeedback = vec4(uv, clamp(lod / FEEDBACK_LOD_RANGE + 1.0, 0.0, 1.0), 1.0);
+}
@@ -0,0 +1,14 @@
+/* All content(c) 2017 - 2018 DigiPen(USA) Corporation, all rights reserved. */
+// Linear distance fog
+
+uniform vec3 UFogColor;
+uniform float UNearPlane;
+uniform float UFarPlane;
+
+// Blends a color towards the fog color given its distance from the camera
+vec3 ApplyFog(vec3 color, float dist)
+{
+  float fog_factor = (dist - UNearPlane) / (UFarPlane - UNearPlane);
+  fog_factor = min(1.0, max(0.0, fog_factor));
+  return mix(color, UFogColor, fog_factor);
+}
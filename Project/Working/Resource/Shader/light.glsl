@@ -0,0 +1,67 @@
+/* All content(c) 2017 - 2018 DigiPen(USA) Corporation, all rights reserved. */
+// The light structure and the parts of the lighting math that do not depend
+// on the shading model
+
+#define LIGHT_POINT 0
+#define LIGHT_DIRECTIONAL 1
+#define LIGHT_SPOT 2
+
+// Light values
+struct Light
+{
+  // The type of the type: 0 - Point, 1 - Directional, 2 - Spot
+  int UType;
+  // The position of the light
+  vec3 UPosition;
+  // The direction of the light
+  vec3 UDirection;
+  // The inner and outer angles for a spotlight
+  float UInnerAngle;
+  float UOuterAngle;
+  float USpotExponent;
+  // The light colors
+  vec3 UAmbientColor;
+  vec3 UDiffuseColor;
+  vec3 USpecularColor;
+  // Attenuation coefficients
+  float UAttenuationC0;
+  float UAttenuationC1;
+  float UAttenuationC2;
+};
+
+// Finds the vector from a position to the light. A directional light has
+// the same vector everywhere.
+vec3 LightVector(Light light, vec3 position)
+{
+  if(light.UType == LIGHT_DIRECTIONAL)
+    return -normalize(light.UDirection);
+  return light.UPosition - position;
+}
+
+// Finds how much of a spotlight reaches the light direction. Lights that are
+// not spotlights are not reduced.
+float SpotlightFactor(Light light, vec3 light_dir)
+{
+  if(light.UType != LIGHT_SPOT)
+    return 1.0;
+  float cos_inner = cos(light.UInnerAngle);
+  float cos_outer = cos(light.UOuterAngle);
+  vec3 spot_dir = -normalize(light.UDirection);
+  float ldots = dot(light_dir, spot_dir);
+  float spotlight_factor = (ldots - cos_outer) / (cos_inner - cos_outer);
+  spotlight_factor = pow(spotlight_factor, light.USpotExponent);
+  spotlight_factor = max(0.0, spotlight_factor);
+  return min(1.0, spotlight_factor);
+}
+
+// Finds the attenuation of a light over the length of the light vector
+float Attenuation(Light light, vec3 light_vec)
+{
+  if(light.UType == LIGHT_DIRECTIONAL)
+    return 1.0;
+  float light_dist = length(light_vec);
+  float attenuation = light.UAttenuationC0 +
+    light.UAttenuationC1 * light_dist +
+    light.UAttenuationC2 * light_dist * light_dist;
+  return min(1.0 / attenuation, 1.0);
+}
@@ -1,7 +1,8 @@
 /* All content(c) 2017 DigiPen(USA) Corporation, all rights reserved. */
 #version 330 core
 
-in vec3 APosition;
+// The locations match the ATTRIB defines in VertexFormat.h
+layout(location = 0) in vec3 APosition;
 
 uniform mat4 UProjection = mat4(1,0,0,0,
                                 0,1,0,0,
@@ -0,0 +1,82 @@
+/* All content(c) 2017 - 2018 DigiPen(USA) Corporation, all rights reserved. */
+// Creates texture coordinates from a position in model space
+
+#define MAP_SPHERICAL 0
+#define MAP_CYLINDRICAL 1
+#define MAP_PLANAR 2
+
+vec2 PerformPlanarMapping(vec3 direction){
+  vec3 da = abs(direction);
+  vec2 uv;
+  // X mapping
+  if(da.x > da.y && da.x > da.z){
+    if(direction.x > 0){
+      uv.x = (direction.z / da.x + 1.0) / 2.0;
+      uv.y = (direction.y / da.x + 1.0) / 2.0;
+    }
+    else{
+      uv.x = (direction.z / da.x + 1.0) / 2.0;
+      uv.y = (direction.y / da.x + 1.0) / 2.0;
+    }
+  }
+  // Y mapping
+  else if(da.y > da.x && da.y > da.z){
+    if(direction.y > 0){
+      uv.x = (direction.x / da.y + 1.0) / 2.0;
+      uv.y = (direction.z / da.y + 1.0) / 2.0;
+    }
+    else{
+      uv.x = (direction.x / da.y + 1.0) / 2.0;
+      uv.y = (direction.z / da.y + 1.0) / 2.0;
+    }
+
+  }
+  // Z mapping
+  else if(da.z > da.x && da.z > da.y){
+    if(direction.z > 0){
+      uv.x = (direction.x / da.z + 1.0) / 2.0;
+      uv.y = (direction.y / da.z + 1.0) / 2.0;
+    }
+    else{
+      uv.x = (direction.x / da.z + 1.0) / 2.0;
+      uv.y = (direction.y / da.z + 1.0) / 2.0;
+    }
+  }
+  return uv;
+}
+
+/******************************************************************************/
+/*
+  Computes the uv depending on the mapping.
+*/
+/******************************************************************************/
+vec2 ComputeMappingUV(int mapping_type, vec3 position)
+{
+  vec2 uv;
+  float pi = 3.14159265359;
+  float theta;
+  float phi;
+  switch(mapping_type)
+  {
+    // spherical mapping method
+    case MAP_SPHERICAL:
+      theta = atan(position.x, position.z);
+      phi = acos(-1.0 * position.y);
+      uv.x = (theta + pi) / (pi * 2.0);
+      uv.y = phi / pi;
+      break;
+    // cylindrical mapping method
+    case MAP_CYLINDRICAL:
+      theta = atan(position.x, position.z);
+      uv.x = (theta + pi) / (pi * 2.0);
+      uv.y = (position.y + 1.0) / 2.0;
+      break;
+    // planar mapping method
+    case MAP_PLANAR:
+      uv = PerformPlanarMapping(position);
+      break;
+    default:
+      break;
+  }
+  return uv;
+}
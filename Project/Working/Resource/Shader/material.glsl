@@ -0,0 +1,42 @@
+/* All content(c) 2017 - 2018 DigiPen(USA) Corporation, all rights reserved. */
+// The material uniform. Shaders only use some of its values and the rest
+// are not active in their programs.
+
+// Material values
+struct Material
+{
+  vec3 UColor;
+  // Material factors
+  float UAmbientFactor;
+  float UDiffuseFactor;
+  float USpecularFactor;
+  float USpecularExponent;
+  float UEnvironmentFactor;
+  float URefractionIndex;
+  bool UChromaticAbberation;
+  float UChromaticOffset;
+  bool UFresnelReflection;
+  float UFresnelRatio;
+  // texture mapping
+  bool UTextureMapping;
+  bool USpecularMapping;
+  bool UNormalMapping;
+  bool UEnvironmentMapping;
+  bool URoughReflections;
+  bool UVirtualTexturing;
+  bool UTextureArray;
+  int UMappingType;
+  // samplers
+  sampler2D UDiffuseMap;  // location 0
+  sampler2D USpecularMap; // location 1
+  sampler2D UNormalMap;   // location 2
+  samplerCube UEnvironmentMap; // location 3
+  // The diffuse, specular, and normal maps packed into one texture array.
+  // A placement is a map's uv offset and layer, and a scale is the part of
+  // the layer the map covers.
+  sampler2DArray UMapArray; // location 13
+  vec3 UMapPlacements[3];
+  vec2 UMapScales[3];
+};
+
+uniform Material UMaterial;
@@ -0,0 +1,29 @@
+#version 330 core
+
+out vec4 OFragColor;
+
+// The heights are in the red channel
+uniform sampler2D UHeightMap;
+// How much a change of one in height tilts the normals. Heights go from 0 to
+// 255 like they do in Texture::CreateNormalMap.
+uniform float UStrength;
+
+// Texels past the edges of the height map repeat the edge texel
+float HeightAt(ivec2 texel)
+{
+  ivec2 last = textureSize(UHeightMap, 0) - 1;
+  return texelFetch(UHeightMap, clamp(texel, ivec2(0), last), 0).r * 255.0;
+}
+
+void main()
+{
+  // the normal is the cross product of the slopes (1, 0, sdz) and
+  // (0, 1, tdz), which is (-sdz, -tdz, 1)
+  ivec2 texel = ivec2(gl_FragCoord.xy);
+  float nx = UStrength *
+    (HeightAt(texel - ivec2(1, 0)) - HeightAt(texel + ivec2(1, 0)));
+  float ny = UStrength *
+    (HeightAt(texel + ivec2(0, 1)) - HeightAt(texel - ivec2(0, 1)));
+  vec3 normal = normalize(vec3(nx, ny, 1.0));
+  OFragColor = vec4(normal * 0.5 + 0.5, 1.0);
+}
@@ -1,11 +1,12 @@
 /* All content(c) 2017 DigiPen(USA) Corporation, all rights reserved. */
 #version 330 core
 
-in vec3 APosition;
-in vec3 ANormal;
-in vec3 ATangent;
-in vec3 ABitangent;
-in vec2 AUV;
+// The locations match the ATTRIB defines in VertexFormat.h
+layout(location = 0) in vec3 APosition;
+layout(location = 1) in vec3 ANormal;
+layout(location = 2) in vec3 ATangent;
+layout(location = 3) in vec3 ABitangent;
+layout(location = 4) in vec2 AUV;
 
 out vec3 SNormal;
 out vec3 STangent;
@@ -14,6 +15,7 @@ out vec3 SFragPos;
 out vec3 SModelNormal;
 out vec3 SModelPos;
 out vec2 SUV;
+out float SViewDepth;
 
 uniform mat4 UProjection = mat4(1,0,0,0,
                                 0,1,0,0,
@@ -38,6 +40,7 @@ void main()
   STangent = orientation * ATangent;
   SBitangent = orientation * ABitangent;
   SFragPos = vec3(UModel * vec4(APosition, 1.0));
+  SViewDepth = -(UView * vec4(SFragPos, 1.0)).z;
   SModelPos = APosition;
   SModelNormal = ANormal;
   SUV = AUV;
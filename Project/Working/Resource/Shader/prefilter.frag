@@ -0,0 +1,79 @@
+#version 330 core
+
+#define PI 3.14159265359
+#define SAMPLECOUNT 64u
+
+in vec3 SDirection;
+
+out vec4 OFragColor;
+
+uniform samplerCube UEnvironmentMap;
+// The roughness of the GGX lobe used for this mip level
+uniform float URoughness;
+// The size of a face of the environment map at mip level 0
+uniform float USourceSize;
+
+// Low discrepancy sequence used for picking sample directions
+vec2 Hammersley(uint i)
+{
+  uint bits = i;
+  bits = (bits << 16u) | (bits >> 16u);
+  bits = ((bits & 0x55555555u) << 1u) | ((bits & 0xAAAAAAAAu) >> 1u);
+  bits = ((bits & 0x33333333u) << 2u) | ((bits & 0xCCCCCCCCu) >> 2u);
+  bits = ((bits & 0x0F0F0F0Fu) << 4u) | ((bits & 0xF0F0F0F0u) >> 4u);
+  bits = ((bits & 0x00FF00FFu) << 8u) | ((bits & 0xFF00FF00u) >> 8u);
+  float radical_inverse = float(bits) * 2.3283064365386963e-10;
+  return vec2(float(i) / float(SAMPLECOUNT), radical_inverse);
+}
+
+// Finds a half vector around the normal that is distributed according to GGX
+vec3 ImportanceSampleGGX(vec2 xi, vec3 normal, float alpha)
+{
+  float phi = 2.0 * PI * xi.x;
+  float cos_theta = sqrt((1.0 - xi.y) / (1.0 + (alpha * alpha - 1.0) * xi.y));
+  float sin_theta = sqrt(1.0 - cos_theta * cos_theta);
+  vec3 half_tangent = vec3(cos(phi) * sin_theta, sin(phi) * sin_theta, cos_theta);
+  // move from tangent space to world space
+  vec3 up = abs(normal.z) < 0.999 ? vec3(0.0, 0.0, 1.0) : vec3(1.0, 0.0, 0.0);
+  vec3 tangent = normalize(cross(up, normal));
+  vec3 bitangent = cross(normal, tangent);
+  return tangent * half_tangent.x + bitangent * half_tangent.y +
+    normal * half_tangent.z;
+}
+
+float DistributionGGX(float ndoth, float alpha)
+{
+  float alpha_2 = alpha * alpha;
+  float denominator = ndoth * ndoth * (alpha_2 - 1.0) + 1.0;
+  return alpha_2 / (PI * denominator * denominator);
+}
+
+void main()
+{
+  vec3 normal = normalize(SDirection);
+  if(URoughness == 0.0){
+    OFragColor = vec4(textureLod(UEnvironmentMap, normal, 0.0).xyz, 1.0);
+    return;
+  }
+  // the view direction is assumed to be the same as the normal
+  float alpha = URoughness * URoughness;
+  float texel_solid_angle = 4.0 * PI / (6.0 * USourceSize * USourceSize);
+  vec3 color = vec3(0.0);
+  float total_weight = 0.0;
+  for(uint i = 0u; i < SAMPLECOUNT; ++i){
+    vec3 half_dir = ImportanceSampleGGX(Hammersley(i), normal, alpha);
+    vec3 light_dir = 2.0 * dot(normal, half_dir) * half_dir - normal;
+    float ndotl = dot(normal, light_dir);
+    if(ndotl <= 0.0)
+      continue;
+    // Sample from a mip level that matches the solid angle covered by this
+    // sample. This removes the bright speckles from undersampling.
+    float ndoth = max(dot(normal, half_dir), 0.0);
+    float pdf = DistributionGGX(ndoth, alpha) / 4.0 + 0.0001;
+    float sample_solid_angle = 1.0 / (float(SAMPLECOUNT) * pdf);
+    float lod = max(0.5 * log2(sample_solid_angle / texel_solid_angle), 0.0);
+    color += textureLod(UEnvironmentMap, light_dir, lod).xyz * ndotl;
+    total_weight += ndotl;
+  }
+  OFragColor = vec4(color / total_weight, 1.0);
+}
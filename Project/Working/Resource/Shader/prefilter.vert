@@ -0,0 +1,16 @@
+#version 330 core
+
+out vec3 SDirection;
+
+// The linear part of the view matrix for the cubemap face being rendered
+uniform mat4 UView;
+
+void main()
+{
+  // a single triangle that covers the whole viewport
+  vec2 position = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2) * 2.0 - 1.0;
+  gl_Position = vec4(position, 0.0, 1.0);
+  // the view matrix is a rotation, so the transpose takes the view space
+  // direction of this fragment back to world space
+  SDirection = transpose(mat3(UView)) * vec3(position, -1.0);
+}
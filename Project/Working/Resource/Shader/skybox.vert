@@ -1,6 +1,7 @@
 #version 330 core
 
-in vec3 APosition;
+// The locations match the ATTRIB defines in VertexFormat.h
+layout(location = 0) in vec3 APosition;
 
 out vec3 SFragPos;
 
@@ -0,0 +1,10 @@
+#version 330 core
+
+in vec3 SColor;
+
+out vec4 OFragColor;
+
+void main()
+{
+  OFragColor = vec4(SColor, 1.0);
+}
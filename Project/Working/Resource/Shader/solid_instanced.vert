@@ -0,0 +1,20 @@
+#version 330 core
+
+// The locations match the ATTRIB defines in VertexFormat.h
+layout(location = 0) in vec3 APosition;
+// The model matrix is stored row major, so the rows are read in as columns
+layout(location = 5) in mat4 AModel;
+layout(location = 9) in vec3 AColor;
+
+out vec3 SColor;
+
+uniform mat4 UProjection;
+uniform mat4 UView;
+
+void main()
+{
+  // multiplying on the left undoes the transpose
+  vec4 world_position = vec4(APosition, 1.0) * AModel;
+  gl_Position = UProjection * UView * world_position;
+  SColor = AColor;
+}
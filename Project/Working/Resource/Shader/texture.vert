@@ -1,7 +1,8 @@
 #version 330 core
 
-in vec3 APosition;
-in vec2 ATexCoord;
+// The locations match the ATTRIB defines in VertexFormat.h
+layout(location = 0) in vec3 APosition;
+layout(location = 4) in vec2 ATexCoord;
 
 out vec2 STexCoord;
 
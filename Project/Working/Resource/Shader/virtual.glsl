@@ -0,0 +1,59 @@
+/* All content(c) 2017 - 2018 DigiPen(USA) Corporation, all rights reserved. */
+// Samples images that are streamed through a VirtualTexture. The page values
+// match the ones in VirtualTexture.h.
+
+#define VIRTUALPAGE_SIZE 128.0
+#define VIRTUALPAGE_BORDER 4.0
+#define VIRTUALPAGE_STORED 136.0
+
+struct VirtualTexture
+{
+  // The physical cache of pages and the table of where each page is
+  sampler2D UCache;
+  sampler2D UIndirection;
+  // The size of the full resolution image
+  vec2 USize;
+  // The number of page levels and the number of pages along a cache side
+  float ULevels;
+  float UCachePages;
+};
+
+uniform VirtualTexture UVirtualDiffuse;
+uniform VirtualTexture UVirtualSpecular;
+uniform VirtualTexture UVirtualNormal;
+
+// Levels halve and round down like mip levels
+vec2 VirtualLevelSize(vec2 size, float level)
+{
+  return max(floor(size / exp2(level)), vec2(1.0));
+}
+
+// Finds the page level the texel footprint of the uv needs. The feedback
+// shader finds the same level, so the page it asks for is the one used here.
+// Only the closest resident level is sampled, so there is no filtering
+// between levels.
+vec4 SampleVirtual(sampler2D cache, sampler2D indirection, vec2 size,
+  float levels, float cache_pages, vec2 uv)
+{
+  uv = clamp(uv, 0.0, 1.0);
+  float footprint = max(length(dFdx(uv)), length(dFdy(uv))) *
+    max(size.x, size.y);
+  float level = clamp(floor(log2(max(footprint, 1e-6))), 0.0, levels - 1.0);
+  vec2 level_size = VirtualLevelSize(size, level);
+  vec2 last_page = ceil(level_size / VIRTUALPAGE_SIZE) - 1.0;
+  vec2 page = min(floor(uv * level_size / VIRTUALPAGE_SIZE), last_page);
+  // r and g are the cache slot and b is the level held by the slot, which
+  // is coarser than the wanted level when that page is not resident
+  vec4 entry = floor(texelFetch(indirection, ivec2(page), int(level)) *
+    255.0 + 0.5);
+  vec2 resident_size = VirtualLevelSize(size, entry.z);
+  vec2 position = uv * resident_size;
+  vec2 resident_page = min(floor(position / VIRTUALPAGE_SIZE),
+    ceil(resident_size / VIRTUALPAGE_SIZE) - 1.0);
+  vec2 texel = entry.xy * VIRTUALPAGE_STORED + VIRTUALPAGE_BORDER +
+    position - resident_page * VIRTUALPAGE_SIZE;
+  return textureLod(cache, texel / (cache_pages * VIRTUALPAGE_STORED), 0.0);
+}
+
+// Samples a VirtualTexture uniform
+#define SAMPLE_VIRTUAL(vt, uv) SampleVirtual(vt.UCache, vt.UIndirection, vt.USize, vt.ULevels, vt.UCachePages, uv)